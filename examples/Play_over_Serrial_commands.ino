@@ -13,11 +13,9 @@
   Then you can trigger the different actions by entering numbers 1 - 9 in the serial monitor.
   The sound system supports 3 channels which can be controlled separately in the volume.
 
-  The files to be played must be:
-  aiff format,
-  PCM signed 8 bit,
-  22050 sample / sec
-  stored in the SPIFF
+  The files to be played must be stored in the SPIFF.
+  The files of the "data" folder are RAW files: PCM signed 8 bit, 22050 sample / sec.
+  AIFF, AIFC and WAVE files with PCM or IMA-ADPCM can also be played.
 
   Pin assignment of the DAC:
   BCK = 26
@@ -28,9 +26,21 @@
 #include "SPIFFS.h"
 #include "ESP32_MAS.h"
 
-ESP32_MAS Audio;
+ESP32_MAS<> Audio; // 3 channels, ESP32_MAS<8> for 8 channels
 bool up = true;
-float pitch = 0;
+int rpm = 250;
+const char *layers[] = {"/E_engine1.aiff", "/E_engine2.aiff", "/E_engine3.aiff", "/E_engine4.aiff",
+                        "/E_engine5.aiff", "/E_engine6.aiff", "/E_engine7.aiff", "/E_engine8.aiff"
+                       };
+//The sounds are registered once, the index in the table is the id of the sound.
+const char *const sounds[] = {"/makrofon.aiff", "/makrofon_in.aiff", "/makrofon_loop.aiff",
+                              "/makrofon_out.aiff"
+                             };
+enum {HORN, HORN_IN, HORN_LOOP, HORN_OUT};
+const char *const states[] = {"STOP", "BRAKE", "PLAY", "LOOP", "RUN", "OUT"};
+MAS_Voice_Handle horn;
+MAS_Channel_Info info[3];
+MAS_Stats stats;
 
 void setup() {
   Serial.begin(115200);
@@ -41,6 +51,19 @@ void setup() {
     Serial.println("SPIFFS Mount Failed");
   }
   delay(500);
+  Audio.setCache(98304); // the 8 engine layers need 81822 bytes
+  for (int i = 0; i < 8; i++) {
+    //The engine layers E_engine1 - E_engine8 are recorded at 250 - 2000 rpm.
+    Audio.addLayer(0, layers[i], (i + 1) * 250);
+  }
+  Audio.preloadFile("/E_engine0.aiff");
+  Audio.setSounds(sounds, 4);
+  Audio.setEnvelope(2, 30, 100, 200, 300); //The horn on channel 2 swells in and dies away.
+  Audio.setBus(0, 1); //The engine on channel 0 is on bus 1, the horns on bus 0.
+  Audio.setPan(2, 40); //With Audio.setStereo(true) before startDAC the horn sounds right.
+  Audio.setBusFilter(1, 0, MAS_FILTER_LOWSHELF, 150, 0.7071, 6); //More rumble of the engine.
+  Audio.setLimiter(250, 200); //Three loud channels do not clip.
+  Audio.setRPM(0, rpm);
   Audio.startDAC();
   Serial.println("DAC and Setup redy");
 }
@@ -50,29 +73,46 @@ void loop() {
   uint8_t income = Serial.read();
   switch (income) {
     case 48:
-      //This section responds to the entry "0". You get the state of all 3 channels as outputin the serrial monitor.
-      for (int i = 0; i < 3; i++) {
-        String Channel;
-        uint8_t Gain;
-        float Pitch;
-        Channel = Audio.getChan(i);
+      //This section responds to the entry "0". You get the state of all channels as outputin the serrial monitor.
+      Audio.getStates(info);
+      for (int i = 0; i < Audio.getChannels(); i++) {
         Serial.print("Channel: ");
         Serial.print(i);
         Serial.print(" too: ");
-        Serial.print(Channel);
-        Gain = Audio.getGain(i);
+        Serial.print(states[info[i].state]);
         Serial.print(" Gain: ");
-        Serial.print(Gain);
-        Pitch = Audio.getPitch(i);
+        Serial.print(info[i].gain);
         Serial.print(" Pitch: ");
-        Serial.println(Pitch);
+        Serial.println(info[i].pitch);
+      }
+      Serial.print("Load: ");
+      Serial.print(Audio.getLoad());
+      Serial.print(" % Render max: ");
+      Serial.print(Audio.getRenderMax());
+      Serial.println(" us");
+      if (Audio.getStats(&stats)) {
+        Serial.print("Late blocks: ");
+        Serial.print(stats.late);
+        Serial.print(" Underruns: ");
+        Serial.print(stats.underrun);
+        Serial.print(" Voices max: ");
+        Serial.print(stats.stage[MAS_STAGE_VOICE].max / (stats.cycle_rate / 1000000));
+        Serial.print(" us Skipped: ");
+        Serial.print(stats.skipped);
+        Serial.print(" Idle: ");
+        Serial.println(stats.idle);
       }
       break;
     case 49:
-      //This section responds to the entry "1". It starts a file which plays the sound of a train horn and stops automatically.
+      //This section responds to the entry "1". In 250 ms it starts a file which plays the sound of a train horn and stops automatically.
+      //The gain and the file are sent in one batch and take effect at the same sample.
+      Audio.beginBatch();
+      Audio.scheduleAt(Audio.getClock() + 5513);
       Audio.setGain(1, 150);
-      Audio.playFile(1, "/makrofon.aiff");
-      Serial.println("Play /makrofon.aiff");
+      horn = Audio.playSound(1, HORN);
+      Audio.scheduleNow();
+      Audio.sendBatch();
+      Serial.println("Play /makrofon.aiff in 250 ms");
       break;
     case 50:
       //This section responds to the entry "2". Starts the loop on channel 0 with the quiet sound of an ICE 2.
@@ -81,10 +121,10 @@ void loop() {
       Serial.println("Loop /E_engine0.aiff");
       break;
     case 51:
-      //This section responds to the entry "3". Starts the loop on channel 0 with the approach sound of an ICE 2.
+      //This section responds to the entry "3". Starts the engine on channel 0, it follows the rpm of loop().
       Audio.setGain(0, 150);
-      Audio.loopFile(0, "/E_engine1.aiff");
-      Serial.println("Loop /E_engine1.aiff");
+      Audio.startEngine(0);
+      Serial.println("Engine channel 0");
       break;
     case 52:
       //This section responds to the entry "4". Lets the loop run out of channel "0".
@@ -92,45 +132,48 @@ void loop() {
       Serial.println("Loop channel 0 run out.");
       break;
     case 53:
-      //This section responds to the entry "5"
-      Audio.outChan(0);
-      Serial.println("Loop channel 0 run out.");
+      //This section responds to the entry "5". Starts the horn on channel 2 and holds it in a loop.
+      Audio.setGain(2, 150);
+      Audio.playSound(2, HORN_IN);
+      Audio.queueSound(2, HORN_LOOP, true);
+      Serial.println("Queue /makrofon_in.aiff /makrofon_loop.aiff");
       break;
     case 54:
-      //This section responds to the entry "6"
-      Audio.outChan(0);
-      Serial.println("Loop channel 0 run out.");
+      //This section responds to the entry "6". Ends the loop of channel 2 with the end of the horn.
+      Audio.queueSound(2, HORN_OUT, false);
+      Serial.println("Queue /makrofon_out.aiff");
       break;
     case 55:
-      //This section responds to the entry "7"
-      Audio.outChan(0);
-      Serial.println("Loop channel 0 run out.");
+      //This section responds to the entry "7". Stops the horn of entry "1" if it still plays.
+      if (Audio.stopVoice(horn)) {
+        Serial.println("Horn stopped");
+      }
       break;
     case 56:
-      //This section responds to the entry "8"
-      Audio.outChan(0);
-      Serial.println("Loop channel 0 run out.");
+      //This section responds to the entry "8". Fades the engine bus to a quiet idle in 200 ms.
+      Audio.rampBusGain(1, 40, 200);
+      Serial.println("Fade bus 1");
       break;
     case 57:
-      //This section responds to the entry "9"
-      Audio.outChan(0);
-      Serial.println("Loop channel 0 run out.");
+      //This section responds to the entry "9". Ends the horn of entry "5" with its release.
+      Audio.releaseChan(2);
+      Serial.println("Release channel 2");
       break;
   }
-  //This section continuously changes the abscissa rate of channel 0.
+  //This section continuously changes the rpm of the engine on channel 0.
   if (up) {
-    pitch = pitch + 0.01;
+    rpm = rpm + 20;
   }
   else {
-    pitch = pitch - 0.01;
+    rpm = rpm - 20;
   }
-  if (pitch > 1) {
+  if (rpm > 2000) {
     up = false;
   }
-  if (pitch < 0) {
+  if (rpm < 250) {
     up = true;
   }
-  Audio.setPitch(0, pitch);
+  Audio.setRPM(0, rpm);
   vTaskDelay(100);
 }
 
@@ -0,0 +1,713 @@
+/*MAS_Bench
+  Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Host benchmark of the ESP32_MAS. Every scene is rendered by renderOffline, the same
+  Player_Block and reader code as the audio tasks, into an output that drops the samples.
+
+  decode/<file>      decoder of every sound file of the directory (.aiff .aifc .aif .wav .raw),
+                     ns per decoded sample
+  format/<file>      decoder of every fixture of -f (extras/MAS_Test/data), one file per
+                     format and variant: PCM 8 and 16 bit, stereo, AIFF, AIFC, WAVE, IMA ADPCM
+  pitch/<speed>      one looped voice from the sample cache at speed 0.5 - 4, LINEAR
+  interp/<mode>      one looped voice at speed 1.3, NONE, LINEAR, CUBIC, BOX
+  mix/<voices>       1 - 16 looped voices from the sample cache at normal speed
+  stereo/<voices>    the voices of mix/<voices> in stereo, every voice at another pan
+  bus/<voices>       the voices of stereo/<voices> on 4 buses below 0 dB
+  active/<voices>    16 looped voices from a 1 MB sample cache, 1 - 16 of them at a gain above 0,
+                     the others are not mixed
+  loop/wrap          one voice of the shortest file at speed 4, the loop wraps every block
+  stream/<voices>    voices played from the file system by the reader, end to end
+  cache/<voices>     1 or 3 pitched loops from the sample cache
+  file/<voices>      the same loops read from the file system, the cost without the cache
+  worst/<voices>     all voices pitched, all looping the shortest files, CUBIC, stereo
+  engine/<voices>    engine voices of the 8 shortest files as layers at 1000 - 8000 rpm, each at
+                     another rpm between two layers, engine/1_layer one voice below the first
+  trigger/<source>   playFile and the first block of 256 samples, the files by turns, from the
+                     sample cache, the file system and with -k from a sound bank (see MAS_Pack),
+                     us/block is the time from the trigger to the first block
+  control/<call>     control call of the class without render, the ns/sample column is ns per
+                     call: playSound, playFile (String), setGain, getState, getChan (String),
+                     getStates
+  inserts/<voices>   the voices of bus/<voices> with a high pass on every channel, a peak on
+                     every bus, a low shelf and a high shelf on the master and the limiter
+  filter/<kernel>    biquad of MAS_Filter.h on blocks of 256 samples, biquad on the 32 bit
+                     sums, biquad16 on 16 bit samples, chain of MAS_FILTERS biquads
+  limiter/<channels> look-ahead limiter on blocks of 256 samples, mono and stereo, always
+                     limiting
+  kernel/<name>      mixing kernel of MAS_Mixer.h on blocks of 256 samples, add, ramp, bus,
+                     out and stereo, kernel/<name>_ref its scalar reference
+  The time is the best of the repeats, reported as ns per output sample (per decoded sample
+  for decode), us per block of 256 samples and realtime factor (audio time / render time).
+  With -c the clock of the CPU in MHz the report adds cycles per sample.
+
+  Build (Linux, macOS):
+  g++ -O2 -pthread -I src extras/MAS_Bench/MAS_Bench.cpp src/ESP32_MAS.cpp src/MAS_Bank.cpp
+      src/MAS_Decoder.cpp src/MAS_Engine.cpp src/MAS_Filter.cpp src/MAS_Mixer.cpp
+      src/MAS_Platform.cpp src/MAS_Ramp.cpp -o mas_bench
+  Use:
+  mas_bench [-d directory] [-r repeats] [-s save_file] [-b baseline_file] [-t tolerance %]
+            [-c MHz] [-k bank] [-f fixtures]
+  bank = sound bank of the files in the directory, like openBank, for example
+  mas_pack examples/data examples/data/sounds.bin
+  mas_bench -d examples/data -k sounds.bin
+  Example, before and after a change on the same machine:
+  mas_bench -d examples/data -s baseline.txt
+  mas_bench -d examples/data -b baseline.txt -t 10
+  With a baseline every scene slower than the baseline + tolerance fails, and every scene of
+  the baseline that did not run, the exit code is 1. Scenes not in the baseline are reported
+  as new. The baseline file has one line per scene: name ns_per_sample, lines of # are
+  comments (-s writes the options of the run).
+  extras/MAS_Bench/baseline.txt is a baseline of all scenes, run from the root of the library
+  with the bank of examples/data. Its times are of the machine of its comment, on another
+  machine save a baseline before a change. The asan run of run_tests.sh checks that the scenes
+  of the baseline run.
+  -------------------------------------------------------------------------------------------*/
+#include <dirent.h>
+#include <strings.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include "ESP32_MAS.h"
+#include "MAS_Decoder.h"
+#include "MAS_Engine.h"
+#include "MAS_Filter.h"
+#include "MAS_Mixer.h"
+
+#define BENCH_VOICES 16
+
+//-------------------------------------------------------------------------------null output
+class Bench_Output : public MAS_Output {
+  public:
+    bool begin(uint32_t rate, uint16_t block, uint8_t count, uint8_t channels) {
+      return true;
+    };
+    uint8_t wait() {
+      return 0;
+    };
+    bool write(const int16_t *buf, uint16_t len) {
+      Sum += buf[len - 1]; // the samples are used
+      return true;
+    };
+    int32_t Sum = 0;
+};
+
+typedef ESP32_MAS<BENCH_VOICES> Bench_MAS;
+typedef void (*Bench_Setup)(Bench_MAS *audio, const std::vector<std::string> &files, int arg);
+
+struct Bench_Result {
+  std::string name;
+  double ns; // per sample
+  double realtime;
+};
+
+static double Now() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch())
+         .count();
+}
+//---------------------------------------------------------------------------------render scene
+// Best time of repeats renders of seconds audio after a warm up block.
+static Bench_Result Render_Scene(const char *name, Bench_Setup setup,
+                                 const std::vector<std::string> &files, int arg, float seconds,
+                                 int repeats) {
+  Bench_Result result;
+  double best = 1e9;
+  uint32_t frames = 0;
+  for (int r = 0; r < repeats; r++) {
+    Bench_MAS *audio = new Bench_MAS;
+    Bench_Output output;
+    audio->setOutput(&output);
+    setup(audio, files, arg);
+    audio->renderOffline(0.01f);
+    double start = Now();
+    frames = audio->renderOffline(seconds);
+    double time = Now() - start;
+    best = time < best ? time : best;
+    delete audio;
+  }
+  result.name = name;
+  result.ns = best * 1e9 / frames;
+  result.realtime = frames / 22050.0 / best;
+  return result;
+}//                                                                              render scene
+//-------------------------------------------------------------------------------------scenes
+static float Bench_Speed[] = {0.5f, 0.75f, 1.0f, 1.5f, 2.0f, 4.0f};
+
+static void Setup_Pitch(Bench_MAS *audio, const std::vector<std::string> &files, int arg) {
+  audio->preloadFile(files[0].c_str());
+  audio->setPitch(0, Bench_Speed[arg] - 1);
+  audio->loopFile(0, files[0].c_str());
+}
+static void Setup_Interp(Bench_MAS *audio, const std::vector<std::string> &files, int arg) {
+  audio->setInterpolation(arg);
+  audio->preloadFile(files[0].c_str());
+  audio->setPitch(0, 0.3f);
+  audio->loopFile(0, files[0].c_str());
+}
+static void Setup_Mix(Bench_MAS *audio, const std::vector<std::string> &files, int arg) {
+  for (int h = 0; h < arg; h++) {
+    const char *file = files[h % files.size()].c_str();
+    audio->preloadFile(file);
+    audio->setGain(h, 255 / arg);
+    audio->loopFile(h, file);
+  }
+}
+// arg = voices, negative = on buses
+static void Setup_Stereo(Bench_MAS *audio, const std::vector<std::string> &files, int arg) {
+  int voices = arg < 0 ? -arg : arg;
+  audio->setStereo(true);
+  Setup_Mix(audio, files, voices);
+  for (int h = 0; h < voices; h++) {
+    audio->setPan(h, -120 + 240 * h / BENCH_VOICES);
+    if (arg < 0) {
+      audio->setBus(h, h % MAS_BUSES);
+      audio->setBusGain(h % MAS_BUSES, 200);
+    }
+  }
+}
+static void Setup_Inserts(Bench_MAS *audio, const std::vector<std::string> &files, int arg) {
+  Setup_Stereo(audio, files, -arg);
+  for (int h = 0; h < arg; h++) {
+    audio->setFilter(h, 0, MAS_FILTER_HIGHPASS, 80, 0.7071f, 0);
+  }
+  for (int b = 0; b < MAS_BUSES; b++) {
+    audio->setBusFilter(b, 0, MAS_FILTER_PEAK, 1000 + 500 * b, 2, -6);
+  }
+  audio->setMasterFilter(0, MAS_FILTER_LOWSHELF, 200, 0.7071f, 3);
+  audio->setMasterFilter(1, MAS_FILTER_HIGHSHELF, 6000, 0.7071f, -3);
+  audio->setLimiter(200, 2205);
+}
+static void Setup_Active(Bench_MAS *audio, const std::vector<std::string> &files, int arg) {
+  audio->setCache(1 << 20);
+  for (int h = 0; h < BENCH_VOICES; h++) {
+    const char *file = files[h % files.size()].c_str();
+    audio->preloadFile(file);
+    audio->setGain(h, h < arg ? 255 / arg : 0);
+    audio->loopFile(h, file);
+  }
+}
+// files are sorted by length, files[0] is the shortest
+static void Setup_Wrap(Bench_MAS *audio, const std::vector<std::string> &files, int arg) {
+  audio->preloadFile(files[0].c_str());
+  audio->setPitch(0, 3);
+  audio->loopFile(0, files[0].c_str());
+}
+// the longest files, every voice pitched
+static void Setup_File(Bench_MAS *audio, const std::vector<std::string> &files, int arg) {
+  for (int h = 0; h < arg; h++) {
+    audio->setGain(h, 255 / arg);
+    audio->setPitch(h, 0.2f + 0.3f * h);
+    audio->loopFile(h, files[files.size() - 1 - h].c_str());
+  }
+}
+static void Setup_Stream(Bench_MAS *audio, const std::vector<std::string> &files, int arg) {
+  for (int h = 0; h < arg; h++) {
+    audio->setGain(h, 255 / arg);
+    audio->loopFile(h, files[h % files.size()].c_str());
+  }
+}
+static void Setup_Cache(Bench_MAS *audio, const std::vector<std::string> &files, int arg) {
+  for (int h = 0; h < arg; h++) {
+    audio->preloadFile(files[files.size() - 1 - h].c_str());
+  }
+  Setup_File(audio, files, arg);
+}
+static void Setup_Worst(Bench_MAS *audio, const std::vector<std::string> &files, int arg) {
+  int shortest = files.size() < 4 ? files.size() : 4;
+  audio->setStereo(true);
+  audio->setInterpolation(2);
+  for (int i = 0; i < shortest; i++) {
+    audio->preloadFile(files[i].c_str());
+  }
+  for (int h = 0; h < arg; h++) {
+    const char *file = files[h % shortest].c_str();
+    audio->setGain(h, 255 / arg);
+    audio->setPitch(h, -0.4f + 0.23f * h);
+    audio->setPan(h, -120 + 15 * h);
+    audio->loopFile(h, file);
+  }
+}
+// arg = engine voices, 0 = one voice playing its first layer alone
+static void Setup_Engine(Bench_MAS *audio, const std::vector<std::string> &files, int arg) {
+  int layers = files.size() < MAS_ENGINE_LAYERS ? files.size() : MAS_ENGINE_LAYERS;
+  audio->setCache(1 << 20);
+  for (int h = 0; h < (arg > 0 ? arg : 1); h++) {
+    for (int k = 0; k < layers; k++) {
+      audio->addLayer(h, files[k].c_str(), 1000 * (k + 1));
+    }
+    audio->setGain(h, arg > 0 ? 255 / arg : 255);
+    audio->setRPM(h, arg > 0 ? 1500 + 1700 * h : 500);
+    audio->startEngine(h);
+  }
+}//                                                                                    scenes
+//-------------------------------------------------------------------------------------decode
+// scene = "decode" or "format"
+static Bench_Result Decode_File(const char *scene, const std::string &name, int repeats) {
+  Bench_Result result;
+  MAS_File file;
+  MAS_Format format;
+  result.name = scene + name;
+  result.ns = 0;
+  result.realtime = 0;
+  if (!file.open(name.c_str()) || !MAS_Read_Format(&file, &format)) {
+    return result;
+  }
+  std::vector<uint8_t> data(format.data_len);
+  int len = file.read(data.data(), format.data_len);
+  file.close();
+  std::vector<int16_t> samples(format.decoder->samples(&format, len) + 1);
+  double best = 1e9;
+  int count = 0;
+  for (int r = 0; r < repeats; r++) {
+    double start = Now();
+    for (int i = 0; i < 200; i++) {
+      count = format.decoder->decode(&format, data.data(), len, samples.data());
+    }
+    double time = Now() - start;
+    best = time < best ? time : best;
+  }
+  result.ns = count > 0 ? best * 1e9 / (200.0 * count) : 0;
+  result.realtime = count > 0 ? 200.0 * count / format.rate / best : 0;
+  return result;
+}//                                                                                    decode
+//------------------------------------------------------------------------------------trigger
+// source 0 = sound bank, 1 = sample cache, 2 = file system.
+static Bench_Result Trigger(int source, const std::vector<std::string> &files, const char *bank,
+                            int repeats) {
+  static const char *const names[] = {"trigger/bank", "trigger/cache", "trigger/file"};
+  Bench_Result result;
+  double best = 1e9;
+  uint32_t frames = 0;
+  for (int r = 0; r < repeats; r++) {
+    Bench_MAS *audio = new Bench_MAS;
+    Bench_Output output;
+    audio->setOutput(&output);
+    audio->setBuffer(256, 4);
+    audio->setCache(4 << 20);
+    if (source == 0 && !audio->openBank(bank)) {
+      fprintf(stderr, "can not open the bank %s\n", bank);
+    }
+    for (size_t i = 0; i < files.size() && source < 2; i++) {
+      if (!audio->preloadFile(files[i].c_str())) { // in the bank: nothing is copied
+        fprintf(stderr, "%s: %s not in memory\n", names[source], files[i].c_str());
+      }
+    }
+    audio->renderOffline(0.01f);
+    frames = 0;
+    double start = Now();
+    for (int t = 0; t < 200; t++) {
+      audio->playFile(0, files[t % files.size()].c_str());
+      frames += audio->renderOffline(256 / 22050.0f);
+    }
+    double time = Now() - start;
+    best = time < best ? time : best;
+    delete audio;
+  }
+  result.name = names[source];
+  result.ns = best * 1e9 / frames;
+  result.realtime = frames / 22050.0 / best;
+  return result;
+}//                                                                                   trigger
+//------------------------------------------------------------------------------------control
+// call 0 - 5, see the names. The commands are taken between the timed runs of 32 calls.
+static Bench_Result Control(int call, const std::vector<std::string> &files, int repeats) {
+  static const char *const names[] = {"control/playSound", "control/playFile", "control/setGain",
+                                      "control/getState", "control/getChan", "control/getStates"
+                                     };
+  Bench_Result result;
+  MAS_Channel_Info info[BENCH_VOICES];
+  String file = files[0].c_str();
+  uint32_t sum = 0;
+  double best = 1e9;
+  for (int r = 0; r < repeats; r++) {
+    Bench_MAS *audio = new Bench_MAS;
+    Bench_Output output;
+    audio->setOutput(&output);
+    audio->preloadFile(file);
+    MAS_Sound_Id sound = audio->addSound(files[0].c_str());
+    audio->loopSound(0, sound);
+    audio->renderOffline(0.01f);
+    double time = 0;
+    for (int run = 0; run < 200; run++) {
+      double start = Now();
+      for (int i = 0; i < 32; i++) {
+        uint8_t h = i % BENCH_VOICES;
+        switch (call) {
+          case 0:
+            sum += audio->playSound(h, sound).channel;
+            break;
+          case 1:
+            audio->playFile(h, file);
+            break;
+          case 2:
+            audio->setGain(h, i);
+            break;
+          case 3:
+            sum += audio->getState(h);
+            break;
+          case 4:
+            sum += audio->getChan(h).length();
+            break;
+          default:
+            audio->getStates(info);
+            sum += info[h].state;
+        }
+      }
+      time += Now() - start;
+      audio->renderOffline(0.001f);
+    }
+    best = time < best ? time : best;
+    delete audio;
+  }
+  result.name = names[call];
+  result.ns = best * 1e9 / (200.0 * 32) + (sum == 0xFFFFFFFF); // the results are used
+  result.realtime = 0;
+  return result;
+}//                                                                                   control
+//-------------------------------------------------------------------------------------filter
+// kernel 0 = biquad, 1 = biquad16, 2 = chain, 3 = limiter mono, 4 = limiter stereo.
+static Bench_Result Filter_Kernel(int kernel, int repeats) {
+  static const char *const names[] = {"filter/biquad", "filter/biquad16", "filter/chain",
+                                      "limiter/mono", "limiter/stereo"
+                                     };
+  Bench_Result result;
+  std::vector<int16_t> in16(256), buf16(256);
+  std::vector<int32_t> in(512), buf(512);
+  for (int i = 0; i < 512; i++) {
+    in[i] = ((i * 997) % 65536 - 32768) * (1 << MAS_MIX_FRAC);
+    in16[i % 256] = (i * 997) % 65536 - 32768;
+  }
+  MAS_Biquad chain[MAS_FILTERS];
+  MAS_Filter_Set set;
+  set.type = MAS_FILTER_PEAK;
+  set.gain = 6;
+  for (int f = 0; f < MAS_FILTERS; f++) {
+    set.freq = 500 + 1000 * f;
+    MAS_Biquad_Set(&chain[f], &set, 22050);
+  }
+  MAS_Limiter limiter;
+  MAS_Limiter_Set(&limiter, 64, 2205); // the loud input is always limited
+  double best = 1e9;
+  for (int r = 0; r < repeats; r++) {
+    double start = Now();
+    for (int b = 0; b < 20000; b++) {
+      buf = in;
+      buf16 = in16;
+      switch (kernel) {
+        case 0:
+          MAS_Biquad_Run(&chain[0], buf.data(), 256);
+          break;
+        case 1:
+          MAS_Biquad_Run16(&chain[0], buf16.data(), 256);
+          break;
+        case 2:
+          MAS_Filter_Chain(chain, buf.data(), 256);
+          break;
+        case 3:
+          MAS_Limiter_Run(&limiter, buf.data(), NULL, 256);
+          break;
+        default:
+          MAS_Limiter_Run(&limiter, buf.data(), buf.data() + 256, 256);
+      }
+      chain[1].x2 ^= buf[b & 255] ^ buf16[b & 255]; // the results are used
+    }
+    double time = Now() - start;
+    best = time < best ? time : best;
+  }
+  result.name = names[kernel];
+  result.ns = best * 1e9 / (20000.0 * 256);
+  result.realtime = 20000.0 * 256 / 22050 / best;
+  return result;
+}//                                                                                    filter
+//-------------------------------------------------------------------------------------kernel
+// kernel 0 = add, 1 = ramp, 2 = bus, 3 = out, 4 = stereo, ref = scalar reference.
+static Bench_Result Mix_Kernel(int kernel, bool ref, int repeats) {
+  static const char *const names[] = {"add", "ramp", "bus", "out", "stereo"};
+  Bench_Result result;
+  std::vector<int16_t> in(256), out(512);
+  std::vector<int32_t> acc(256), bus(256);
+  for (int i = 0; i < 256; i++) {
+    in[i] = (i * 997) % 65536 - 32768;
+    bus[i] = in[i] * 100;
+  }
+  double best = 1e9;
+  for (int r = 0; r < repeats; r++) {
+    double start = Now();
+    for (int b = 0; b < 20000; b++) {
+      int32_t gain = 16384 + (b & 255);
+      if ((b & 63) == 0) {
+        MAS_Mix_Clear(acc.data(), 256); // no overflow of the accumulator
+      }
+      switch (kernel) {
+        case 0:
+          (ref ? MAS_Mix_Add_Ref : MAS_Mix_Add)(acc.data(), in.data(), gain, 256);
+          break;
+        case 1:
+          (ref ? MAS_Mix_Ramp_Ref : MAS_Mix_Ramp)(acc.data(), in.data(), gain, 32768 - gain, 256);
+          break;
+        case 2:
+          (ref ? MAS_Mix_Bus_Ref : MAS_Mix_Bus)(acc.data(), bus.data(), gain, 32768 - gain, 256);
+          break;
+        case 3:
+          (ref ? MAS_Mix_Out_Ref : MAS_Mix_Out)(acc.data(), out.data(), 256);
+          break;
+        default:
+          (ref ? MAS_Mix_Out_Stereo_Ref : MAS_Mix_Out_Stereo)(acc.data(), bus.data(), out.data(),
+                                                              256);
+      }
+      acc[b & 255] ^= out[b & 255]; // the results are used
+    }
+    double time = Now() - start;
+    best = time < best ? time : best;
+  }
+  result.name = std::string("kernel/") + names[kernel] + (ref ? "_ref" : "");
+  result.ns = best * 1e9 / (20000.0 * 256);
+  result.realtime = 20000.0 * 256 / 22050 / best;
+  return result;
+}//                                                                                    kernel
+//-----------------------------------------------------------------------------------baseline
+static bool Read_Baseline(const char *name, std::map<std::string, double> *baseline) {
+  FILE *file = fopen(name, "r");
+  char scene[128];
+  double ns;
+  if (file == NULL) {
+    return false;
+  }
+  char line[256];
+  while (fgets(line, sizeof(line), file) != NULL) {
+    if (line[0] != '#' && sscanf(line, "%127s %lf", scene, &ns) == 2) {
+      (*baseline)[scene] = ns;
+    }
+  }
+  fclose(file);
+  return true;
+}//                                                                                  baseline
+//---------------------------------------------------------------------------------------files
+// true for .aiff .aifc .aif .wav .raw, not for a bank or the .ref samples of the fixtures.
+static bool Sound_Name(const char *name) {
+  static const char *const types[] = {".aiff", ".aifc", ".aif", ".wav", ".raw"};
+  const char *type = strrchr(name, '.');
+  for (const char *sound : types) {
+    if (type != NULL && strcasecmp(type, sound) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+// Sound files of the directory sorted by length, shortest first, the root is the directory.
+static std::vector<std::string> Sound_Files(const char *dir_name) {
+  std::vector<std::string> files;
+  DIR *dir = opendir(dir_name);
+  if (dir == NULL) {
+    return files;
+  }
+  MAS_Set_Root(dir_name);
+  std::vector<std::pair<uint32_t, std::string> > sorted;
+  for (struct dirent *item = readdir(dir); item != NULL; item = readdir(dir)) {
+    MAS_File file;
+    MAS_Format format;
+    std::string name = std::string("/") + item->d_name;
+    if (item->d_name[0] != '.' && Sound_Name(item->d_name) && name.size() < MAS_NAME_SIZE &&
+        file.open(name.c_str()) && MAS_Read_Format(&file, &format)) {
+      sorted.push_back(std::make_pair(format.decoder->samples(&format, format.data_len), name));
+    }
+  }
+  closedir(dir);
+  std::sort(sorted.begin(), sorted.end());
+  for (size_t i = 0; i < sorted.size(); i++) {
+    files.push_back(sorted[i].second);
+  }
+  return files;
+}//                                                                                     files
+
+int main(int argc, char **argv) {
+  const char *dir_name = "examples/data";
+  const char *save = NULL;
+  const char *base = NULL;
+  const char *bank = NULL;
+  const char *fixtures = "extras/MAS_Test/data";
+  double tolerance = 10;
+  double mhz = 0;
+  int repeats = 9;
+  for (int a = 1; a + 1 < argc; a += 2) {
+    //--------------------------------------------------------------------------------options
+    if (strcmp(argv[a], "-d") == 0) {
+      dir_name = argv[a + 1];
+    }
+    else if (strcmp(argv[a], "-s") == 0) {
+      save = argv[a + 1];
+    }
+    else if (strcmp(argv[a], "-b") == 0) {
+      base = argv[a + 1];
+    }
+    else if (strcmp(argv[a], "-t") == 0) {
+      tolerance = atof(argv[a + 1]);
+    }
+    else if (strcmp(argv[a], "-c") == 0) {
+      mhz = atof(argv[a + 1]);
+    }
+    else if (strcmp(argv[a], "-k") == 0) {
+      bank = argv[a + 1];
+    }
+    else if (strcmp(argv[a], "-f") == 0) {
+      fixtures = argv[a + 1];
+    }
+    else if (strcmp(argv[a], "-r") == 0) {
+      repeats = atoi(argv[a + 1]) > 0 ? atoi(argv[a + 1]) : 1;
+    }
+    else {
+      argc = 0;
+    }
+  }
+  if (argc % 2 == 0) {
+    fprintf(stderr, "use: mas_bench [-d directory] [-r repeats] [-s save_file] [-b baseline_file]"
+            " [-t tolerance %%] [-c MHz] [-k bank] [-f fixtures]\n");
+    return 2;
+  }
+  //--------------------------------------------------------------------files by their length
+  std::vector<std::string> formats = Sound_Files(fixtures);
+  std::vector<std::string> files = Sound_Files(dir_name);
+  if (files.empty()) {
+    fprintf(stderr, "no sound files in %s\n", dir_name);
+    return 2;
+  }
+  //--------------------------------------------------------------------------------run scenes
+  std::vector<Bench_Result> results;
+  char name[64];
+  for (size_t i = 0; i < files.size(); i++) {
+    results.push_back(Decode_File("decode", files[i], repeats));
+  }
+  MAS_Set_Root(fixtures);
+  for (size_t i = 0; i < formats.size(); i++) {
+    results.push_back(Decode_File("format", formats[i], repeats));
+  }
+  MAS_Set_Root(dir_name);
+  for (int s = 0; s < 6; s++) {
+    snprintf(name, sizeof(name), "pitch/%.2f", Bench_Speed[s]);
+    results.push_back(Render_Scene(name, Setup_Pitch, files, s, 30, repeats));
+  }
+  const char *modes[] = {"none", "linear", "cubic", "box"};
+  for (int m = 0; m < 4; m++) {
+    snprintf(name, sizeof(name), "interp/%s", modes[m]);
+    results.push_back(Render_Scene(name, Setup_Interp, files, m, 30, repeats));
+  }
+  for (int v = 1; v <= BENCH_VOICES; v *= 2) {
+    snprintf(name, sizeof(name), "mix/%d", v);
+    results.push_back(Render_Scene(name, Setup_Mix, files, v, 30, repeats));
+  }
+  for (int v = 1; v <= BENCH_VOICES; v *= 2) {
+    snprintf(name, sizeof(name), "stereo/%d", v);
+    results.push_back(Render_Scene(name, Setup_Stereo, files, v, 30, repeats));
+  }
+  for (int v = 4; v <= BENCH_VOICES; v *= 4) {
+    snprintf(name, sizeof(name), "bus/%d", v);
+    results.push_back(Render_Scene(name, Setup_Stereo, files, -v, 30, repeats));
+  }
+  for (int v = 1; v <= BENCH_VOICES; v *= 2) {
+    snprintf(name, sizeof(name), "active/%d", v);
+    results.push_back(Render_Scene(name, Setup_Active, files, v, 30, repeats));
+  }
+  results.push_back(Render_Scene("loop/wrap", Setup_Wrap, files, 0, 30, repeats));
+  for (int v = 1; v <= 4; v *= 2) {
+    snprintf(name, sizeof(name), "stream/%d", v);
+    results.push_back(Render_Scene(name, Setup_Stream, files, v, 30, repeats));
+  }
+  for (int v = 1; v <= 3; v += 2) {
+    snprintf(name, sizeof(name), "cache/%d", v);
+    results.push_back(Render_Scene(name, Setup_Cache, files, v, 30, repeats));
+    snprintf(name, sizeof(name), "file/%d", v);
+    results.push_back(Render_Scene(name, Setup_File, files, v, 30, repeats));
+  }
+  snprintf(name, sizeof(name), "worst/%d", BENCH_VOICES);
+  results.push_back(Render_Scene(name, Setup_Worst, files, BENCH_VOICES, 30, repeats));
+  results.push_back(Render_Scene("engine/1_layer", Setup_Engine, files, 0, 30, repeats));
+  for (int v = 1; v <= 4; v *= 2) {
+    snprintf(name, sizeof(name), "engine/%d", v);
+    results.push_back(Render_Scene(name, Setup_Engine, files, v, 30, repeats));
+  }
+  for (int source = bank != NULL ? 0 : 1; source < 3; source++) {
+    results.push_back(Trigger(source, files, bank, repeats));
+  }
+  for (int call = 0; call < 6; call++) {
+    results.push_back(Control(call, files, repeats));
+  }
+  for (int v = 4; v <= BENCH_VOICES; v *= 4) {
+    snprintf(name, sizeof(name), "inserts/%d", v);
+    results.push_back(Render_Scene(name, Setup_Inserts, files, v, 30, repeats));
+  }
+  for (int k = 0; k < 5; k++) {
+    results.push_back(Filter_Kernel(k, repeats));
+  }
+  for (int k = 0; k < 5; k++) {
+    results.push_back(Mix_Kernel(k, false, repeats));
+    results.push_back(Mix_Kernel(k, true, repeats));
+  }
+  //-----------------------------------------------------------------------------------report
+  std::map<std::string, double> baseline;
+  if (base != NULL && !Read_Baseline(base, &baseline)) {
+    fprintf(stderr, "can not read %s\n", base);
+    return 2;
+  }
+  int slower = 0, fresh = 0, missing = 0;
+  std::map<std::string, double> ran;
+  printf("%-28s %12s %10s %12s", "scene", "ns/sample", "us/block", "realtime");
+  printf(mhz > 0 ? " %10s %10s\n" : " %10s\n", mhz > 0 ? "cycles" : "baseline", "baseline");
+  for (size_t i = 0; i < results.size(); i++) {
+    printf("%-28s %12.2f %10.2f %11.0fx", results[i].name.c_str(), results[i].ns,
+           results[i].ns * 256 / 1000, results[i].realtime);
+    if (mhz > 0) {
+      printf(" %10.1f", results[i].ns * mhz / 1000);
+    }
+    if (baseline.count(results[i].name) > 0) {
+      double change = (results[i].ns / baseline[results[i].name] - 1) * 100;
+      bool fail = change > tolerance;
+      slower += fail;
+      printf(" %+9.1f%%%s", change, fail ? "  SLOWER" : "");
+    }
+    else if (base != NULL) {
+      printf(" %10s", "new");
+      fresh++;
+    }
+    printf("\n");
+    ran[results[i].name] = results[i].ns;
+  }
+  for (std::map<std::string, double>::iterator it = baseline.begin(); it != baseline.end(); it++) {
+    if (ran.count(it->first) == 0) {
+      printf("%-28s %12s  in the baseline, did not run\n", it->first.c_str(), "MISSING");
+      missing++;
+    }
+  }
+  if (save != NULL) {
+    FILE *file = fopen(save, "w");
+    if (file == NULL) {
+      fprintf(stderr, "can not write %s\n", save);
+      return 2;
+    }
+    fprintf(file, "#");
+    for (int a = 0; a < argc; a++) {
+      fprintf(file, " %s", argv[a]);
+    }
+    fprintf(file, "\n");
+    for (size_t i = 0; i < results.size(); i++) {
+      fprintf(file, "%s %.3f\n", results[i].name.c_str(), results[i].ns);
+    }
+    fclose(file);
+  }
+  if (base != NULL) {
+    printf("%d of %d scenes slower than the baseline + %.1f%%, %d did not run, %d new\n", slower,
+           (int)baseline.size(), tolerance, missing, fresh);
+  }
+  return slower > 0 || missing > 0 ? 1 : 0;
+}
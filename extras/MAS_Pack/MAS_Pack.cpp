@@ -0,0 +1,183 @@
+/*MAS_Pack
+  Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Host tool that packs the sound files of a directory into a sound bank (see MAS_Bank.h).
+  Every file MAS_Read_Format can play is decoded to PCM 16 bit, the name in the bank is
+  "/" + file name, like the SPIFFS path of the file.
+
+  Build (Linux, macOS):
+  g++ -O2 -pthread -I src extras/MAS_Pack/MAS_Pack.cpp src/MAS_Bank.cpp src/MAS_Decoder.cpp
+      src/MAS_Platform.cpp -o mas_pack
+  Use:
+  mas_pack <directory> <bank file> [name:loop_start:loop_end ...]
+  Example:
+  mas_pack examples/data sounds.bin /makrofon_loop.aiff:0:4000
+  Loop points are samples of the decoded sound, without loop points the whole sound loops.
+
+  Flash the bank into a data partition, for example with this line in partitions.csv:
+  sounds,   data, 0x40,    ,  1M,
+  esptool.py write_flash <offset of the partition> sounds.bin
+  and open it in the sketch with Audio.openBank("sounds").
+  -------------------------------------------------------------------------------------------*/
+#include <dirent.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "MAS_Platform.h"
+#include "MAS_Bank.h"
+#include "MAS_Decoder.h"
+
+struct Pack_Sound {
+  MAS_Bank_Entry entry;
+  std::vector<int16_t> samples;
+};
+
+//-------------------------------------------------------------------------------decode file
+static bool Decode_File(const char *name, Pack_Sound *sound) {
+  MAS_File file;
+  MAS_Format format;
+  if (!file.open(name) || !MAS_Read_Format(&file, &format)) {
+    return false;
+  }
+  std::vector<uint8_t> data(format.data_len);
+  int len = file.read(data.data(), format.data_len);
+  file.close();
+  if (len <= 0) {
+    return false;
+  }
+  sound->samples.resize(format.decoder->samples(&format, len));
+  int count = format.decoder->decode(&format, data.data(), len, sound->samples.data());
+  sound->samples.resize(count);
+  memset(&sound->entry, 0, sizeof(sound->entry));
+  strncpy(sound->entry.name, name, MAS_BANK_NAME - 1);
+  sound->entry.hash = MAS_Bank_Hash(sound->entry.name);
+  sound->entry.len = count;
+  sound->entry.rate = format.rate;
+  sound->entry.loop_end = count;
+  return count > 0;
+}//                                                                             decode file
+//-------------------------------------------------------------------------------write bank
+static void put32(std::vector<uint8_t> *bank, uint32_t pos, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    (*bank)[pos + i] = value >> (8 * i);
+  }
+}
+static bool Write_Bank(const char *name, std::vector<Pack_Sound> *sounds) {
+  uint32_t index = (sizeof(MAS_Bank_Header) + 3) & ~3u;
+  uint32_t pos = index + sounds->size() * sizeof(MAS_Bank_Entry);
+  for (size_t i = 0; i < sounds->size(); i++) {
+    (*sounds)[i].entry.offset = pos;
+    pos = (pos + (*sounds)[i].samples.size() * 2 + 3) & ~3u;
+  }
+  //---------------------------------------------------------------------little endian image
+  std::vector<uint8_t> bank(pos, 0);
+  put32(&bank, 0, MAS_BANK_MAGIC);
+  put32(&bank, 4, MAS_BANK_VERSION);
+  put32(&bank, 8, sounds->size());
+  put32(&bank, 12, index);
+  put32(&bank, 16, pos);
+  for (size_t i = 0; i < sounds->size(); i++) {
+    const MAS_Bank_Entry *entry = &(*sounds)[i].entry;
+    uint32_t at = index + i * sizeof(MAS_Bank_Entry);
+    put32(&bank, at, entry->hash);
+    put32(&bank, at + 4, entry->offset);
+    put32(&bank, at + 8, entry->len);
+    put32(&bank, at + 12, entry->rate);
+    put32(&bank, at + 16, entry->loop_start);
+    put32(&bank, at + 20, entry->loop_end);
+    memcpy(&bank[at + 24], entry->name, MAS_BANK_NAME);
+    for (size_t s = 0; s < (*sounds)[i].samples.size(); s++) {
+      uint16_t sample = (*sounds)[i].samples[s];
+      bank[entry->offset + s * 2] = sample;
+      bank[entry->offset + s * 2 + 1] = sample >> 8;
+    }
+  }
+  FILE *file = fopen(name, "wb");
+  if (file == NULL) {
+    return false;
+  }
+  bool done = fwrite(bank.data(), 1, bank.size(), file) == bank.size();
+  return fclose(file) == 0 && done;
+}//                                                                              write bank
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    fprintf(stderr, "use: mas_pack <directory> <bank file> [name:loop_start:loop_end ...]\n");
+    return 2;
+  }
+  DIR *dir = opendir(argv[1]);
+  if (dir == NULL) {
+    fprintf(stderr, "no directory %s\n", argv[1]);
+    return 1;
+  }
+  std::vector<std::string> files;
+  for (struct dirent *item = readdir(dir); item != NULL; item = readdir(dir)) {
+    if (item->d_name[0] != '.') {
+      files.push_back(std::string("/") + item->d_name);
+    }
+  }
+  closedir(dir);
+  std::sort(files.begin(), files.end());
+  MAS_Set_Root(argv[1]);
+  std::vector<Pack_Sound> sounds;
+  for (size_t i = 0; i < files.size(); i++) {
+    //----------------------------------------------------------------------decode the files
+    Pack_Sound sound;
+    if (files[i].size() >= MAS_BANK_NAME) {
+      fprintf(stderr, "skip %s: name longer than %d\n", files[i].c_str(), MAS_BANK_NAME - 1);
+    }
+    else if (!Decode_File(files[i].c_str(), &sound)) {
+      fprintf(stderr, "skip %s: format not supported\n", files[i].c_str());
+    }
+    else {
+      sounds.push_back(sound);
+    }
+  }
+  for (int a = 3; a < argc; a++) {
+    //------------------------------------------------------------------------loop points
+    char name[MAS_BANK_NAME + 1] = {};
+    unsigned long start;
+    unsigned long end;
+    const char *colon = strchr(argv[a], ':');
+    bool found = false;
+    if (colon != NULL && colon - argv[a] < MAS_BANK_NAME &&
+        sscanf(colon, ":%lu:%lu", &start, &end) == 2) {
+      memcpy(name, argv[a], colon - argv[a]);
+      for (size_t i = 0; i < sounds.size(); i++) {
+        MAS_Bank_Entry *entry = &sounds[i].entry;
+        if (strcmp(entry->name, name) == 0 && start < end && end <= entry->len) {
+          entry->loop_start = start;
+          entry->loop_end = end;
+          found = true;
+        }
+      }
+    }
+    if (!found) {
+      fprintf(stderr, "no sound or wrong loop points: %s\n", argv[a]);
+      return 1;
+    }
+  }
+  std::stable_sort(sounds.begin(), sounds.end(), [](const Pack_Sound & a, const Pack_Sound & b) {
+    return a.entry.hash < b.entry.hash;
+  });
+  if (!Write_Bank(argv[2], &sounds)) {
+    fprintf(stderr, "can not write %s\n", argv[2]);
+    return 1;
+  }
+  for (size_t i = 0; i < sounds.size(); i++) {
+    printf("%-32s %7u samples %5u sample/sec\n", sounds[i].entry.name, sounds[i].entry.len,
+           sounds[i].entry.rate);
+  }
+  return 0;
+}
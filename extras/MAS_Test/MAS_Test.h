@@ -0,0 +1,142 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Helpers of the host tests in extras/MAS_Test, see run_tests.sh.
+
+  MAS_CHECK(condition)  counts a failed check and prints its line, the test goes on
+  Test_Done(name)       prints the result, returns the exit code of main
+  Test_Dir()            temporary directory of the generated files, removed by Test_Done
+  Test_Write_WAV        writes a WAVE file PCM 16 bit to Test_Dir()
+  Test_Tone             sine tone
+  Test_Output           output of the player into RAM, also from the player task
+  The tests run from the root of the library, examples/data and extras/MAS_Test/data are
+  relative to it.
+  -------------------------------------------------------------------------------------------*/
+#ifndef _MAS_TEST_
+#define _MAS_TEST_
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "ESP32_MAS.h"
+
+static int Test_Checks = 0;
+static int Test_Fails = 0;
+static std::vector<std::string> Test_Files; // files of Test_Dir
+
+#define MAS_CHECK(condition) do { \
+    Test_Checks++; \
+    if (!(condition)) { \
+      Test_Fails++; \
+      printf("%s:%d: FAILED %s\n", __FILE__, __LINE__, #condition); \
+    } \
+  } while (0)
+
+//---------------------------------------------------------------------------temporary files
+static inline const std::string &Test_Dir() {
+  static std::string dir;
+  if (dir.empty()) {
+    char name[] = "/tmp/mas_test_XXXXXX";
+    dir = mkdtemp(name) != NULL ? name : "/tmp";
+  }
+  return dir;
+}
+static inline int Test_Done(const char *name) {
+  for (size_t i = 0; i < Test_Files.size(); i++) {
+    unlink((Test_Dir() + Test_Files[i]).c_str());
+  }
+  rmdir(Test_Dir().c_str());
+  printf("%s: %d checks, %d failed\n", name, Test_Checks, Test_Fails);
+  return Test_Fails > 0 ? 1 : 0;
+}
+//---------------------------------------------------------------------------------WAVE file
+// name = "/file.wav" in Test_Dir(), count = frames.
+static inline bool Test_Write_WAV(const char *name, const int16_t *samples, uint32_t count,
+                                  uint32_t rate, uint8_t channels) {
+  uint32_t bytes = count * channels * 2;
+  uint8_t head[44] = {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ',
+                      16, 0, 0, 0, 1, 0, channels, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                      (uint8_t)(channels * 2), 0, 16, 0, 'd', 'a', 't', 'a'
+                     };
+  uint32_t fields[3][2] = {{4, 36 + bytes}, {24, rate}, {28, rate * channels * 2}};
+  for (int f = 0; f < 3; f++) {
+    for (int b = 0; b < 4; b++) {
+      head[fields[f][0] + b] = fields[f][1] >> (8 * b);
+    }
+  }
+  for (int b = 0; b < 4; b++) {
+    head[40 + b] = bytes >> (8 * b);
+  }
+  FILE *file = fopen((Test_Dir() + name).c_str(), "wb");
+  if (file == NULL) {
+    return false;
+  }
+  Test_Files.push_back(name);
+  fwrite(head, 1, 44, file);
+  for (uint32_t i = 0; i < count * channels; i++) {
+    uint8_t le[2] = {(uint8_t)samples[i], (uint8_t)(samples[i] >> 8)};
+    fwrite(le, 1, 2, file);
+  }
+  return fclose(file) == 0;
+}
+//-------------------------------------------------------------------------------------tone
+static inline std::vector<int16_t> Test_Tone(double freq, uint32_t rate, uint32_t count,
+                                             double amplitude) {
+  std::vector<int16_t> tone(count);
+  for (uint32_t i = 0; i < count; i++) {
+    tone[i] = lrint(amplitude * sin(2 * M_PI * freq * i / rate));
+  }
+  return tone;
+}
+//-------------------------------------------------------------------------------test output
+// Keeps the first samples in RAM. wait sleeps wait_us like a DMA buffer in the player task.
+class Test_Output : public MAS_Output {
+  public:
+    Test_Output(uint32_t len, uint32_t wait_us = 0) : Buf(len), Wait_Us(wait_us) {};
+    bool begin(uint32_t rate, uint16_t block, uint8_t count, uint8_t channels) {
+      Begins++;
+      return true;
+    };
+    uint8_t wait() {
+      if (Wait_Us > 0) {
+        usleep(Wait_Us);
+      }
+      return 0;
+    };
+    bool write(const int16_t *buf, uint16_t len) {
+      uint32_t pos = Count;
+      for (int i = 0; i < len && pos < Buf.size(); i++) {
+        Buf[pos++] = buf[i];
+      }
+      Count = pos;
+      Blocks++;
+      return true;
+    };
+    void idle(bool on) {
+      Idles += on;
+    };
+    void end() {
+      Ends++;
+    };
+    std::vector<int16_t> Buf;
+    uint32_t Wait_Us;
+    std::atomic<uint32_t> Count{0}; // samples in Buf
+    std::atomic<uint32_t> Blocks{0};
+    std::atomic<uint32_t> Begins{0};
+    std::atomic<uint32_t> Idles{0};
+    std::atomic<uint32_t> Ends{0};
+};
+#endif
@@ -0,0 +1,132 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Control calls without heap: after the start the calls by sound id, the handles, the typed
+  states, the snapshot of getStates and the parameter calls allocate nothing, neither do the
+  blocks of the player, offline and with the tasks. operator new of this program counts the
+  allocations, the String calls show that it counts. The sounds are cached, the reader opens
+  the files of the file system (SPIFFS and the host allocate there).
+  The cost per call is the scene control/<call> of MAS_Bench.
+  -------------------------------------------------------------------------------------------*/
+#include <new>
+#include "MAS_Test.h"
+
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete" // free of the malloc of operator new
+
+static std::atomic<bool> Alloc_On{false};
+static std::atomic<uint32_t> Allocs{0};
+
+void *operator new(size_t size) {
+  if (Alloc_On) {
+    Allocs++;
+  }
+  void *ptr = malloc(size > 0 ? size : 1);
+  if (ptr == NULL) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+void *operator new[](size_t size) {
+  return operator new(size);
+}
+void operator delete(void *ptr) noexcept {
+  free(ptr);
+}
+void operator delete[](void *ptr) noexcept {
+  free(ptr);
+}
+void operator delete(void *ptr, size_t size) noexcept {
+  free(ptr);
+}
+void operator delete[](void *ptr, size_t size) noexcept {
+  free(ptr);
+}
+
+static constexpr const char *Sounds[] = {"/tone.wav", "/short.wav", "/other.wav"};
+enum {TONE, SHORT, OTHER};
+
+// Every control call without String, the calls of the control loop of a sketch.
+template <uint8_t channels> static void Control(ESP32_MAS<channels> *audio, int i) {
+  MAS_Channel_Info info[channels];
+  MAS_Voice_Handle voice = audio->playSound(0, i % 2 ? TONE : OTHER);
+  audio->queueSound(0, SHORT, true);
+  MAS_Voice_Handle loop = audio->loopSound(1, SHORT);
+  audio->playAny(TONE, 1);
+  audio->loopAny(SHORT, 2);
+  audio->getVoice(voice);
+  audio->getState(1);
+  audio->getStates(info);
+  audio->setGain(2, i % 256);
+  audio->rampGain(3, 255 - i % 256, 20);
+  audio->setPitch(1, (i % 10) * 0.05f);
+  audio->setPan(1, i % 100 - 50);
+  audio->setPriority(2, i % 5);
+  audio->setVolume(200);
+  if (i % 3 == 0) {
+    audio->stopVoice(loop);
+  }
+}
+
+int main() {
+  MAS_Set_Root(Test_Dir().c_str());
+  std::vector<int16_t> tone = Test_Tone(440, 22050, 3000, 8000);
+  MAS_CHECK(Test_Write_WAV("/tone.wav", tone.data(), 3000, 22050, 1));
+  MAS_CHECK(Test_Write_WAV("/short.wav", tone.data(), 200, 22050, 1));
+  MAS_CHECK(Test_Write_WAV("/other.wav", tone.data() + 1000, 2000, 22050, 1));
+  //-----------------------------------------------------------------------------------offline
+  Test_Output output(1024);
+  ESP32_MAS<4> audio;
+  audio.setOutput(&output);
+  audio.setStereo(true);
+  audio.setSounds(Sounds, 3);
+  for (const char *sound : Sounds) {
+    MAS_CHECK(audio.preloadFile(sound));
+  }
+  audio.renderOffline(0.01f); // allocates the buffers
+  Alloc_On = true;
+  for (int i = 0; i < 2000; i++) {
+    Control(&audio, i);
+    audio.renderOffline(0.003f);
+  }
+  Alloc_On = false;
+  MAS_CHECK(Allocs == 0);
+  MAS_CHECK(audio.getState(0) != MAS_STOP || audio.getState(1) != MAS_STOP);
+  //-------------------------------------------------------------------------the counter counts
+  Alloc_On = true;
+  audio.playFile(0, "/a_name_longer_than_a_short_string.wav");
+  String state = audio.getChan(0);
+  Alloc_On = false;
+  MAS_CHECK(Allocs > 0);
+  audio.renderOffline(0.01f);
+  //-------------------------------------------------------------------------------------tasks
+  Test_Output dma(256, 256 * 1000000 / 22050);
+  ESP32_MAS<4> *task = new ESP32_MAS<4>;
+  task->setOutput(&dma);
+  task->setSounds(Sounds, 3);
+  for (const char *sound : Sounds) {
+    MAS_CHECK(task->preloadFile(sound));
+  }
+  task->startDAC();
+  usleep(50000);
+  Allocs = 0;
+  Alloc_On = true;
+  for (int i = 0; i < 200; i++) {
+    Control(task, i);
+    usleep(1000); // 1 kHz control loop
+  }
+  Alloc_On = false;
+  MAS_CHECK(Allocs == 0);
+  MAS_CHECK(dma.Blocks > 10);
+  delete task;
+  return Test_Done("Test_Alloc");
+}
@@ -0,0 +1,213 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Sound bank: a bank written after the layout of MAS_Bank.h plays its sounds sample by sample,
+  a loop of the bank repeats from its loop start, names not in the bank play from the file
+  system. A broken header or index is refused. With MAS_PACK = path of mas_pack (run_tests.sh
+  sets it) examples/data is packed and every sound of the bank is the decoded file.
+  The trigger time of the bank against the file system is the scene trigger/<source> of
+  MAS_Bench.
+  -------------------------------------------------------------------------------------------*/
+#include <algorithm>
+#include "MAS_Test.h"
+#include "MAS_Decoder.h"
+
+struct Test_Sound {
+  const char *name;
+  std::vector<int16_t> samples;
+  uint32_t rate;
+  uint32_t loop_start;
+  uint32_t loop_end;
+};
+
+static void Put32(std::vector<uint8_t> *bank, uint32_t pos, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    (*bank)[pos + i] = value >> (8 * i);
+  }
+}
+//-------------------------------------------------------------------------------------bank
+// Image of the sounds, the index sorted by hash.
+static std::vector<uint8_t> Bank_Image(std::vector<Test_Sound> sounds) {
+  std::sort(sounds.begin(), sounds.end(), [](const Test_Sound & a, const Test_Sound & b) {
+    return MAS_Bank_Hash(a.name) < MAS_Bank_Hash(b.name);
+  });
+  uint32_t index = 20;
+  uint32_t pos = index + sounds.size() * sizeof(MAS_Bank_Entry);
+  std::vector<uint32_t> offset;
+  for (size_t i = 0; i < sounds.size(); i++) {
+    offset.push_back(pos);
+    pos = (pos + sounds[i].samples.size() * 2 + 3) & ~3u;
+  }
+  std::vector<uint8_t> bank(pos, 0);
+  Put32(&bank, 0, MAS_BANK_MAGIC);
+  Put32(&bank, 4, MAS_BANK_VERSION);
+  Put32(&bank, 8, sounds.size());
+  Put32(&bank, 12, index);
+  Put32(&bank, 16, pos);
+  for (size_t i = 0; i < sounds.size(); i++) {
+    uint32_t at = index + i * sizeof(MAS_Bank_Entry);
+    Put32(&bank, at, MAS_Bank_Hash(sounds[i].name));
+    Put32(&bank, at + 4, offset[i]);
+    Put32(&bank, at + 8, sounds[i].samples.size());
+    Put32(&bank, at + 12, sounds[i].rate);
+    Put32(&bank, at + 16, sounds[i].loop_start);
+    Put32(&bank, at + 20, sounds[i].loop_end);
+    strcpy((char*)&bank[at + 24], sounds[i].name);
+    for (size_t s = 0; s < sounds[i].samples.size(); s++) {
+      bank[offset[i] + 2 * s] = sounds[i].samples[s];
+      bank[offset[i] + 2 * s + 1] = (uint16_t)sounds[i].samples[s] >> 8;
+    }
+  }
+  return bank;
+}//                                                                                     bank
+static bool Write_File(const char *name, const std::vector<uint8_t> &data) {
+  FILE *file = fopen((Test_Dir() + name).c_str(), "wb");
+  if (file == NULL) {
+    return false;
+  }
+  if (std::find(Test_Files.begin(), Test_Files.end(), name) == Test_Files.end()) {
+    Test_Files.push_back(name);
+  }
+  bool done = fwrite(data.data(), 1, data.size(), file) == data.size();
+  return fclose(file) == 0 && done;
+}
+static bool Open_Image(const std::vector<uint8_t> &image) {
+  static int banks = 0;
+  char name[32];
+  snprintf(name, sizeof(name), "/bank%d.bin", banks++); // a new file, the old one is mapped
+  MAS_Bank bank;
+  return Write_File(name, image) && bank.open(name + 1);
+}
+static std::vector<int16_t> Play(ESP32_MAS<2> *audio, Test_Output *output, const char *name,
+                                 bool loop, uint32_t len) {
+  uint32_t start = output->Count;
+  if (loop) {
+    audio->loopFile(0, name);
+  }
+  else {
+    audio->playFile(0, name);
+  }
+  audio->renderOffline(len / 22050.0f);
+  audio->stopChan(0);
+  audio->renderOffline(0.01f);
+  return std::vector<int16_t>(output->Buf.begin() + start, output->Buf.begin() + start + len);
+}
+static std::vector<int16_t> Decode(const char *name) {
+  std::vector<int16_t> out;
+  MAS_File file;
+  MAS_Format format;
+  if (!file.open(name) || !MAS_Read_Format(&file, &format)) {
+    return out;
+  }
+  std::vector<uint8_t> data(format.data_len);
+  int len = file.read(data.data(), format.data_len);
+  out.resize(format.decoder->samples(&format, len));
+  out.resize(format.decoder->decode(&format, data.data(), len, out.data()));
+  file.close();
+  return out;
+}
+//---------------------------------------------------------------------------------mas_pack
+static void Packed(const char *pack) {
+  std::string command = std::string(pack) + " examples/data " + Test_Dir() +
+                        "/packed.bin /makrofon_loop.aiff:100:4000 > /dev/null";
+  MAS_CHECK(system(command.c_str()) == 0);
+  Test_Files.push_back("/packed.bin");
+  MAS_Set_Root(Test_Dir().c_str());
+  MAS_Bank bank;
+  MAS_CHECK(bank.open("packed.bin"));
+  MAS_Set_Root("examples/data");
+  static const char *const files[] = {"/E_brake.aiff", "/E_engine.aiff", "/E_engine1.aiff",
+                                      "/E_engine8.aiff", "/makrofon_in.aiff",
+                                      "/makrofon_loop.aiff", "/makrofon_out.aiff"
+                                     };
+  for (const char *file : files) {
+    MAS_Sound sound;
+    std::vector<int16_t> decoded = Decode(file);
+    MAS_CHECK(bank.find(file, &sound) && sound.len == decoded.size() && sound.rate == 22050);
+    MAS_CHECK(std::equal(decoded.begin(), decoded.end(), sound.data));
+    bool loop = strcmp(file, "/makrofon_loop.aiff") == 0;
+    MAS_CHECK(sound.loop_start == (loop ? 100 : 0));
+    MAS_CHECK(sound.loop_end == (loop ? 4000 : sound.len));
+  }
+  MAS_CHECK(bank.count() == 14);
+}//                                                                                 mas_pack
+
+int main() {
+  MAS_Set_Root(Test_Dir().c_str());
+  std::vector<Test_Sound> sounds(3);
+  sounds[0] = {"/tone.aiff", Test_Tone(440, 22050, 3000, 12000), 22050, 0, 3000};
+  sounds[1] = {"/slow.wav", Test_Tone(300, 11025, 2000, 9000), 11025, 0, 2000};
+  sounds[2] = {"/loop.aiff", Test_Tone(700, 22050, 1500, 15000), 22050, 300, 1200};
+  std::vector<uint8_t> image = Bank_Image(sounds);
+  MAS_CHECK(Write_File("/sounds.bin", image));
+  std::vector<int16_t> file = Test_Tone(1000, 22050, 2000, 5000);
+  MAS_CHECK(Test_Write_WAV("/file.wav", file.data(), file.size(), 22050, 1));
+  //-------------------------------------------------------------------------------------play
+  Test_Output output(1 << 16);
+  ESP32_MAS<2> audio;
+  audio.setOutput(&output);
+  audio.setGain(0, 255);
+  MAS_CHECK(!audio.openBank("nothing.bin"));
+  MAS_CHECK(audio.openBank("sounds.bin"));
+  MAS_CHECK(audio.preloadFile("/tone.aiff")); // in the bank, nothing is copied
+  MAS_CHECK(Play(&audio, &output, "/tone.aiff", false, 3000) == sounds[0].samples);
+  std::vector<int16_t> slow = Play(&audio, &output, "/slow.wav", false, 4000);
+  MAS_CHECK(slow[0] == sounds[1].samples[0] && slow[2] == sounds[1].samples[1]); // 11025 Hz
+  std::vector<int16_t> expect(sounds[2].samples.begin(), sounds[2].samples.begin() + 1200);
+  while (expect.size() < 5000) {
+    expect.insert(expect.end(), sounds[2].samples.begin() + 300, sounds[2].samples.begin() + 1200);
+  }
+  expect.resize(5000);
+  MAS_CHECK(Play(&audio, &output, "/loop.aiff", true, 5000) == expect);
+  MAS_CHECK(Play(&audio, &output, "/file.wav", false, 2000) == file); // file system
+  MAS_CHECK(audio.getUnderrun(0) == 0);
+  //-------------------------------------------------------------------------------broken bank
+  MAS_CHECK(Open_Image(image));
+  std::vector<uint8_t> broken = image;
+  broken[0] ^= 1; // magic
+  MAS_CHECK(!Open_Image(broken));
+  broken = image;
+  Put32(&broken, 4, MAS_BANK_VERSION + 1);
+  MAS_CHECK(!Open_Image(broken));
+  broken = image;
+  Put32(&broken, 16, image.size() + 4); // bigger than the file
+  MAS_CHECK(!Open_Image(broken));
+  broken = image;
+  Put32(&broken, 8, 1000); // index beyond the bank
+  MAS_CHECK(!Open_Image(broken));
+  uint32_t entry = 20 + sizeof(MAS_Bank_Entry); // second entry
+  broken = image;
+  Put32(&broken, 20, 0xFFFFFFFF); // first hash above the second
+  MAS_CHECK(!Open_Image(broken));
+  broken = image;
+  Put32(&broken, entry + 4, 22); // not aligned
+  MAS_CHECK(!Open_Image(broken));
+  broken = image;
+  Put32(&broken, entry + 8, image.size()); // samples beyond the bank
+  MAS_CHECK(!Open_Image(broken));
+  broken = image;
+  Put32(&broken, entry + 16, 5000); // loop start after the loop end
+  MAS_CHECK(!Open_Image(broken));
+  broken = image;
+  memset(&broken[entry + 24], 'x', MAS_BANK_NAME); // name without 0
+  MAS_CHECK(!Open_Image(broken));
+  //------------------------------------------------------------------------------------packer
+  const char *pack = getenv("MAS_PACK");
+  if (pack != NULL) {
+    Packed(pack);
+  }
+  else {
+    printf("MAS_PACK not set, mas_pack not tested\n");
+  }
+  return Test_Done("Test_Bank");
+}
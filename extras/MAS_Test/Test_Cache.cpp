@@ -0,0 +1,92 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Sample cache: a cached file plays its decoded samples, a loop wraps without a gap, the cache
+  is bounded and removes the least recently used file that no channel plays.
+  A file removed from the disk after preloadFile only plays if it is still in the cache.
+  -------------------------------------------------------------------------------------------*/
+#include "MAS_Test.h"
+
+#define CACHE_LEN 3000 // samples of a test file
+
+static std::vector<int16_t> Pattern(int seed, uint32_t len) {
+  std::vector<int16_t> samples(len);
+  for (uint32_t i = 0; i < len; i++) {
+    samples[i] = (int16_t)((i * (37 + seed) + seed * 1000) % 20000 - 10000);
+  }
+  return samples;
+}
+// true if the channel plays the file although it is no longer on the disk
+static bool Plays(ESP32_MAS<2> *audio, Test_Output *output, const char *file) {
+  uint32_t from = output->Count;
+  bool sound = false;
+  audio->playFile(1, file);
+  audio->renderOffline(0.02f);
+  for (uint32_t i = from; i < output->Count; i++) {
+    sound = sound || output->Buf[i] != 0;
+  }
+  audio->stopChan(1);
+  audio->renderOffline(0.02f);
+  return sound;
+}
+
+int main() {
+  MAS_Set_Root(Test_Dir().c_str());
+  std::vector<int16_t> a = Pattern(1, CACHE_LEN);
+  std::vector<int16_t> b = Pattern(2, CACHE_LEN);
+  std::vector<int16_t> c = Pattern(3, CACHE_LEN);
+  std::vector<int16_t> big = Pattern(4, 3 * CACHE_LEN);
+  MAS_CHECK(Test_Write_WAV("/a.wav", a.data(), CACHE_LEN, 22050, 1));
+  MAS_CHECK(Test_Write_WAV("/b.wav", b.data(), CACHE_LEN, 22050, 1));
+  MAS_CHECK(Test_Write_WAV("/c.wav", c.data(), CACHE_LEN, 22050, 1));
+  MAS_CHECK(Test_Write_WAV("/big.wav", big.data(), 3 * CACHE_LEN, 22050, 1));
+  ESP32_MAS<2> audio;
+  Test_Output output(1 << 18);
+  audio.setOutput(&output);
+  audio.setGain(0, 255);
+  audio.setGain(1, 255);
+  audio.setCache(2 * CACHE_LEN * 2 + 64); // two files
+  //------------------------------------------------------------------------loop from the cache
+  MAS_CHECK(audio.preloadFile("/a.wav"));
+  MAS_CHECK(audio.preloadFile("/a.wav")); // already cached
+  audio.loopFile(0, "/a.wav");
+  uint32_t frames = audio.renderOffline(3.5f * CACHE_LEN / 22050);
+  int same = 0;
+  for (uint32_t i = 0; i < frames; i++) {
+    same += output.Buf[i] == a[i % CACHE_LEN];
+  }
+  MAS_CHECK(same == (int)frames); // the decoded samples, no gap at the wraps
+  //--------------------------------------------------------------------------------bounded
+  MAS_CHECK(!audio.preloadFile("/big.wav"));
+  MAS_CHECK(!audio.preloadFile("/none.wav"));
+  //-------------------------------------------------------------least recently used, not played
+  audio.setGain(0, 0); // a loops on, Plays hears channel 1 only
+  audio.renderOffline(0.01f); // offline the cache removes files only with no queued command
+  MAS_CHECK(audio.preloadFile("/b.wav"));
+  MAS_CHECK(audio.preloadFile("/c.wav")); // removes b, channel 0 plays a
+  unlink((Test_Dir() + "/a.wav").c_str());
+  unlink((Test_Dir() + "/b.wav").c_str());
+  unlink((Test_Dir() + "/c.wav").c_str());
+  MAS_CHECK(Plays(&audio, &output, "/a.wav"));
+  MAS_CHECK(!Plays(&audio, &output, "/b.wav"));
+  MAS_CHECK(Plays(&audio, &output, "/c.wav"));
+  //--------------------------------------------------a file no channel plays can be removed
+  MAS_CHECK(Test_Write_WAV("/b.wav", b.data(), CACHE_LEN, 22050, 1));
+  audio.playFile(0, "/c.wav"); // the next file of channel 0, c was used after a
+  audio.renderOffline(0.2f);
+  MAS_CHECK(audio.getState(0) == MAS_STOP);
+  MAS_CHECK(audio.preloadFile("/b.wav")); // removes a
+  MAS_CHECK(!Plays(&audio, &output, "/a.wav"));
+  MAS_CHECK(Plays(&audio, &output, "/c.wav"));
+  return Test_Done("Test_Cache");
+}
@@ -0,0 +1,234 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Decoders: every fixture of extras/MAS_Test/data (make_fixtures.py) decodes to its .ref, by
+  the decoder in blocks and played from the file system and from the sample cache.
+  Broken IMA-ADPCM headers and blocks are clamped and never read outside of the data.
+  Broken headers are refused and never hang: a chunk longer than the file, a SSND chunk whose
+  offset is outside of the chunk or of the file, a COMM or fmt chunk shorter than its fields.
+  A data chunk longer than the file is cut at the end of the file.
+  -------------------------------------------------------------------------------------------*/
+#include "MAS_Test.h"
+
+#define FIXTURES "extras/MAS_Test/data"
+
+static const char *const Fixtures[] = {
+  "/pcm16.aiff", "/pcm8.aiff", "/stereo16.aiff", "/twos16.aifc", "/sowt16.aifc",
+  "/ima4_1.aifc", "/ima4_2.aifc", "/ima_1.wav", "/ima_2.wav", "/pcm16.wav", "/pcm8.wav",
+  "/stereo16.wav", "/pcm8.raw"
+};
+
+static std::vector<int16_t> Read_Ref(const char *name) {
+  std::vector<int16_t> ref;
+  FILE *file = fopen((std::string(FIXTURES) + name + ".ref").c_str(), "rb");
+  uint8_t le[2];
+  while (file != NULL && fread(le, 1, 2, file) == 2) {
+    ref.push_back((int16_t)(le[0] | le[1] << 8));
+  }
+  if (file != NULL) {
+    fclose(file);
+  }
+  return ref;
+}
+//-----------------------------------------------------------------------------------decoder
+// Decodes the data like the reader: whole blocks of about MAS_STREAM_BLOCK bytes, then the rest.
+static std::vector<int16_t> Decode(const char *name, MAS_Format *format) {
+  std::vector<int16_t> out;
+  MAS_File file;
+  if (!file.open(name) || !MAS_Read_Format(&file, format)) {
+    return out;
+  }
+  uint32_t chunk = MAS_STREAM_BLOCK / format->block_align * format->block_align;
+  std::vector<uint8_t> data(chunk);
+  std::vector<int16_t> pcm(MAS_STREAM_PCM);
+  for (uint32_t pos = 0; pos < format->data_len; pos += chunk) {
+    int len = file.read(data.data(), format->data_len - pos < chunk ? format->data_len - pos : chunk);
+    int count = format->decoder->decode(format, data.data(), len, pcm.data());
+    out.insert(out.end(), pcm.begin(), pcm.begin() + count);
+  }
+  file.close();
+  MAS_CHECK(out.size() == format->decoder->samples(format, format->data_len));
+  return out;
+}//                                                                                   decoder
+//------------------------------------------------------------------------------------player
+static std::vector<int16_t> Play(const char *name, bool cached, uint32_t len) {
+  Test_Output output(len);
+  ESP32_MAS<2> audio;
+  audio.setOutput(&output);
+  audio.setGain(0, 255);
+  if (cached) {
+    MAS_CHECK(audio.preloadFile(name));
+  }
+  audio.playFile(0, name);
+  audio.renderOffline((len + 512) / 22050.0f);
+  MAS_CHECK(audio.getState(0) == MAS_STOP && audio.getUnderrun(0) == 0);
+  return output.Buf;
+}//                                                                                    player
+//------------------------------------------------------------------------------broken blocks
+static void Broken_IMA() {
+  MAS_Format format;
+  format.decoder = &MAS_IMA;
+  format.block_align = 36;
+  format.block_samples = 65;
+  std::vector<uint8_t> block(36, 0x73);
+  std::vector<int16_t> broken(MAS_STREAM_PCM), clamped(MAS_STREAM_PCM);
+  block[0] = block[1] = block[3] = 0;
+  block[2] = 200; // index >= 128, negative as int8_t
+  MAS_CHECK(MAS_IMA.decode(&format, block.data(), 36, broken.data()) == 65);
+  block[2] = 88;
+  MAS_IMA.decode(&format, block.data(), 36, clamped.data());
+  MAS_CHECK(broken == clamped);
+  //--------------------------------------------------stereo block cut inside a word of 4 bytes
+  format.channels = 2;
+  format.block_align = 512;
+  std::vector<uint8_t> cut(8 + 13, 0x42); // the header of 2 channels and 13 of 16 bytes
+  cut[2] = cut[6] = 255;
+  MAS_CHECK(MAS_IMA.decode(&format, cut.data(), cut.size(), broken.data()) == 9);
+  MAS_CHECK(MAS_IMA.samples(&format, cut.size()) == 9);
+  //---------------------------------------------------------------------------------ima4
+  format.decoder = &MAS_IMA4;
+  format.channels = 1;
+  format.block_align = 34;
+  std::vector<uint8_t> packet(34, 0x5A);
+  packet[0] = 0x12;
+  packet[1] = 0xFF; // index 127
+  MAS_IMA4.decode(&format, packet.data(), 34, broken.data());
+  packet[1] = 0x80 | 88;
+  MAS_IMA4.decode(&format, packet.data(), 34, clamped.data());
+  MAS_CHECK(broken == clamped);
+}//                                                                             broken blocks
+//-----------------------------------------------------------------------------broken headers
+static void Put(std::vector<uint8_t> *file, const char *id) {
+  file->insert(file->end(), id, id + 4);
+}
+static void Put(std::vector<uint8_t> *file, uint32_t value, int bytes, bool big_endian) {
+  for (int b = 0; b < bytes; b++) {
+    file->push_back(value >> 8 * (big_endian ? bytes - 1 - b : b));
+  }
+}
+// WAVE file of 16 bit mono at 22050 with a fmt chunk of fmt_len and 100 bytes of data.
+static std::vector<uint8_t> Wave(uint32_t fmt_len, uint32_t data_len) {
+  std::vector<uint8_t> file;
+  Put(&file, "RIFF");
+  Put(&file, 4 + 8 + fmt_len + 8 + 100, 4, false);
+  Put(&file, "WAVE");
+  Put(&file, "fmt ");
+  Put(&file, fmt_len, 4, false);
+  uint32_t fields[6][2] = {{1, 2}, {1, 2}, {22050, 4}, {44100, 4}, {2, 2}, {16, 2}};
+  for (int f = 0; f < 6 && file.size() < 20 + fmt_len; f++) {
+    Put(&file, fields[f][0], fields[f][1], false);
+  }
+  file.resize(20 + fmt_len);
+  Put(&file, "data");
+  Put(&file, data_len, 4, false);
+  file.resize(file.size() + 100, 0x11);
+  return file;
+}
+// AIFF file of 16 bit mono at 22050 with a COMM chunk of comm_len and a SSND chunk of ssnd_len
+// with offset, then 100 bytes of data.
+static std::vector<uint8_t> Aiff(uint32_t comm_len, uint32_t ssnd_len, uint32_t offset) {
+  static const uint8_t rate[10] = {0x40, 0x0D, 0xAC, 0x44, 0, 0, 0, 0, 0, 0}; // 22050
+  std::vector<uint8_t> file;
+  Put(&file, "FORM");
+  Put(&file, 4 + 8 + comm_len + 16 + 100, 4, true);
+  Put(&file, "AIFF");
+  Put(&file, "COMM");
+  Put(&file, comm_len, 4, true);
+  Put(&file, 1, 2, true);
+  Put(&file, 50, 4, true);
+  Put(&file, 16, 2, true);
+  file.insert(file.end(), rate, rate + 10);
+  file.resize(20 + comm_len);
+  Put(&file, "SSND");
+  Put(&file, ssnd_len, 4, true);
+  Put(&file, offset, 4, true);
+  Put(&file, 0, 4, true);
+  file.resize(file.size() + 100, 0x11);
+  return file;
+}
+// MAS_Read_Format of the bytes written to a file.
+static bool Read_Header(const std::vector<uint8_t> &bytes, MAS_Format *format) {
+  std::string name = Test_Dir() + "/broken.wav";
+  FILE *out = fopen(name.c_str(), "wb");
+  fwrite(bytes.data(), 1, bytes.size(), out);
+  fclose(out);
+  MAS_File file;
+  MAS_Set_Root(Test_Dir().c_str());
+  bool read = file.open("/broken.wav") && MAS_Read_Format(&file, format);
+  file.close();
+  MAS_Set_Root(FIXTURES);
+  return read;
+}
+static void Broken_Headers() {
+  MAS_Format format;
+  Test_Files.push_back("/broken.wav");
+  alarm(10); // a header that hangs the parser fails the test
+  MAS_CHECK(Read_Header(Wave(16, 100), &format) && format.data_len == 100);
+  MAS_CHECK(Read_Header(Aiff(18, 108, 0), &format) && format.data_len == 100);
+  //------------------------------------------------------------------chunk behind the file
+  std::vector<uint8_t> junk;
+  Put(&junk, "RIFF");
+  Put(&junk, 84, 4, false);
+  Put(&junk, "WAVE");
+  Put(&junk, "junk");
+  Put(&junk, 0xFFFFFFF8, 4, false); // 8 + len wraps pos to itself
+  junk.resize(92, 0);
+  MAS_CHECK(!Read_Header(junk, &format) && format.decoder == NULL);
+  std::vector<uint8_t> skip = Wave(16, 100);
+  skip.insert(skip.begin() + 12, {'j', 'u', 'n', 'k', 0xF0, 0xFF, 0xFF, 0xFF});
+  MAS_CHECK(!Read_Header(skip, &format));
+  //----------------------------------------------------------------data longer than the file
+  MAS_CHECK(Read_Header(Wave(16, 0xFFFFFFF0), &format) && format.data_len == 100);
+  MAS_CHECK(Read_Header(Aiff(18, 0xFFFFFFF0, 0), &format) && format.data_len == 100);
+  //----------------------------------------------------------------------------------SSND
+  MAS_CHECK(!Read_Header(Aiff(18, 4, 0), &format) && format.decoder == NULL);
+  MAS_CHECK(!Read_Header(Aiff(18, 108, 101), &format));
+  MAS_CHECK(!Read_Header(Aiff(18, 0xFFFFFFF0, 0xFFFFFFE0), &format)); // start wraps
+  MAS_CHECK(!Read_Header(Aiff(18, 0xFFFFFFF0, 101), &format)); // start behind the file
+  MAS_CHECK(Read_Header(Aiff(18, 108, 100), &format) && format.data_len == 0);
+  //------------------------------------------------------------------------short chunks
+  MAS_CHECK(!Read_Header(Aiff(10, 108, 0), &format));
+  MAS_CHECK(!Read_Header(Aiff(17, 108, 0), &format));
+  MAS_CHECK(!Read_Header(Wave(12, 100), &format));
+  std::vector<uint8_t> ima = Wave(14, 100);
+  ima[20] = 0x11; // IMA-ADPCM without bits
+  MAS_CHECK(!Read_Header(ima, &format) && format.decoder == NULL);
+  alarm(0);
+}//                                                                            broken headers
+
+int main() {
+  MAS_Set_Root(FIXTURES);
+  for (const char *name : Fixtures) {
+    MAS_Format format;
+    std::vector<int16_t> ref = Read_Ref(name);
+    std::vector<int16_t> decoded = Decode(name, &format);
+    MAS_CHECK(ref.size() > 2900);
+    MAS_CHECK(format.rate == 22050);
+    if (decoded != ref) {
+      printf("%s: decoded %d samples differ from the reference\n", name, (int)decoded.size());
+      MAS_CHECK(decoded == ref);
+    }
+    for (int cached = 0; cached < 2; cached++) {
+      std::vector<int16_t> played = Play(name, cached, ref.size() + 256);
+      int same = 0;
+      for (size_t i = 0; i < ref.size(); i++) {
+        same += played[i] == ref[i];
+      }
+      MAS_CHECK(same == (int)ref.size());
+      MAS_CHECK(played[ref.size()] == 0);
+    }
+  }
+  Broken_IMA();
+  Broken_Headers();
+  return Test_Done("Test_Decoder");
+}
@@ -0,0 +1,119 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Engine voice: 8 layers of tones recorded at 1000 - 8000 rpm, the tone of every layer is
+  rpm / 20 Hz. At the rpm of a layer the voice plays that layer, an rpm sweep over all layers
+  with a new rpm every block has no step above the slope of the tone (no click at a change of
+  the layers), stays below the equal power sum and never falls silent. The same sweep of the
+  recordings E_engine1 - E_engine8 of the example is printed.
+  The cost per block is the scene engine/<layers> of MAS_Bench.
+  -------------------------------------------------------------------------------------------*/
+#include "MAS_Test.h"
+
+#define LAYER_LEN 4410 // samples of a layer, whole periods of every tone
+#define LAYER_AMP 8000
+#define SWEEP_BLOCK 256
+
+struct Sweep_Result {
+  int32_t step = 0; // largest step between two samples
+  int32_t peak = 0;
+  int32_t quiet = 0; // lowest peak of a block
+};
+// Renders a sweep of the engine voice from rpm_from to rpm_to, a new rpm every block.
+static Sweep_Result Sweep(const char *const *files, uint16_t rpm_from, uint16_t rpm_to,
+                          float seconds) {
+  Sweep_Result result;
+  uint32_t blocks = seconds * 22050 / SWEEP_BLOCK;
+  Test_Output output(blocks * SWEEP_BLOCK);
+  ESP32_MAS<1> audio;
+  audio.setOutput(&output);
+  audio.setBuffer(SWEEP_BLOCK, 4);
+  audio.setCache(1 << 20);
+  audio.setGain(0, 255);
+  for (int k = 0; k < 8; k++) {
+    MAS_CHECK(audio.addLayer(0, files[k], 1000 * (k + 1)));
+  }
+  audio.setRPM(0, rpm_from);
+  audio.startEngine(0);
+  result.quiet = 32767;
+  for (uint32_t b = 0; b < blocks; b++) {
+    audio.setRPM(0, rpm_from + ((int32_t)rpm_to - rpm_from) * (int32_t)(b + 1) / (int32_t)blocks);
+    audio.renderOffline(SWEEP_BLOCK / 22050.0f);
+    int32_t peak = 0;
+    for (uint32_t i = b * SWEEP_BLOCK; i < (b + 1) * SWEEP_BLOCK; i++) {
+      int32_t step = i > 0 ? abs(output.Buf[i] - output.Buf[i - 1]) : 0;
+      result.step = step > result.step ? step : result.step;
+      peak = abs(output.Buf[i]) > peak ? abs(output.Buf[i]) : peak;
+    }
+    result.peak = peak > result.peak ? peak : result.peak;
+    result.quiet = peak < result.quiet ? peak : result.quiet;
+  }
+  MAS_CHECK(output.Count == blocks * SWEEP_BLOCK && audio.getRPM(0) == rpm_to);
+  return result;
+}
+
+int main() {
+  MAS_Set_Root(Test_Dir().c_str());
+  static const char *const layers[] = {"/l1.wav", "/l2.wav", "/l3.wav", "/l4.wav", "/l5.wav",
+                                       "/l6.wav", "/l7.wav", "/l8.wav"
+                                      };
+  for (int k = 0; k < 8; k++) {
+    std::vector<int16_t> tone = Test_Tone(50 * (k + 1), 22050, LAYER_LEN, LAYER_AMP);
+    MAS_CHECK(Test_Write_WAV(layers[k], tone.data(), LAYER_LEN, 22050, 1));
+  }
+  //-----------------------------------------------------------------------at the rpm of a layer
+  Test_Output engine(8192), file(8192);
+  ESP32_MAS<1> audio, loop;
+  audio.setOutput(&engine);
+  audio.setCache(1 << 20);
+  audio.setGain(0, 255);
+  for (int k = 0; k < 8; k++) {
+    MAS_CHECK(audio.addLayer(0, layers[k], 1000 * (k + 1)));
+  }
+  audio.setRPM(0, 3000);
+  audio.startEngine(0);
+  audio.renderOffline(8192 / 22050.0f);
+  loop.setOutput(&file);
+  loop.setGain(0, 255);
+  MAS_CHECK(loop.preloadFile(layers[2]));
+  loop.loopFile(0, layers[2]);
+  loop.renderOffline(8192 / 22050.0f);
+  int differ = 0;
+  for (int i = 0; i < 8192; i++) {
+    differ += abs(engine.Buf[i] - file.Buf[i]) > 1;
+  }
+  MAS_CHECK(differ == 0);
+  MAS_CHECK(audio.getState(0) == MAS_RUN && audio.getRPM(0) == 3000);
+  //---------------------------------------------------------------------------------rpm sweep
+  // The tone of 9500 rpm has the steepest slope, the blend of two layers at most sqrt(2) of it.
+  double slope = 2 * M_PI * 9500 / 20 * LAYER_AMP / 22050 * sqrt(2.0);
+  printf("%-24s %8s %8s %8s\n", "sweep", "step", "peak", "quiet");
+  for (int up = 0; up < 2; up++) {
+    Sweep_Result sweep = up ? Sweep(layers, 500, 9500, 2) : Sweep(layers, 9500, 500, 2);
+    printf("%-24s %8d %8d %8d\n", up ? "tones 500 - 9500" : "tones 9500 - 500", sweep.step,
+           sweep.peak, sweep.quiet);
+    MAS_CHECK(sweep.step < slope * 1.2);
+    MAS_CHECK(sweep.peak <= LAYER_AMP * sqrt(2.0) + 2);
+    MAS_CHECK(sweep.quiet > 0);
+  }
+  MAS_Set_Root("examples/data");
+  static const char *const recorded[] = {"/E_engine1.aiff", "/E_engine2.aiff",
+                                         "/E_engine3.aiff", "/E_engine4.aiff",
+                                         "/E_engine5.aiff", "/E_engine6.aiff",
+                                         "/E_engine7.aiff", "/E_engine8.aiff"
+                                        };
+  Sweep_Result sweep = Sweep(recorded, 500, 9500, 2);
+  printf("%-24s %8d %8d %8d\n", "E_engine 500 - 9500", sweep.step, sweep.peak, sweep.quiet);
+  MAS_CHECK(sweep.quiet > 0);
+  return Test_Done("Test_Engine");
+}
@@ -0,0 +1,245 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Biquad inserts and limiter: the frequency response of the Q26 coefficients of every filter
+  type is the response of the reference coefficients of the RBJ audio EQ cookbook in double,
+  and tones filtered by MAS_Biquad_Run have that response. A DC through a low corner passes
+  or stops without dead band, MAS_Biquad_Run16 saturates. The limiter delays by
+  2 * MAS_LIMIT_STEP samples, lets no sample above the threshold and goes back to 0dB, three
+  full channels with the limiter do not clip. The responses are printed as a table.
+  The cost per sample is the scene filter/<type> and limiter/<channels> of MAS_Bench.
+  -------------------------------------------------------------------------------------------*/
+#include <complex>
+#include "MAS_Test.h"
+#include "MAS_Filter.h"
+#include "MAS_Mixer.h"
+
+#define RATE 22050
+
+struct Test_Filter {
+  const char *name;
+  uint8_t type;
+  uint16_t freq;
+  float q;
+  float gain;
+};
+static const Test_Filter Filters[] = {
+  {"lowpass 1000", MAS_FILTER_LOWPASS, 1000, 0.7071f, 0},
+  {"lowpass 60", MAS_FILTER_LOWPASS, 60, 0.7071f, 0},
+  {"highpass 100", MAS_FILTER_HIGHPASS, 100, 0.7071f, 0},
+  {"highpass 5000 q 2", MAS_FILTER_HIGHPASS, 5000, 2, 0},
+  {"peak 1000 +6", MAS_FILTER_PEAK, 1000, 1, 6},
+  {"peak 3000 -12", MAS_FILTER_PEAK, 3000, 4, -12},
+  {"lowshelf 200 +6", MAS_FILTER_LOWSHELF, 200, 0.7071f, 6},
+  {"highshelf 4000 -9", MAS_FILTER_HIGHSHELF, 4000, 0.7071f, -9},
+};
+static const int Freqs[] = {20, 50, 100, 200, 500, 1000, 2000, 3000, 5000, 8000, 10000};
+
+// Coefficients b0 b1 b2 a1 a2 divided by a0.
+struct Coeffs {
+  double c[5];
+};
+//---------------------------------------------------------------------------------reference
+static Coeffs Reference(const Test_Filter &f) {
+  double w0 = 2 * M_PI * f.freq / RATE, cw = cos(w0), alpha = sin(w0) / (2 * f.q);
+  double a = pow(10, f.gain / 40), sa = 2 * sqrt(a) * alpha;
+  double b[3], d[3];
+  switch (f.type) {
+    case MAS_FILTER_LOWPASS:
+      b[0] = b[2] = (1 - cw) / 2, b[1] = 1 - cw;
+      d[0] = 1 + alpha, d[1] = -2 * cw, d[2] = 1 - alpha;
+      break;
+    case MAS_FILTER_HIGHPASS:
+      b[0] = b[2] = (1 + cw) / 2, b[1] = -(1 + cw);
+      d[0] = 1 + alpha, d[1] = -2 * cw, d[2] = 1 - alpha;
+      break;
+    case MAS_FILTER_PEAK:
+      b[0] = 1 + alpha * a, b[1] = -2 * cw, b[2] = 1 - alpha * a;
+      d[0] = 1 + alpha / a, d[1] = -2 * cw, d[2] = 1 - alpha / a;
+      break;
+    case MAS_FILTER_LOWSHELF:
+      b[0] = a * ((a + 1) - (a - 1) * cw + sa);
+      b[1] = 2 * a * ((a - 1) - (a + 1) * cw);
+      b[2] = a * ((a + 1) - (a - 1) * cw - sa);
+      d[0] = (a + 1) + (a - 1) * cw + sa;
+      d[1] = -2 * ((a - 1) + (a + 1) * cw);
+      d[2] = (a + 1) + (a - 1) * cw - sa;
+      break;
+    default: // high shelf
+      b[0] = a * ((a + 1) + (a - 1) * cw + sa);
+      b[1] = -2 * a * ((a - 1) + (a + 1) * cw);
+      b[2] = a * ((a + 1) + (a - 1) * cw - sa);
+      d[0] = (a + 1) - (a - 1) * cw + sa;
+      d[1] = 2 * ((a - 1) - (a + 1) * cw);
+      d[2] = (a + 1) - (a - 1) * cw - sa;
+  }
+  return {{b[0] / d[0], b[1] / d[0], b[2] / d[0], d[1] / d[0], d[2] / d[0]}};
+}
+static Coeffs Fixed(const MAS_Biquad &biquad) {
+  double one = 1 << MAS_BIQUAD_BITS;
+  return {{biquad.b0 / one, biquad.b1 / one, biquad.b2 / one, biquad.a1 / one, biquad.a2 / one}};
+}
+// Response in dB at freq.
+static double Response(const Coeffs &k, double freq) {
+  std::complex<double> z = std::polar(1.0, -2 * M_PI * freq / RATE);
+  std::complex<double> h = (k.c[0] + k.c[1] * z + k.c[2] * z * z) /
+                           (1.0 + k.c[3] * z + k.c[4] * z * z);
+  return 20 * log10(std::abs(h));
+}
+// Level in dB of a tone of freq Hz filtered in blocks of 256, one second after the filter
+// has settled: whole periods, the DFT bin of the tone.
+static double Measure(MAS_Biquad *biquad, int freq) {
+  const int settle = RATE / 2, len = RATE;
+  const double amp = 8000 << MAS_MIX_FRAC;
+  std::vector<int32_t> buf(settle + len);
+  for (int i = 0; i < settle + len; i++) {
+    buf[i] = lrint(amp * sin(2 * M_PI * freq * i / RATE));
+  }
+  for (int i = 0; i < settle + len; i += 256) {
+    MAS_Biquad_Run(biquad, buf.data() + i, settle + len - i < 256 ? settle + len - i : 256);
+  }
+  std::complex<double> sum = 0;
+  for (int i = 0; i < len; i++) {
+    sum += (double)buf[settle + i] * std::polar(1.0, -2 * M_PI * freq * i / RATE);
+  }
+  return 20 * log10(2 * std::abs(sum) / len / amp);
+}
+
+int main() {
+  MAS_Set_Root(Test_Dir().c_str());
+  //---------------------------------------------------------------------------------responses
+  // Where the reference is above -40 dB: the Q26 coefficients within 0.02 dB, the filtered
+  // tone within 0.05 dB.
+  printf("%-20s", "response dB");
+  for (int freq : Freqs) {
+    printf(" %6d", freq);
+  }
+  printf("\n");
+  for (const Test_Filter &f : Filters) {
+    MAS_Filter_Set set;
+    set.type = f.type;
+    set.freq = f.freq;
+    set.q = f.q;
+    set.gain = f.gain;
+    MAS_Biquad biquad;
+    MAS_Biquad_Set(&biquad, &set, RATE);
+    Coeffs ref = Reference(f), fixed = Fixed(biquad);
+    int coeff_wrong = 0, tone_wrong = 0;
+    printf("%-20s", f.name);
+    for (int freq : Freqs) {
+      double expect = Response(ref, freq);
+      double tone = Measure(&biquad, freq);
+      printf(" %6.2f", tone);
+      if (expect > -40) {
+        coeff_wrong += fabs(Response(fixed, freq) - expect) > 0.02;
+        tone_wrong += fabs(tone - expect) > 0.05;
+      }
+    }
+    printf("\n");
+    MAS_CHECK(coeff_wrong == 0);
+    MAS_CHECK(tone_wrong == 0);
+  }
+  // The reference itself: the corner of the pass filters, the peak, the shelves.
+  MAS_CHECK(fabs(Response(Reference(Filters[0]), 1000) + 3.01) < 0.01);
+  MAS_CHECK(fabs(Response(Reference(Filters[2]), 100) + 3.01) < 0.01);
+  MAS_CHECK(fabs(Response(Reference(Filters[4]), 1000) - 6) < 0.01);
+  MAS_CHECK(fabs(Response(Reference(Filters[5]), 3000) + 12) < 0.01);
+  MAS_CHECK(fabs(Response(Reference(Filters[6]), 20) - 6) < 0.1);
+  MAS_CHECK(fabs(Response(Reference(Filters[7]), 10000) + 9) < 0.2);
+  //---------------------------------------------------------------------------------low corner
+  // A DC passes a low pass at 20 Hz unchanged and a high pass at 20 Hz decays to 0.
+  std::vector<int32_t> dc(RATE * 2, 1234 << MAS_MIX_FRAC);
+  MAS_Filter_Set set;
+  set.type = MAS_FILTER_LOWPASS;
+  set.freq = 20;
+  MAS_Biquad low, high;
+  MAS_Biquad_Set(&low, &set, RATE);
+  MAS_Biquad_Run(&low, dc.data(), dc.size());
+  MAS_CHECK(dc.back() == 1234 << MAS_MIX_FRAC && dc[dc.size() - 100] == 1234 << MAS_MIX_FRAC);
+  set.type = MAS_FILTER_HIGHPASS;
+  MAS_Biquad_Set(&high, &set, RATE);
+  MAS_Biquad_Run(&high, dc.data(), dc.size());
+  MAS_CHECK(dc.back() == 0 && dc[dc.size() - 100] == 0);
+  set.type = MAS_FILTER_OFF; // clears the state, passes unchanged
+  MAS_Biquad_Set(&high, &set, RATE);
+  MAS_CHECK(high.x1 == 0 && high.y1 == 0 && high.rest == 0);
+  std::vector<int32_t> same = {5, -7, 32767 << MAS_MIX_FRAC, -9};
+  MAS_Biquad_Run(&high, same.data(), same.size());
+  MAS_CHECK(same[0] == 5 && same[1] == -7 && same[2] == 32767 << MAS_MIX_FRAC && same[3] == -9);
+  //--------------------------------------------------------------------------------saturation
+  set.type = MAS_FILTER_PEAK;
+  set.freq = 1000;
+  set.gain = 12;
+  MAS_Biquad loud;
+  MAS_Biquad_Set(&loud, &set, RATE);
+  std::vector<int16_t> tone = Test_Tone(1000, RATE, 4410, 30000);
+  MAS_Biquad_Run16(&loud, tone.data(), tone.size());
+  // A wrap would step by about 65536, the clipped tone steps by at most its slope.
+  int wrong = 0, clipped = 0;
+  for (int i = 1; i < 4410; i++) {
+    wrong += abs(tone[i] - tone[i - 1]) > 2 * M_PI * 1000 / RATE * 30000 * 4;
+    clipped += tone[i] == 32767 || tone[i] == -32768;
+  }
+  MAS_CHECK(wrong == 0 && clipped > 0);
+  //-----------------------------------------------------------------------------------limiter
+  // threshold 128: a tone of 3 * 20000 is limited, a quiet tone passes delayed and unchanged.
+  MAS_Limiter limiter;
+  MAS_Limiter_Set(&limiter, 128, 2205);
+  int32_t threshold = (128 * 32767 / 255) << MAS_MIX_FRAC;
+  const int delay = 2 * MAS_LIMIT_STEP, len = RATE;
+  std::vector<int32_t> in(len), out(len);
+  for (int i = 0; i < len; i++) {
+    double amp = i < len / 4 || i >= len / 2 ? 4000 : 60000;
+    in[i] = lrint(amp * sin(2 * M_PI * 300 * i / RATE)) * (1 << MAS_MIX_FRAC);
+  }
+  out = in;
+  for (int i = 0; i < len; i += 100) {
+    MAS_Limiter_Run(&limiter, out.data() + i, NULL, len - i < 100 ? len - i : 100);
+  }
+  int above = 0, differ = 0, quiet_differ = 0;
+  for (int i = 0; i < len; i++) {
+    above += abs(out[i]) > threshold;
+    if (i >= delay) {
+      differ += i < len / 4 && out[i] != in[i - delay]; // the look-ahead ramps a step before
+      quiet_differ += i > len / 2 + 2205 + 4 * MAS_LIMIT_STEP && out[i] != in[i - delay];
+    }
+  }
+  MAS_CHECK(above == 0);
+  MAS_CHECK(differ == 0 && quiet_differ == 0); // back to 0dB after the release
+  MAS_CHECK(out[delay - 1] == 0);
+  //-------------------------------------------------------------------------------------class
+  // Three channels of a DC at 20000 sum to 60000: clipped without, limited with the limiter.
+  std::vector<int16_t> dc16(4000, 20000);
+  MAS_CHECK(Test_Write_WAV("/dc.wav", dc16.data(), dc16.size(), RATE, 1));
+  Test_Output output(1 << 16);
+  ESP32_MAS<4> audio;
+  audio.setOutput(&output);
+  for (int h = 0; h < 3; h++) {
+    audio.setGain(h, 255);
+    audio.loopFile(h, "/dc.wav");
+  }
+  audio.renderOffline(0.05f);
+  MAS_CHECK(output.Buf[output.Count - 1] == 32767);
+  audio.setLimiter(230, 100);
+  audio.renderOffline(0.05f);
+  int32_t limited = output.Buf[output.Count - 1];
+  MAS_CHECK(limited <= 230 * 32767 / 255 && limited > 230 * 32767 / 255 - 2);
+  // A high pass on a channel takes its DC out.
+  audio.setLimiter(0, 0);
+  audio.setFilter(0, 1, MAS_FILTER_HIGHPASS, 50, 0.7071f, 0);
+  audio.stopChan(1);
+  audio.stopChan(2);
+  audio.renderOffline(0.5f);
+  MAS_CHECK(abs(output.Buf[output.Count - 1]) <= 1);
+  return Test_Done("Test_Filter");
+}
@@ -0,0 +1,123 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Idle player: without a playing channel the player sleeps after Block_Count silent blocks and
+  renders nothing until a command. A single command, a batch and the destructor wake it at
+  once, not after a tick of polling: the median time from the command to the wake is far
+  below 1 ms. getStats counts every sleep, and every channel block not mixed once, also in
+  blocks split by scheduled commands.
+  -------------------------------------------------------------------------------------------*/
+#include <algorithm>
+#include "MAS_Test.h"
+
+#define BLOCK_US (256 * 1000000 / 22050)
+
+// Keeps the time the player woke up.
+class Idle_Output : public Test_Output {
+  public:
+    Idle_Output() : Test_Output(1024, BLOCK_US) {};
+    void idle(bool on) {
+      Test_Output::idle(on);
+      if (!on) {
+        Woke_At = MAS_Micros();
+        Wakes++;
+      }
+    };
+    std::atomic<uint32_t> Woke_At{0};
+    std::atomic<uint32_t> Wakes{0};
+};
+
+// Waits up to a second for the player to sleep for the time sleeps.
+static bool Wait_Idle(Idle_Output *output, uint32_t sleeps) {
+  for (int i = 0; i < 1000 && output->Idles < sleeps; i++) {
+    usleep(1000);
+  }
+  usleep(20000); // the player reached its wait
+  return output->Idles == sleeps;
+}
+// us from the command of send to the wake of the player.
+template <typename Send> static uint32_t Wake_Time(Idle_Output *output, Send send) {
+  uint32_t wakes = output->Wakes;
+  uint32_t start = MAS_Micros();
+  send();
+  for (int i = 0; i < 1000 && output->Wakes == wakes; i++) {
+    usleep(100);
+  }
+  return output->Wakes > wakes ? output->Woke_At - start : 1000000;
+}
+
+int main() {
+  MAS_Set_Root(Test_Dir().c_str());
+  std::vector<int16_t> dc(4000, 8000);
+  MAS_CHECK(Test_Write_WAV("/dc.wav", dc.data(), dc.size(), 22050, 1));
+  //-------------------------------------------------------------------------------------sleep
+  Idle_Output output;
+  ESP32_MAS<4> *audio = new ESP32_MAS<4>;
+  audio->setOutput(&output);
+  audio->setBuffer(256, 4);
+  audio->startDAC();
+  MAS_CHECK(Wait_Idle(&output, 1));
+  uint32_t blocks = output.Blocks;
+  usleep(100000);
+  MAS_CHECK(output.Blocks == blocks && blocks >= 4); // nothing rendered while asleep
+  //--------------------------------------------------------------------------------------wake
+  std::vector<uint32_t> times;
+  for (int i = 0; i < 9; i++) {
+    times.push_back(Wake_Time(&output, [&]() {
+      audio->setGain(0, i);
+    }));
+    MAS_CHECK(Wait_Idle(&output, i + 2));
+  }
+  std::sort(times.begin(), times.end());
+  printf("wake by a command: median %u us, max %u us\n", times[4], times[8]);
+  MAS_CHECK(times[4] < 150);
+  uint32_t batch = Wake_Time(&output, [&]() {
+    audio->beginBatch();
+    audio->setGain(1, 100);
+    audio->setPan(1, 20);
+    audio->sendBatch();
+  });
+  MAS_CHECK(batch < 100000);
+  MAS_CHECK(Wait_Idle(&output, 11));
+  MAS_Stats stats;
+  MAS_CHECK(audio->getStats(&stats) && stats.idle == 10); // counted when the player wakes
+  blocks = output.Blocks;
+  audio->playFile(0, "/dc.wav"); // plays 4000 samples, then sleeps again
+  MAS_CHECK(Wait_Idle(&output, 12));
+  MAS_CHECK(output.Blocks >= blocks + 4000 / 256 + 4);
+  //-------------------------------------------------------------------------------destructor
+  uint32_t start = MAS_Micros();
+  delete audio; // wakes the sleeping player
+  uint32_t end_time = MAS_Micros() - start;
+  printf("destructor of a sleeping player: %u us\n", end_time);
+  MAS_CHECK(end_time < 100000 && output.Ends == 1);
+  //-----------------------------------------------------------------------------------skipped
+  // 1 of 4 channels plays, a scheduled command splits every block in 2 parts.
+  Test_Output offline(4096);
+  ESP32_MAS<4> split;
+  split.setOutput(&offline);
+  split.setGain(0, 255);
+  MAS_CHECK(split.preloadFile("/dc.wav"));
+  split.loopFile(0, "/dc.wav");
+  split.renderOffline(0.05f);
+  split.resetStats();
+  for (int b = 0; b < 20; b++) {
+    split.scheduleAt(split.getClock() + 100);
+    split.setGain(0, 200 + b);
+    split.scheduleNow();
+    split.renderOffline(256 / 22050.0f);
+  }
+  MAS_CHECK(split.getStats(&stats) && stats.render.count == 20);
+  MAS_CHECK(stats.skipped == 3 * 20);
+  return Test_Done("Test_Idle");
+}
@@ -0,0 +1,95 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Mixing kernels: the unrolled kernels of MAS_Mixer.h give the same bits as their scalar
+  references for every length, full scale samples, gains and ramps, 0 dB passes the samples
+  and the output saturates.
+  -------------------------------------------------------------------------------------------*/
+#include "MAS_Test.h"
+#include "MAS_Mixer.h"
+
+#define MIX_LEN 1030 // longest block of the test
+
+static uint32_t Random = 12345;
+static int32_t Next(int32_t low, int32_t high) {
+  Random = Random * 1103515245u + 12345u;
+  return low + (int32_t)((Random >> 8) % (uint32_t)(high - low + 1));
+}
+static std::vector<int16_t> Samples(int len) {
+  std::vector<int16_t> in(len);
+  for (int i = 0; i < len; i++) {
+    int kind = Next(0, 9);
+    in[i] = kind == 0 ? 32767 : kind == 1 ? -32768 : Next(-32768, 32767);
+  }
+  return in;
+}
+static int32_t Gain() {
+  int kind = Next(0, 4);
+  return kind == 0 ? 0 : kind == 1 ? 32768 : Next(0, 32768);
+}
+//-----------------------------------------------------------------------------------kernels
+static void Kernels(int len) {
+  std::vector<int16_t> in = Samples(len);
+  std::vector<int32_t> acc(len), ref(len), bus(len);
+  std::vector<int16_t> out(2 * len + 1, 7), out_ref(2 * len + 1, 7);
+  for (int i = 0; i < len; i++) {
+    acc[i] = ref[i] = Next(-(1 << 22), 1 << 22);
+    bus[i] = Next(-(1 << 23), 1 << 23);
+  }
+  int32_t gain = Gain(), from = Gain(), to = Gain();
+  MAS_Mix_Add(acc.data(), in.data(), gain, len);
+  MAS_Mix_Add_Ref(ref.data(), in.data(), gain, len);
+  MAS_CHECK(acc == ref);
+  MAS_Mix_Ramp(acc.data(), in.data(), from, to, len);
+  MAS_Mix_Ramp_Ref(ref.data(), in.data(), from, to, len);
+  MAS_CHECK(acc == ref);
+  MAS_Mix_Ramp(acc.data(), in.data(), to, from, len);
+  MAS_Mix_Ramp_Ref(ref.data(), in.data(), to, from, len);
+  MAS_CHECK(acc == ref);
+  MAS_Mix_Bus(acc.data(), bus.data(), from, to, len);
+  MAS_Mix_Bus_Ref(ref.data(), bus.data(), from, to, len);
+  MAS_CHECK(acc == ref);
+  MAS_Mix_Out(acc.data(), out.data(), len);
+  MAS_Mix_Out_Ref(ref.data(), out_ref.data(), len);
+  MAS_CHECK(out == out_ref);
+  MAS_Mix_Out_Stereo(acc.data(), bus.data(), out.data(), len);
+  MAS_Mix_Out_Stereo_Ref(ref.data(), bus.data(), out_ref.data(), len);
+  MAS_CHECK(out == out_ref);
+  MAS_CHECK(out[2 * len] == 7); // nothing written after the last frame
+}//                                                                                  kernels
+
+int main() {
+  for (int len = 0; len <= 40; len++) {
+    Kernels(len);
+  }
+  for (int r = 0; r < 200; r++) {
+    Kernels(Next(41, MIX_LEN));
+  }
+  //------------------------------------------------------------------------0 dB and saturation
+  std::vector<int16_t> in = Samples(256), out(256);
+  std::vector<int32_t> acc(256);
+  MAS_Mix_Clear(acc.data(), 256);
+  MAS_Mix_Add(acc.data(), in.data(), MAS_Gain_Q15(255), 256);
+  MAS_Mix_Out(acc.data(), out.data(), 256);
+  MAS_CHECK(out == in);
+  MAS_Mix_Ramp(acc.data(), in.data(), 32768, 32768, 256); // twice the samples
+  MAS_Mix_Out(acc.data(), out.data(), 256);
+  int same = 0;
+  for (int i = 0; i < 256; i++) {
+    int32_t twice = 2 * in[i] > 32767 ? 32767 : 2 * in[i] < -32768 ? -32768 : 2 * in[i];
+    same += out[i] == twice;
+  }
+  MAS_CHECK(same == 256);
+  MAS_CHECK(MAS_Gain_Q15(0) == 0 && MAS_Gain_Q15(255) == 32768);
+  return Test_Done("Test_Mixer");
+}
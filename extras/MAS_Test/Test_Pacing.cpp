@@ -0,0 +1,82 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Block pacing: with an output that waits the duration of a block like a DMA buffer the player
+  renders one block of setBuffer per wait, in real time, and sleeps in between (the process
+  uses a fraction of the CPU time). The render time, getLoad and the block statistics count
+  every block.
+  -------------------------------------------------------------------------------------------*/
+#include <time.h>
+#include "MAS_Test.h"
+
+#define PACING_US 500000 // run time of a case
+
+static double Seconds(clockid_t clock) {
+  struct timespec now;
+  clock_gettime(clock, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+//-----------------------------------------------------------------------------------------case
+static void Paced(uint16_t block, uint8_t count) {
+  uint32_t block_us = block * 1000000ull / 22050;
+  Test_Output output(1 << 17, block_us);
+  ESP32_MAS<2> *audio = new ESP32_MAS<2>;
+  MAS_Stats stats;
+  audio->setOutput(&output);
+  audio->setBuffer(block, count);
+  MAS_CHECK(audio->preloadFile("/tone.wav"));
+  audio->loopFile(0, "/tone.wav");
+  double wall = Seconds(CLOCK_MONOTONIC);
+  double cpu = Seconds(CLOCK_PROCESS_CPUTIME_ID);
+  audio->startDAC();
+  usleep(PACING_US);
+  wall = Seconds(CLOCK_MONOTONIC) - wall;
+  cpu = Seconds(CLOCK_PROCESS_CPUTIME_ID) - cpu;
+  uint32_t blocks = output.Blocks;
+  MAS_CHECK(audio->getStats(&stats));
+  uint32_t render_time = audio->getRenderTime();
+  uint32_t render_max = audio->getRenderMax();
+  float load = audio->getLoad();
+  delete audio;
+  printf("block %4d x %d: %3u blocks in %.2f s, render %u us (max %u us), load %.2f %%, "
+         "CPU %.1f %%\n", block, count, blocks, wall, render_time, render_max, load,
+         cpu * 100 / wall);
+  //------------------------------------------------------------------------------real time
+  double expect = wall * 22050 / block;
+  MAS_CHECK(blocks > expect * 0.6 && blocks < expect * 1.1 + 2);
+  MAS_CHECK(output.Count == output.Blocks * block); // also the blocks after the snapshot
+  MAS_CHECK(cpu < wall * 0.5); // sleeps in wait, does not spin
+  //--------------------------------------------------------------------------render time
+  MAS_CHECK(render_max > 0 && render_max >= render_time && render_time < block_us); // us
+  MAS_CHECK(load >= 0 && load < 100);
+  uint32_t load_blocks = 0;
+  for (int i = 0; i < MAS_LOAD_STEPS; i++) {
+    load_blocks += stats.load[i];
+  }
+  MAS_CHECK(stats.render.count + 1 >= blocks && stats.render.count <= blocks + 1);
+  MAS_CHECK(load_blocks == stats.render.count);
+  MAS_CHECK(stats.stage[MAS_STAGE_MIX].count == stats.render.count);
+  MAS_CHECK(stats.render.min <= stats.render.max && stats.render.max <= stats.block_cycles);
+  MAS_CHECK(stats.block_cycles == (uint64_t)block * stats.cycle_rate / 22050);
+  MAS_CHECK(stats.late == 0 && stats.dropped == 0);
+}//                                                                                      case
+
+int main() {
+  MAS_Set_Root(Test_Dir().c_str());
+  std::vector<int16_t> tone = Test_Tone(440, 22050, 22050, 10000);
+  MAS_CHECK(Test_Write_WAV("/tone.wav", tone.data(), 22050, 22050, 1));
+  Paced(256, 4);
+  Paced(1024, 2);
+  Paced(64, 8);
+  return Test_Done("Test_Pacing");
+}
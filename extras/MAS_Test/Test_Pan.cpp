@@ -0,0 +1,124 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Pan law and buses: MAS_Pan_Q15 keeps the power of every pan (constant power, -3 dB in the
+  center), the left gain falls and the right gain rises with the pan. Rendered in stereo a DC
+  file has these gains on the left and the right samples of a frame, a pan change moves over
+  one block without a step, mono ignores the pan. A bus scales the sum of its channels by its
+  gain, a bus at 0 dB adds its channels unchanged.
+  The cost of mono against stereo is the scene mix/<voices> against stereo/<voices> of
+  MAS_Bench.
+  -------------------------------------------------------------------------------------------*/
+#include "MAS_Test.h"
+#include "MAS_Mixer.h"
+
+#define DC 16000
+
+// Last frame of a render of channel 0 looping /dc.wav at pan, left and right.
+static void Frame(ESP32_MAS<4> *audio, Test_Output *output, int8_t pan, int32_t *left,
+                  int32_t *right) {
+  audio->setPan(0, pan);
+  audio->renderOffline(0.03f);
+  *left = output->Buf[output->Count - 2];
+  *right = output->Buf[output->Count - 1];
+}
+
+int main() {
+  MAS_Set_Root(Test_Dir().c_str());
+  std::vector<int16_t> dc(2000, DC);
+  MAS_CHECK(Test_Write_WAV("/dc.wav", dc.data(), dc.size(), 22050, 1));
+  //----------------------------------------------------------------------------------pan law
+  int32_t left, right, last_left = 32768, last_right = 0;
+  int wrong = 0;
+  for (int pan = -127; pan <= 127; pan++) {
+    MAS_Pan_Q15(pan, &left, &right);
+    double power = ((double)left * left + (double)right * right) / (32768.0 * 32768.0);
+    wrong += fabs(10 * log10(power)) > 0.01;
+    wrong += left > last_left || right < last_right;
+    last_left = left;
+    last_right = right;
+  }
+  MAS_CHECK(wrong == 0);
+  MAS_Pan_Q15(-127, &left, &right); // the sine table ends at 32767
+  MAS_CHECK(left == 32767 && right == 0);
+  MAS_Pan_Q15(-128, &left, &right);
+  MAS_CHECK(left == 32767 && right == 0);
+  MAS_Pan_Q15(127, &left, &right);
+  MAS_CHECK(left == 0 && right == 32767);
+  MAS_Pan_Q15(0, &left, &right);
+  MAS_CHECK(left == right && abs(left - 23170) <= 1); // -3 dB
+  //-----------------------------------------------------------------------------stereo render
+  Test_Output output(1 << 17);
+  ESP32_MAS<4> audio;
+  audio.setOutput(&output);
+  audio.setBuffer(256, 4);
+  audio.setStereo(true);
+  audio.setGain(0, 255);
+  MAS_CHECK(audio.preloadFile("/dc.wav"));
+  audio.loopFile(0, "/dc.wav");
+  wrong = 0;
+  for (int pan : {-127, -90, -30, 0, 1, 45, 100, 127}) {
+    int32_t out_left, out_right;
+    Frame(&audio, &output, pan, &out_left, &out_right);
+    MAS_Pan_Q15(pan, &left, &right);
+    wrong += abs(out_left - DC * left / 32768) > 1 || abs(out_right - DC * right / 32768) > 1;
+  }
+  MAS_CHECK(wrong == 0);
+  //------------------------------------------------------------------------------pan change
+  Frame(&audio, &output, -127, &left, &right);
+  uint32_t start = output.Count;
+  Frame(&audio, &output, 127, &left, &right);
+  MAS_CHECK(left == 0 && abs(right - DC) <= 1);
+  int32_t step = 0;
+  wrong = 0;
+  for (uint32_t i = start; i < start + 2 * 256; i += 2) {
+    int32_t step_left = output.Buf[i] - output.Buf[i - 2];
+    int32_t step_right = output.Buf[i + 1] - output.Buf[i - 1];
+    wrong += step_left > 0 || step_right < 0;
+    step = abs(step_left) > step ? abs(step_left) : step;
+    step = abs(step_right) > step ? abs(step_right) : step;
+  }
+  MAS_CHECK(wrong == 0 && step <= DC * 2 / 256 + 2); // sin and cos over one block
+  MAS_CHECK(output.Buf[start + 2 * 256] == 0 && output.Buf[start + 2 * 256 + 1] == right);
+  //------------------------------------------------------------------------------------buses
+  audio.setPan(0, 0);
+  audio.setGain(1, 255);
+  audio.setPan(1, 0);
+  audio.loopFile(1, "/dc.wav");
+  audio.setBus(0, 1);
+  audio.setBus(1, 1);
+  audio.setBusGain(1, 128);
+  Frame(&audio, &output, 0, &left, &right);
+  int32_t center = DC * 23170 / 32768;
+  MAS_CHECK(abs(left - 2 * center * 128 / 255) <= 2 && left == right);
+  audio.setBusGain(1, 255);
+  Frame(&audio, &output, 0, &left, &right);
+  MAS_CHECK(abs(left - 2 * center) <= 1);
+  audio.setBus(1, 0); // bus 0 at 0 dB and bus 1 at 0 dB
+  Frame(&audio, &output, 0, &left, &right);
+  MAS_CHECK(abs(left - 2 * center) <= 1);
+  audio.setBusGain(0, 0);
+  Frame(&audio, &output, 0, &left, &right);
+  MAS_CHECK(abs(left - center) <= 1);
+  //-------------------------------------------------------------------------------------mono
+  Test_Output mono_out(4096);
+  ESP32_MAS<2> mono;
+  mono.setOutput(&mono_out);
+  mono.setGain(0, 255);
+  mono.setPan(0, -127);
+  MAS_CHECK(mono.preloadFile("/dc.wav"));
+  mono.loopFile(0, "/dc.wav");
+  mono.renderOffline(0.05f);
+  MAS_CHECK(mono_out.Buf[mono_out.Count - 1] == DC && mono_out.Buf[mono_out.Count - 2] == DC);
+  return Test_Done("Test_Pan");
+}
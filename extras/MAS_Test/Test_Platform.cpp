@@ -0,0 +1,137 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Host platform and lifetime of the sound system: renders of examples/data are the same in
+  every run, from the sample cache and from the file system, the WAVE output writes the same
+  samples, and the destructor ends the tasks and frees everything (run_tests.sh asan checks
+  the leaks).
+  -------------------------------------------------------------------------------------------*/
+#include "MAS_Test.h"
+
+#define PLATFORM_SAMPLES 22050
+// FNV-1a of Render_Scene, changes only with an intended change of the output.
+#define PLATFORM_HASH 0xfd44caaau
+
+//-------------------------------------------------------------------------------------scene
+// Two voices of examples/data with gain and pitch ramps, LINEAR. Returns the frames.
+static uint32_t Render_Scene(MAS_Output *output, bool cached) {
+  static const char *const files[] = {"/E_engine3.aiff", "/makrofon_in.aiff", "/E_brake.aiff"};
+  ESP32_MAS<4> *audio = new ESP32_MAS<4>;
+  audio->setOutput(output);
+  for (int i = 0; i < 3 && cached; i++) {
+    MAS_CHECK(audio->preloadFile(files[i]));
+  }
+  audio->setGain(0, 200);
+  audio->setGain(1, 180);
+  audio->setGain(2, 255);
+  audio->setPitch(1, 0.3f);
+  audio->loopFile(0, files[0]);
+  audio->playFile(1, files[1]);
+  uint32_t frames = audio->renderOffline(0.3f);
+  audio->rampGain(0, 60, 100);
+  audio->rampPitch(1, -0.2f, 150);
+  audio->playFile(2, files[2]);
+  frames += audio->renderOffline(0.7f);
+  delete audio;
+  return frames;
+}
+static std::vector<int16_t> Render_RAM(bool cached) {
+  Test_Output output(PLATFORM_SAMPLES);
+  Render_Scene(&output, cached);
+  MAS_CHECK(output.Count == PLATFORM_SAMPLES);
+  MAS_CHECK(output.Ends == 0); // renderOffline does not end the output
+  return output.Buf;
+}//                                                                                    scene
+//-------------------------------------------------------------------------------WAVE output
+// Reads back the WAVE file of the scene, completed by end or by the destructor.
+static void WAV_Output(const std::vector<int16_t> &reference, bool end) {
+  std::string name = Test_Dir() + "/scene.wav";
+  uint32_t frames;
+  Test_Files.push_back("/scene.wav");
+  {
+    MAS_WAV_Output wav(name.c_str());
+    frames = Render_Scene(&wav, true);
+    if (end) {
+      wav.end();
+    }
+  }
+  FILE *file = fopen(name.c_str(), "rb");
+  MAS_CHECK(file != NULL);
+  if (file == NULL) {
+    return;
+  }
+  std::vector<uint8_t> data(44 + frames * 2 + 1);
+  size_t len = fread(data.data(), 1, data.size(), file);
+  fclose(file);
+  MAS_CHECK(frames >= PLATFORM_SAMPLES && len == 44 + frames * 2);
+  MAS_CHECK(memcmp(data.data(), "RIFF", 4) == 0 && memcmp(data.data() + 36, "data", 4) == 0);
+  uint32_t riff = data[4] | data[5] << 8 | data[6] << 16 | data[7] << 24;
+  uint32_t bytes = data[40] | data[41] << 8 | data[42] << 16 | data[43] << 24;
+  MAS_CHECK(riff == 36 + frames * 2 && bytes == frames * 2);
+  int same = 0;
+  for (int i = 0; i < PLATFORM_SAMPLES && 44 + 2 * i + 1 < (int)len; i++) {
+    same += (int16_t)(data[44 + 2 * i] | data[45 + 2 * i] << 8) == reference[i];
+  }
+  MAS_CHECK(same == PLATFORM_SAMPLES);
+}//                                                                               WAVE output
+static uint32_t Hash(const std::vector<int16_t> &samples) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < samples.size(); i++) {
+    hash = (hash ^ (uint16_t)samples[i]) * 16777619u;
+  }
+  return hash;
+}
+//-----------------------------------------------------------------------------player task
+// Starts the tasks, plays a cached and a streamed loop and destroys the sound system.
+static void Start_Stop(bool play) {
+  Test_Output output(1 << 16, 2000);
+  ESP32_MAS<4> *audio = new ESP32_MAS<4>;
+  audio->setOutput(&output);
+  audio->setBuffer(128, 4);
+  if (play) {
+    MAS_CHECK(audio->preloadFile("/E_engine1.aiff"));
+    audio->loopFile(0, "/E_engine1.aiff");
+    audio->loopFile(1, "/makrofon_loop.aiff");
+  }
+  audio->startDAC();
+  usleep(60000);
+  MAS_CHECK(play ? audio->getState(1) > MAS_BRAKE : output.Idles > 0);
+  delete audio;
+  uint32_t blocks = output.Blocks;
+  MAS_CHECK(blocks > 0);
+  MAS_CHECK(output.Begins == 1 && output.Ends == 1);
+  usleep(10000);
+  MAS_CHECK(output.Blocks == blocks); // no block after the destructor
+}//                                                                              player task
+
+int main() {
+  MAS_Set_Root("examples/data");
+  //------------------------------------------------------------------------------renders
+  std::vector<int16_t> cached = Render_RAM(true);
+  std::vector<int16_t> streamed = Render_RAM(false);
+  MAS_CHECK(cached == streamed);
+  MAS_CHECK(Render_RAM(true) == cached);
+  printf("scene hash %08x\n", Hash(cached));
+  MAS_CHECK(Hash(cached) == PLATFORM_HASH);
+  WAV_Output(cached, true);
+  WAV_Output(cached, false);
+  //-----------------------------------------------------------------------------lifetime
+  for (int i = 0; i < 3; i++) {
+    Start_Stop(true);
+  }
+  Start_Stop(false); // the player sleeps
+  {
+    ESP32_MAS<2> unused; // no startDAC and no renderOffline
+  }
+  return Test_Done("Test_Platform");
+}
@@ -0,0 +1,119 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  MAS_Queue: a producer thread pushes numbered items one by one and in batches, a consumer
+  thread pops them. Every item arrives once, in order and whole, a batch arrives at once.
+  A full queue refuses an item and a batch without room refuses all of its items.
+  -------------------------------------------------------------------------------------------*/
+#include <thread>
+#include "MAS_Test.h"
+#include "MAS_Queue.h"
+
+#define QUEUE_ITEMS 400000
+
+struct Test_Item {
+  uint32_t seq = 0;
+  uint32_t batch_left = 0; // items of the batch after this one
+  uint32_t check[6] = {}; // derived from seq, a torn item does not match
+};
+static Test_Item Make(uint32_t seq, uint32_t batch_left) {
+  Test_Item item;
+  item.seq = seq;
+  item.batch_left = batch_left;
+  for (int i = 0; i < 6; i++) {
+    item.check[i] = seq * 2654435761u + i;
+  }
+  return item;
+}
+static bool Same(const Test_Item &item, uint32_t seq, uint32_t batch_left) {
+  Test_Item expect = Make(seq, batch_left);
+  return memcmp(&item, &expect, sizeof(item)) == 0;
+}
+//-------------------------------------------------------------------------------two threads
+template <uint32_t SIZE> static void Stress(bool batches) {
+  MAS_Queue<Test_Item, SIZE> *queue = new MAS_Queue<Test_Item, SIZE>;
+  uint32_t wrong = 0, split = 0;
+  std::thread producer([&] {
+    Test_Item items[8];
+    uint32_t seq = 0;
+    uint32_t random = 1;
+    while (seq < QUEUE_ITEMS) {
+      random = random * 1103515245u + 12345u;
+      uint32_t count = batches ? 1 + (random >> 16) % 8 : 1;
+      count = count < QUEUE_ITEMS - seq ? count : QUEUE_ITEMS - seq;
+      for (uint32_t i = 0; i < count; i++) {
+        items[i] = Make(seq + i, count - 1 - i);
+      }
+      bool pushed = count == 1 && !batches ? queue->push(items[0]) : queue->push(items, count);
+      if (pushed) {
+        seq += count;
+      }
+      else {
+        std::this_thread::yield();
+      }
+    }
+  });
+  uint32_t expect = 0;
+  Test_Item item;
+  while (expect < QUEUE_ITEMS) {
+    if (!queue->pop(&item)) {
+      std::this_thread::yield();
+      continue;
+    }
+    wrong += !Same(item, expect, item.batch_left);
+    expect++;
+    for (uint32_t left = item.batch_left; left > 0; left--) {
+      //-----------------------------------------------------the rest of the batch is already there
+      if (!queue->pop(&item)) {
+        split++;
+        break;
+      }
+      wrong += !Same(item, expect, left - 1);
+      expect++;
+    }
+  }
+  producer.join();
+  MAS_CHECK(wrong == 0 && split == 0);
+  MAS_CHECK(queue->pushed() == QUEUE_ITEMS && queue->popped() == QUEUE_ITEMS);
+  MAS_CHECK(!queue->pop(&item)); // nothing duplicated
+  delete queue;
+}//                                                                               two threads
+
+int main() {
+  //------------------------------------------------------------------------------------full
+  MAS_Queue<Test_Item, 8> *queue = new MAS_Queue<Test_Item, 8>;
+  Test_Item items[8], item;
+  for (uint32_t i = 0; i < 8; i++) {
+    items[i] = Make(i, 0);
+  }
+  MAS_CHECK(queue->push(items, 5));
+  MAS_CHECK(!queue->push(items, 4)); // 3 free
+  MAS_CHECK(queue->pushed() == 5);
+  MAS_CHECK(queue->push(items, 3));
+  MAS_CHECK(!queue->push(items[0]));
+  MAS_CHECK(queue->pop(&item) && item.seq == 0);
+  MAS_CHECK(queue->push(items[7]));
+  MAS_CHECK(queue->popped() == 1 && queue->pushed() == 9);
+  delete queue;
+  //------------------------------------------------------------------------------two threads
+  Stress<64>(false);
+  Stress<64>(true);
+  Stress<8>(true); // batches up to the whole queue
+  MAS_Command_Queue commands; // the real item, pushed and popped in one thread
+  MAS_Command command;
+  command.type = MAS_CMD_PLAY;
+  strcpy(command.file, "/file.wav");
+  MAS_CHECK(commands.push(command) && commands.pop(&command));
+  MAS_CHECK(command.type == MAS_CMD_PLAY && strcmp(command.file, "/file.wav") == 0);
+  return Test_Done("Test_Queue");
+}
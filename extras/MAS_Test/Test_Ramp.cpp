@@ -0,0 +1,180 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Ramps and envelopes: MAS_Ramp reaches its target exactly in the block the ramp ends and moves
+  monotonically for every block length, the envelope passes its stages with the levels at
+  their ends. Rendered from a DC file, rampGain, rampVolume and the envelope move monotonically
+  without a step above the slope of the ramp (no click), rampPitch raises the speed block by
+  block to its target.
+  -------------------------------------------------------------------------------------------*/
+#include "MAS_Test.h"
+#include "MAS_Ramp.h"
+
+#define DC 16000
+
+// Monotonic between from and to, reaching to at block end_block (ceil of samples / block).
+static void Ramp(int32_t from, int32_t to, uint32_t samples, uint32_t block) {
+  MAS_Ramp ramp;
+  MAS_Ramp_Set(&ramp, from, 0);
+  MAS_Ramp_Set(&ramp, to, samples);
+  uint32_t blocks = (samples + block - 1) / block;
+  int32_t last = from;
+  int wrong = 0;
+  for (uint32_t b = 1; b <= blocks + 2; b++) {
+    int32_t value = MAS_Ramp_Next(&ramp, block);
+    wrong += to >= from ? value < last || value > to : value > last || value < to;
+    wrong += from != to && (b >= blocks) != (value == to);
+    last = value;
+  }
+  MAS_CHECK(wrong == 0);
+}
+//-----------------------------------------------------------------------------------render
+struct Render_Result {
+  std::vector<int16_t> out;
+  int32_t step = 0; // largest step between two samples after start
+  bool monotonic = true;
+};
+// Looks at the output from start to end for a move in the direction of to - from.
+static Render_Result Look(const std::vector<int16_t> &out, uint32_t start, uint32_t end,
+                          int32_t from, int32_t to) {
+  Render_Result result;
+  result.out = out;
+  for (uint32_t i = start + 1; i < end; i++) {
+    int32_t step = out[i] - out[i - 1];
+    result.step = abs(step) > result.step ? abs(step) : result.step;
+    result.monotonic &= to >= from ? step >= 0 : step <= 0;
+  }
+  return result;
+}
+
+int main() {
+  MAS_Set_Root(Test_Dir().c_str());
+  std::vector<int16_t> dc(4000, DC), rise(30000);
+  for (int i = 0; i < 30000; i++) {
+    rise[i] = i;
+  }
+  MAS_CHECK(Test_Write_WAV("/dc.wav", dc.data(), dc.size(), 22050, 1));
+  MAS_CHECK(Test_Write_WAV("/rise.wav", rise.data(), rise.size(), 22050, 1));
+  //---------------------------------------------------------------------------------MAS_Ramp
+  for (uint32_t block : {1u, 64u, 100u, 256u, 1024u}) {
+    Ramp(0, 32768, 22050, block);
+    Ramp(32768, 0, 1000, block);
+    Ramp(-500, 700, 333, block);
+    Ramp(7, 7, 500, block);
+  }
+  MAS_Ramp ramp;
+  MAS_Ramp_Set(&ramp, 1000, 0);
+  MAS_CHECK(MAS_Ramp_Next(&ramp, 256) == 1000);
+  MAS_Ramp_Set(&ramp, 2000, 1000);
+  MAS_Ramp_Next(&ramp, 500);
+  MAS_Ramp_Set(&ramp, 0, 100); // a new ramp starts from the current value
+  MAS_CHECK(ramp.value == 1500 && MAS_Ramp_Next(&ramp, 50) == 750);
+  //---------------------------------------------------------------------------------envelope
+  MAS_Envelope env;
+  env.attack = 1000;
+  env.decay = 2000;
+  env.sustain = 16384;
+  env.release = 3000;
+  MAS_Envelope_Start(&env);
+  int32_t last = 0;
+  int wrong = 0;
+  for (uint32_t pos = 256; pos <= 256 * 20; pos += 256) {
+    int32_t level = MAS_Envelope_Next(&env, 256);
+    wrong += pos < 1000 ? level < last : pos > 1256 && level > last; // the peak in block 4
+    wrong += pos >= 3000 && (level != 16384 || env.stage != MAS_ENV_SUSTAIN);
+    last = level;
+  }
+  MAS_Envelope_Release(&env);
+  for (uint32_t pos = 256; pos <= 256 * 12; pos += 256) {
+    int32_t level = MAS_Envelope_Next(&env, 256);
+    wrong += level > last || (pos >= 3000) != (level == 0 && env.stage == MAS_ENV_END);
+    last = level;
+  }
+  MAS_CHECK(wrong == 0);
+  //---------------------------------------------------------------------------------rampGain
+  // 200 ms = 4410 samples from DC to 0 in blocks of 256: at most DC / 4410 per sample.
+  Test_Output output(1 << 16);
+  ESP32_MAS<2> *audio = new ESP32_MAS<2>;
+  audio->setOutput(&output);
+  audio->setBuffer(256, 4);
+  audio->setCache(1 << 18);
+  audio->setGain(0, 255);
+  MAS_CHECK(audio->preloadFile("/dc.wav") && audio->preloadFile("/rise.wav"));
+  audio->loopFile(0, "/dc.wav");
+  audio->renderOffline(0.05f);
+  uint32_t start = output.Count;
+  audio->rampGain(0, 0, 200);
+  audio->renderOffline(0.3f);
+  Render_Result gain = Look(output.Buf, start - 1, output.Count, DC, 0);
+  MAS_CHECK(output.Buf[start - 1] == DC && output.Buf[output.Count - 1] == 0);
+  MAS_CHECK(gain.monotonic && gain.step <= DC / 4410 + 2);
+  MAS_CHECK(gain.out[start + 4608] == 0 && gain.out[start + 4095] != 0); // ends in block 18
+  MAS_CHECK(audio->getGain(0) == 0);
+  //-------------------------------------------------------------------------------rampVolume
+  audio->setGain(0, 255);
+  audio->renderOffline(0.05f);
+  start = output.Count;
+  audio->rampVolume(0, 100);
+  audio->renderOffline(0.2f);
+  Render_Result volume = Look(output.Buf, start - 1, output.Count, DC, 0);
+  MAS_CHECK(output.Buf[start - 1] == DC && output.Buf[output.Count - 1] == 0);
+  MAS_CHECK(volume.monotonic && volume.step <= DC / 2205 + 2);
+  audio->rampVolume(255, 100);
+  start = output.Count;
+  audio->renderOffline(0.2f);
+  volume = Look(output.Buf, start - 1, output.Count, 0, DC);
+  MAS_CHECK(volume.monotonic && volume.step <= DC / 2205 + 2);
+  MAS_CHECK(output.Buf[output.Count - 1] == DC);
+  //--------------------------------------------------------------------------------rampPitch
+  // rise.wav goes up by 1 per sample, the output by the speed.
+  audio->stopChan(0);
+  audio->loopFile(0, "/rise.wav");
+  audio->renderOffline(0.02f);
+  start = output.Count;
+  audio->rampPitch(0, 1, 100); // speed 1 to 2 over 9 blocks
+  audio->renderOffline(0.2f);
+  double speed = 1;
+  wrong = 0;
+  for (uint32_t b = 0; b < 12; b++) {
+    uint32_t at = start + b * 256;
+    double now = (output.Buf[at + 255] - output.Buf[at]) / 255.0;
+    wrong += now < speed - 0.01 || now > 2.01;
+    speed = now;
+  }
+  MAS_CHECK(wrong == 0 && speed > 1.99);
+  MAS_CHECK(audio->getPitch(0) == 1);
+  //---------------------------------------------------------------------------------envelope
+  // attack 50 ms, decay 50 ms to 128 / 255, release 100 ms.
+  audio->stopChan(0);
+  audio->setPitch(0, 0);
+  audio->renderOffline(0.02f);
+  audio->setEnvelope(0, 50, 50, 128, 100);
+  audio->loopFile(0, "/dc.wav");
+  start = output.Count;
+  audio->renderOffline(0.3f);
+  uint32_t peak = start + 1102;
+  Render_Result attack = Look(output.Buf, start, peak - 256, 0, DC);
+  Render_Result decay = Look(output.Buf, peak + 256, start + 2205, DC, 0);
+  MAS_CHECK(attack.monotonic && attack.step <= DC / 1102 + 2);
+  MAS_CHECK(decay.monotonic && decay.step <= DC / 1102 + 2);
+  int32_t sustain = output.Buf[output.Count - 1];
+  MAS_CHECK(abs(sustain - DC * 128 / 255) <= 2);
+  start = output.Count;
+  audio->releaseChan(0);
+  audio->renderOffline(0.2f);
+  Render_Result release = Look(output.Buf, start - 1, output.Count, sustain, 0);
+  MAS_CHECK(release.monotonic && release.step <= sustain / 2205 + 2);
+  MAS_CHECK(output.Buf[output.Count - 1] == 0 && audio->getState(0) == MAS_STOP);
+  delete audio;
+  return Test_Done("Test_Ramp");
+}
@@ -0,0 +1,94 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Resampler: an aliasing sweep of tones that land above the output Nyquist frequency after the
+  pitch, LINEAR against BOX. Everything BOX puts out of such a tone is aliasing, it must be
+  lower than with LINEAR, tones below Nyquist keep their level. The sweep is printed as a
+  table. Up to normal speed BOX is
+  LINEAR, cached and streamed files give the same samples.
+  -------------------------------------------------------------------------------------------*/
+#include "MAS_Test.h"
+#include "MAS_Resampler.h"
+
+#define TONE_LEN 40000
+
+// RMS in dB of full scale of a voice at speed playing the tone file, from sample 512 on.
+static double Level(const char *file, float speed, uint8_t mode, bool cached,
+                    std::vector<int16_t> *samples = NULL) {
+  Test_Output output(8192);
+  ESP32_MAS<2> audio;
+  audio.setOutput(&output);
+  audio.setCache(2 * TONE_LEN + 64);
+  audio.setInterpolation(mode);
+  audio.setGain(0, 255);
+  audio.setPitch(0, speed - 1);
+  if (cached) {
+    MAS_CHECK(audio.preloadFile(file));
+  }
+  audio.playFile(0, file);
+  audio.renderOffline(8192 / 22050.0f);
+  double sum = 0;
+  for (int i = 512; i < 8192; i++) {
+    sum += (double)output.Buf[i] * output.Buf[i];
+  }
+  if (samples != NULL) {
+    *samples = output.Buf;
+  }
+  return 10 * log10(sum / (8192 - 512) / (32767.0 * 32767.0 / 2) + 1e-12);
+}
+static bool Write_Tone(const char *name, double freq) {
+  std::vector<int16_t> tone = Test_Tone(freq, 22050, TONE_LEN, 32000);
+  return Test_Write_WAV(name, tone.data(), TONE_LEN, 22050, 1);
+}
+
+int main() {
+  MAS_Set_Root(Test_Dir().c_str());
+  //-----------------------------------------------------------------------------aliasing sweep
+  static const float speeds[] = {1.5f, 2.0f, 3.0f, 4.0f};
+  static const double outs[] = {12000, 14000, 17000, 20000, 26000, 32000, 40000};
+  printf("%-8s %-10s %-10s %10s %10s\n", "speed", "tone Hz", "out Hz", "LINEAR dB", "BOX dB");
+  for (float speed : speeds) {
+    for (double out : outs) {
+      double freq = out / speed;
+      if (freq >= 10000) {
+        continue; // the file keeps the tone below its Nyquist frequency
+      }
+      MAS_CHECK(Write_Tone("/tone.wav", freq));
+      double linear = Level("/tone.wav", speed, 1, true);
+      double box = Level("/tone.wav", speed, MAS_BOX, true);
+      printf("%-8.1f %-10.0f %-10.0f %10.1f %10.1f\n", speed, freq, out, linear, box);
+      MAS_CHECK(box < linear - 3);
+      MAS_CHECK(out < 17000 || box < -9); // damped least if it folds close to 11025 Hz
+    }
+  }
+  //-------------------------------------------------------------------------------pass band
+  for (float speed : speeds) {
+    MAS_CHECK(Write_Tone("/tone.wav", 2000 / speed));
+    double box = Level("/tone.wav", speed, MAS_BOX, true);
+    MAS_CHECK(box > -0.5 && box < 0.1); // 32000 of full scale = -0.2 dB
+  }
+  //---------------------------------------------------------------up to normal speed, streamed
+  std::vector<int16_t> linear, box, streamed;
+  MAS_CHECK(Write_Tone("/tone.wav", 3000));
+  for (float speed : {0.75f, 1.0f}) {
+    Level("/tone.wav", speed, 1, true, &linear);
+    Level("/tone.wav", speed, MAS_BOX, true, &box);
+    MAS_CHECK(box == linear);
+  }
+  for (float speed : {1.3f, 2.0f, 4.0f}) {
+    Level("/tone.wav", speed, MAS_BOX, true, &box);
+    Level("/tone.wav", speed, MAS_BOX, false, &streamed);
+    MAS_CHECK(box == streamed);
+  }
+  return Test_Done("Test_Resampler");
+}
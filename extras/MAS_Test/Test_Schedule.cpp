@@ -0,0 +1,216 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Scheduled commands: a file scheduled with scheduleAt starts at the exact sample of the clock,
+  inside a block, offline and from the player task. A batch starts its files in the same frame
+  and takes its gain and stop commands at their samples, a clock of the past takes effect at
+  once, a batch of more than MAS_BATCH commands is taken in one block. A scheduled voice holds
+  its channel until it has played, a file of the file system starts when the reader opened it.
+  A full schedule takes timed commands at once and counts them in unscheduled of getStats, a
+  file command lost in a full queue without a running player does not hold its channel.
+  -------------------------------------------------------------------------------------------*/
+#include "MAS_Test.h"
+#include "MAS_Mixer.h"
+
+#define BLOCK_US (256 * 1000000 / 22050)
+
+// First sample from from to to that is not 0, -1 if there is none.
+static int First_Sound(const Test_Output &output, uint32_t from, uint32_t to) {
+  for (uint32_t i = from; i < to; i++) {
+    if (output.Buf[i] != 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+// Fills the command queue without a running player, the next command is lost.
+template <uint8_t channels> static void Fill_Queue(ESP32_MAS<channels> *audio) {
+  for (int i = 0; i < MAS_COMMAND_SIZE; i++) {
+    audio->setGain(channels - 1, 255);
+  }
+}
+
+int main() {
+  MAS_Set_Root(Test_Dir().c_str());
+  std::vector<int16_t> k(3000, 8000), m(3000, -4000);
+  MAS_CHECK(Test_Write_WAV("/k.wav", k.data(), k.size(), 22050, 1));
+  MAS_CHECK(Test_Write_WAV("/m.wav", m.data(), m.size(), 22050, 1));
+  MAS_CHECK(Test_Write_WAV("/n.wav", k.data(), k.size(), 22050, 1));
+  Test_Output output(1 << 17);
+  ESP32_MAS<4> audio;
+  audio.setOutput(&output);
+  audio.setBuffer(256, 4);
+  for (int c = 0; c < 4; c++) {
+    audio.setGain(c, 255);
+  }
+  MAS_CHECK(audio.preloadFile("/k.wav") && audio.preloadFile("/m.wav"));
+  audio.renderOffline(0.04f); // 4 blocks
+  MAS_CHECK(audio.getClock() == 1024 && output.Count == 1024);
+  //----------------------------------------------------------------------onset inside a block
+  uint32_t at = audio.getClock() + 300;
+  audio.scheduleAt(at);
+  audio.playFile(0, "/k.wav");
+  audio.scheduleNow();
+  audio.renderOffline(0.13f);
+  MAS_CHECK(First_Sound(output, 0, output.Count) == (int)at);
+  MAS_CHECK(output.Buf[at] == 8000 && output.Buf[at + 2000] == 8000);
+  audio.stopChan(0);
+  audio.renderOffline(0.02f);
+  MAS_CHECK(output.Buf[output.Count - 1] == 0);
+  //------------------------------------------------------batch: same start, gain and stop
+  uint32_t base = audio.getClock();
+  at = base + 1000 + 77;
+  audio.beginBatch();
+  audio.scheduleAt(at);
+  audio.playFile(1, "/k.wav");
+  audio.playFile(2, "/m.wav");
+  audio.scheduleAt(at + 500);
+  audio.setGain(1, 0);
+  audio.scheduleAt(at + 900);
+  audio.stopChan(2);
+  audio.scheduleNow();
+  audio.sendBatch();
+  audio.renderOffline(0.2f);
+  MAS_CHECK(First_Sound(output, base, output.Count) == (int)at);
+  int together = 0;
+  for (uint32_t i = at; i < at + 500; i++) {
+    together += output.Buf[i] == 4000; // 8000 - 4000, no frame of one file alone
+  }
+  MAS_CHECK(together == 500);
+  MAS_CHECK(output.Buf[at + 499] == 4000 && output.Buf[at + 500] == -4000);
+  MAS_CHECK(output.Buf[at + 899] == -4000 && output.Buf[at + 900] == 0);
+  MAS_CHECK(audio.getState(2) == MAS_STOP);
+  audio.stopChan(1);
+  audio.setGain(1, 255);
+  //------------------------------------------------------a clock of the past, untimed batch
+  audio.renderOffline(0.02f);
+  base = audio.getClock();
+  audio.scheduleAt(base - 100);
+  audio.playFile(0, "/k.wav");
+  audio.scheduleNow();
+  audio.renderOffline(0.02f);
+  MAS_CHECK(First_Sound(output, base, output.Count) == (int)base);
+  audio.stopChan(0);
+  audio.renderOffline(0.02f);
+  base = audio.getClock();
+  audio.beginBatch();
+  audio.playFile(0, "/k.wav");
+  audio.playFile(3, "/m.wav");
+  audio.sendBatch();
+  audio.renderOffline(0.02f);
+  MAS_CHECK(output.Buf[base] == 4000);
+  audio.stopChan(0);
+  audio.stopChan(3);
+  //-----------------------------------------------------------more than MAS_BATCH commands
+  audio.beginBatch();
+  for (int i = 0; i < 40; i++) {
+    audio.setGain(0, i);
+  }
+  audio.playFile(0, "/k.wav");
+  audio.sendBatch();
+  base = audio.getClock();
+  audio.renderOffline(0.02f);
+  int32_t gain = 8000 * MAS_Gain_Q15(39) / 32768;
+  MAS_CHECK(output.Buf[base] == gain || output.Buf[base] == gain + 1);
+  audio.stopChan(0);
+  audio.setGain(0, 255);
+  audio.renderOffline(0.02f);
+  //-------------------------------------------------voices wait for their scheduled start
+  MAS_Sound_Id sound = audio.addSound("/k.wav");
+  audio.scheduleAt(audio.getClock() + 5000);
+  MAS_Voice_Handle voice = audio.playAny(sound, 10);
+  audio.scheduleNow();
+  audio.renderOffline(0.05f);
+  MAS_CHECK(voice.channel == 0 && audio.getState(0) == MAS_STOP);
+  MAS_CHECK(audio.getVoice(voice) == MAS_PLAY); // scheduled, not ended
+  MAS_CHECK(audio.playAny(sound, 10).channel == 1); // channel 0 waits for its voice
+  audio.renderOffline(0.4f);
+  MAS_CHECK(audio.getVoice(voice) == MAS_STOP); // played and ended
+  //-------------------------------------------------------a file of the file system waits
+  audio.renderOffline(0.02f);
+  base = audio.getClock();
+  audio.scheduleAt(base + 300);
+  audio.playFile(3, "/n.wav");
+  audio.scheduleNow();
+  audio.renderOffline(0.1f);
+  int spiffs = First_Sound(output, base, output.Count);
+  MAS_CHECK(spiffs >= (int)base + 300 && spiffs <= (int)base + 512);
+  audio.renderOffline(0.1f);
+  //-----------------------------------------------------------------------full schedule
+  MAS_Stats stats;
+  audio.resetStats();
+  audio.scheduleAt(audio.getClock() + 1000);
+  for (int i = 0; i < MAS_SCHEDULE + 8; i++) {
+    audio.setGain(1, i);
+  }
+  audio.scheduleNow();
+  audio.renderOffline(0.1f);
+  MAS_CHECK(audio.getStats(&stats) && stats.unscheduled == 8);
+  audio.resetStats();
+  audio.scheduleAt(audio.getClock() + 1000);
+  audio.setGain(1, 255);
+  audio.scheduleNow();
+  audio.renderOffline(0.1f);
+  MAS_CHECK(audio.getStats(&stats) && stats.unscheduled == 0);
+  //--------------------------------------------------------------------lost file commands
+  // A lost timed file command must not hold its channel for playAny.
+  ESP32_MAS<1> one;
+  Test_Output one_out(4096);
+  one.setOutput(&one_out);
+  MAS_Sound_Id one_sound = one.addSound("/k.wav");
+  one.setPriority(0, 200);
+  Fill_Queue(&one);
+  one.scheduleAt(one.getClock() + 100);
+  MAS_CHECK(one.playSound(0, one_sound).channel == -1);
+  one.scheduleNow();
+  one.renderOffline(0.02f);
+  MAS_CHECK(one.playAny(one_sound, 10).channel == 0);
+  one.stopChan(0);
+  one.renderOffline(0.02f);
+  Fill_Queue(&one);
+  one.beginBatch();
+  one.scheduleAt(one.getClock() + 100);
+  voice = one.playSound(0, one_sound);
+  one.scheduleNow();
+  one.sendBatch(); // lost
+  MAS_CHECK(one.getVoice(voice) == MAS_STOP);
+  one.renderOffline(0.02f);
+  MAS_CHECK(one.playAny(one_sound, 10).channel == 0);
+  //------------------------------------------------------------------------the player task
+  Test_Output live_out(1 << 16, BLOCK_US);
+  ESP32_MAS<4> *live = new ESP32_MAS<4>;
+  live->setOutput(&live_out);
+  live->setBuffer(256, 4);
+  for (int c = 0; c < 4; c++) {
+    live->setGain(c, 255);
+  }
+  MAS_CHECK(live->preloadFile("/k.wav") && live->preloadFile("/m.wav"));
+  live->startDAC();
+  usleep(20000);
+  at = live->getClock() + 2000;
+  live->beginBatch();
+  live->scheduleAt(at);
+  live->playFile(1, "/k.wav");
+  live->playFile(2, "/m.wav");
+  live->scheduleNow();
+  live->sendBatch();
+  for (int i = 0; i < 1000 && live_out.Count < at + 1000; i++) {
+    usleep(1000);
+  }
+  // Every block is written, the sample of the output is the sample of the clock.
+  int first = First_Sound(live_out, 0, live_out.Count);
+  printf("player task: scheduled at %u, first sound at %d\n", at, first);
+  MAS_CHECK(first == (int)at && live_out.Buf[at] == 4000 && live_out.Buf[at + 999] == 4000);
+  delete live;
+  return Test_Done("Test_Schedule");
+}
@@ -0,0 +1,123 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Gapless sequences: playFile of an intro and queueFile of a loop play the decoded intro and
+  then the decoded loop again and again, sample by sample, streamed and cached in every
+  combination, queued before the start and while the intro plays, offline and with the tasks.
+  An intro longer than the ring buffer is read while the loop is read ahead.
+  -------------------------------------------------------------------------------------------*/
+#include "MAS_Test.h"
+
+#define SEQ_LEN 22050 // samples compared
+
+static std::vector<int16_t> Decode(const char *name) {
+  std::vector<int16_t> out;
+  MAS_File file;
+  MAS_Format format;
+  if (!file.open(name) || !MAS_Read_Format(&file, &format)) {
+    return out;
+  }
+  std::vector<uint8_t> data(format.data_len);
+  int len = file.read(data.data(), format.data_len);
+  out.resize(format.decoder->samples(&format, len));
+  out.resize(format.decoder->decode(&format, data.data(), len, out.data()));
+  file.close();
+  return out;
+}
+// The intro, then the loop until SEQ_LEN samples.
+static std::vector<int16_t> Expect(const char *intro, const char *loop) {
+  std::vector<int16_t> expect = Decode(intro), part = Decode(loop);
+  MAS_CHECK(!expect.empty() && !part.empty());
+  while (!part.empty() && expect.size() < SEQ_LEN) {
+    expect.insert(expect.end(), part.begin(), part.end());
+  }
+  expect.resize(SEQ_LEN);
+  return expect;
+}
+// Samples of out from its first sample of expect that differ from expect.
+static int Differ(const std::vector<int16_t> &out, const std::vector<int16_t> &expect) {
+  size_t start = 0;
+  while (start + SEQ_LEN <= out.size() && !std::equal(expect.begin(), expect.begin() + 64,
+         out.begin() + start)) {
+    start++;
+  }
+  if (start + SEQ_LEN > out.size()) {
+    return SEQ_LEN;
+  }
+  int differ = 0;
+  for (int i = 0; i < SEQ_LEN; i++) {
+    differ += out[start + i] != expect[i];
+  }
+  return differ;
+}
+//-----------------------------------------------------------------------------------offline
+// queue_at = seconds rendered between playFile and queueFile.
+static void Offline(const char *intro, const char *loop, bool intro_cached, bool loop_cached,
+                    float queue_at) {
+  Test_Output output(SEQ_LEN);
+  ESP32_MAS<2> audio;
+  audio.setOutput(&output);
+  audio.setGain(0, 255);
+  if (intro_cached) {
+    MAS_CHECK(audio.preloadFile(intro));
+  }
+  if (loop_cached) {
+    MAS_CHECK(audio.preloadFile(loop));
+  }
+  audio.playFile(0, intro);
+  if (queue_at > 0) {
+    audio.renderOffline(queue_at);
+  }
+  audio.queueFile(0, loop, true);
+  audio.renderOffline(SEQ_LEN / 22050.0f - queue_at);
+  MAS_CHECK(output.Count == SEQ_LEN);
+  MAS_CHECK(Differ(output.Buf, Expect(intro, loop)) == 0);
+  MAS_CHECK(audio.getState(0) == MAS_RUN && audio.getUnderrun(0) == 0);
+}//                                                                                   offline
+//-------------------------------------------------------------------------------------tasks
+static void Tasks(const char *intro, const char *loop) {
+  Test_Output output(3 * SEQ_LEN, 256 * 1000000 / 22050);
+  ESP32_MAS<2> *audio = new ESP32_MAS<2>;
+  audio->setOutput(&output);
+  audio->setBuffer(256, 4);
+  audio->setGain(0, 255);
+  audio->playFile(0, intro);
+  audio->queueFile(0, loop, true);
+  audio->startDAC();
+  while (output.Count < 3 * SEQ_LEN) {
+    usleep(10000);
+  }
+  MAS_CHECK(audio->getUnderrun(0) == 0);
+  delete audio;
+  MAS_CHECK(Differ(output.Buf, Expect(intro, loop)) == 0);
+}//                                                                                     tasks
+
+int main() {
+  MAS_Set_Root("examples/data");
+  const char *intro = "/makrofon_in.aiff", *loop = "/makrofon_loop.aiff";
+  for (int cached = 0; cached < 4; cached++) {
+    Offline(intro, loop, cached & 1, cached & 2, 0);
+    Offline(intro, loop, cached & 1, cached & 2, 0.05f); // queued while the intro plays
+  }
+  Tasks(intro, loop);
+  //-----------------------------------------------------------------intro longer than the ring
+  MAS_Set_Root(Test_Dir().c_str());
+  std::vector<int16_t> tone = Test_Tone(440, 22050, 3 * MAS_STREAM_SIZE + 100, 10000);
+  std::vector<int16_t> part = Test_Tone(1000, 22050, 3000, 8000);
+  MAS_CHECK(Test_Write_WAV("/long.wav", tone.data(), tone.size(), 22050, 1));
+  MAS_CHECK(Test_Write_WAV("/part.wav", part.data(), part.size(), 22050, 1));
+  Offline("/long.wav", "/part.wav", false, false, 0);
+  Offline("/long.wav", "/part.wav", false, false, 0.2f);
+  Tasks("/long.wav", "/part.wav");
+  return Test_Done("Test_Sequence");
+}
@@ -0,0 +1,126 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Statistics: offline every block is measured once in every stage, in the render time and in
+  the load histogram, nothing is late. With the tasks an output with a script of DMA buffers
+  behind and refused writes gives exactly the late, underrun and dropped blocks of the script.
+  A snapshot of getStats read while the player writes is never torn (the load histogram sums
+  to the measured blocks), resetStats starts new statistics.
+  -------------------------------------------------------------------------------------------*/
+#include <thread>
+#include "MAS_Test.h"
+
+#define COUNT 4 // DMA buffers
+
+// wait returns the DMA buffers behind and write refuses blocks after the script.
+class Script_Output : public Test_Output {
+  public:
+    Script_Output() : Test_Output(1024, 256 * 1000000 / 22050) {};
+    uint8_t wait() {
+      Test_Output::wait();
+      uint32_t block = Waits++;
+      if (block >= 10 && block < 20) {
+        return 1; // late
+      }
+      if (block >= 20 && block < 25) {
+        return COUNT - 1; // late, no DMA buffer left
+      }
+      return 0;
+    };
+    bool write(const int16_t *buf, uint16_t len) {
+      uint32_t block = Blocks;
+      Test_Output::write(buf, len);
+      return block < 30 || block >= 33;
+    };
+    std::atomic<uint32_t> Waits{0};
+};
+
+// true if the snapshot is one state of the player: the load histogram has every block.
+static bool Whole(const MAS_Stats &stats) {
+  uint32_t sum = 0;
+  for (int i = 0; i < MAS_LOAD_STEPS; i++) {
+    sum += stats.load[i];
+  }
+  return sum == stats.render.count && stats.stage[MAS_STAGE_OUT].count == stats.render.count;
+}
+
+int main() {
+  MAS_Set_Root(Test_Dir().c_str());
+  std::vector<int16_t> tone = Test_Tone(440, 22050, 30000, 8000);
+  MAS_CHECK(Test_Write_WAV("/tone.wav", tone.data(), tone.size(), 22050, 1));
+  //-----------------------------------------------------------------------------------offline
+  Test_Output output(4096);
+  ESP32_MAS<2> audio;
+  MAS_Stats stats;
+  audio.setOutput(&output);
+  audio.setBuffer(256, COUNT);
+  audio.setFilter(0, 0, MAS_FILTER_LOWPASS, 5000, 0.7071f, 0);
+  audio.loopFile(0, "/tone.wav");
+  audio.renderOffline(100 * 256 / 22050.0f);
+  MAS_CHECK(audio.getStats(&stats));
+  MAS_CHECK(stats.render.count == 100 && Whole(stats));
+  int wrong = 0;
+  for (int s = MAS_STAGE_VOICE; s < MAS_STAGES; s++) {
+    MAS_Time_Stats &time = stats.stage[s];
+    wrong += time.count != 100 || time.min > time.max;
+    wrong += time.total < (uint64_t)time.min * 100 || time.total > (uint64_t)time.max * 100;
+  }
+  MAS_CHECK(wrong == 0);
+  MAS_CHECK(stats.render.max >= stats.render.min && stats.render.total > 0);
+  MAS_CHECK(stats.cycle_rate == MAS_Cycle_Rate());
+  MAS_CHECK(stats.block_cycles == (uint64_t)256 * stats.cycle_rate / 22050);
+  MAS_CHECK(stats.late == 0 && stats.underrun == 0 && stats.dropped == 0);
+  MAS_CHECK(stats.stage[MAS_STAGE_READ].count > 0); // the tone is read from the file system
+  audio.resetStats();
+  audio.renderOffline(10 * 256 / 22050.0f);
+  MAS_CHECK(audio.getStats(&stats));
+  MAS_CHECK(stats.render.count == 10 && Whole(stats));
+  //-------------------------------------------------------------------------------------tasks
+  Script_Output script;
+  ESP32_MAS<2> *task = new ESP32_MAS<2>;
+  task->setOutput(&script);
+  task->setBuffer(256, COUNT);
+  task->loopFile(0, "/tone.wav"); // the player does not sleep
+  std::atomic<bool> run{true};
+  std::atomic<uint32_t> snapshots{0}, torn{0};
+  task->startDAC();
+  std::thread reader([&]() {
+    MAS_Stats snapshot;
+    while (run) {
+      task->getStats(&snapshot);
+      torn += !Whole(snapshot);
+      snapshots++;
+    }
+  });
+  while (script.Blocks < 60) {
+    usleep(1000);
+  }
+  MAS_CHECK(task->getStats(&stats));
+  MAS_CHECK(stats.late == 15 && stats.underrun == 5 && stats.dropped == 3);
+  MAS_CHECK(stats.render.count >= 60 && stats.render.count <= script.Blocks);
+  MAS_CHECK(stats.stage[MAS_STAGE_READ].count > 0);
+  //--------------------------------------------------------------------------------resetStats
+  task->resetStats();
+  uint32_t blocks = script.Blocks;
+  while (script.Blocks < blocks + 20) {
+    usleep(1000);
+  }
+  MAS_CHECK(task->getStats(&stats));
+  MAS_CHECK(stats.late == 0 && stats.underrun == 0 && stats.dropped == 0);
+  MAS_CHECK(stats.render.count >= 18 && stats.render.count <= script.Blocks - blocks + 1);
+  run = false;
+  reader.join();
+  MAS_CHECK(snapshots > 0 && torn == 0);
+  delete task;
+  return Test_Done("Test_Stats");
+}
@@ -0,0 +1,133 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Streaming reader: files longer than the ring buffer play their samples, a streamed loop
+  repeats without a gap, two sound systems stream at the same time with their own reader
+  buffers, and the underruns of a reader that can not keep up show in getUnderrun and
+  getStates.
+  -------------------------------------------------------------------------------------------*/
+#include "MAS_Test.h"
+
+#define STREAM_LEN (5 * MAS_STREAM_SIZE + 123) // samples of a long file
+#define LOOP_LEN 5000
+
+static std::vector<int16_t> Pattern(int seed, uint32_t len) {
+  std::vector<int16_t> samples(len);
+  for (uint32_t i = 0; i < len; i++) {
+    samples[i] = (int16_t)((i * (41 + seed) + seed * 977) % 30000 - 15000) | 1; // never 0
+  }
+  return samples;
+}
+// Frames of out from the first sample on that equal file, -1 = file not found.
+static int Match(const Test_Output &output, const std::vector<int16_t> &file) {
+  uint32_t start = 0;
+  int same = 0;
+  while (start < output.Count && output.Buf[start] == 0) {
+    start++;
+  }
+  for (uint32_t i = 0; i < file.size() && start + i < output.Count; i++) {
+    same += output.Buf[start + i] == file[i];
+  }
+  return start < output.Count ? same : -1;
+}
+//---------------------------------------------------------------------------------two tasks
+// Two sound systems stream different files at the same time with their tasks.
+static void Two_Readers(const std::vector<int16_t> &a, const std::vector<int16_t> &b) {
+  Test_Output out_a(STREAM_LEN + 22050, 2000);
+  Test_Output out_b(STREAM_LEN + 22050, 2000);
+  ESP32_MAS<2> *mas_a = new ESP32_MAS<2>;
+  ESP32_MAS<2> *mas_b = new ESP32_MAS<2>;
+  mas_a->setOutput(&out_a);
+  mas_b->setOutput(&out_b);
+  mas_a->setGain(0, 255);
+  mas_b->setGain(1, 255);
+  mas_a->startDAC();
+  mas_b->startDAC();
+  mas_a->playFile(0, "/a.wav");
+  mas_b->playFile(1, "/b.wav");
+  for (int t = 0; t < 5000 && (out_a.Count < out_a.Buf.size() ||
+                               out_b.Count < out_b.Buf.size()); t++) {
+    usleep(1000);
+  }
+  MAS_CHECK(mas_a->getUnderrun(0) == 0 && mas_b->getUnderrun(1) == 0);
+  delete mas_a;
+  delete mas_b;
+  MAS_CHECK(Match(out_a, a) == STREAM_LEN);
+  MAS_CHECK(Match(out_b, b) == STREAM_LEN);
+}//                                                                                 two tasks
+
+int main() {
+  MAS_Set_Root(Test_Dir().c_str());
+  std::vector<int16_t> a = Pattern(1, STREAM_LEN);
+  std::vector<int16_t> b = Pattern(2, STREAM_LEN);
+  std::vector<int16_t> loop = Pattern(3, LOOP_LEN);
+  MAS_CHECK(Test_Write_WAV("/a.wav", a.data(), STREAM_LEN, 22050, 1));
+  MAS_CHECK(Test_Write_WAV("/b.wav", b.data(), STREAM_LEN, 22050, 1));
+  MAS_CHECK(Test_Write_WAV("/loop.wav", loop.data(), LOOP_LEN, 22050, 1));
+  //-------------------------------------------------------------------longer than the ring
+  {
+    ESP32_MAS<2> audio;
+    Test_Output output(STREAM_LEN + 4096);
+    audio.setOutput(&output);
+    audio.setGain(0, 255);
+    audio.playFile(0, "/a.wav");
+    audio.renderOffline((STREAM_LEN + 4096) / 22050.0f);
+    MAS_CHECK(output.Buf[0] == a[0]); // renderOffline opens the file before the block
+    MAS_CHECK(Match(output, a) == STREAM_LEN);
+    MAS_CHECK(output.Buf[STREAM_LEN] == 0);
+    MAS_CHECK(audio.getState(0) == MAS_STOP && audio.getUnderrun(0) == 0);
+  }
+  //---------------------------------------------------------------------------streamed loop
+  {
+    ESP32_MAS<2> audio;
+    Test_Output output(4 * LOOP_LEN);
+    audio.setOutput(&output);
+    audio.setGain(1, 255);
+    audio.loopFile(1, "/loop.wav");
+    audio.renderOffline(4.0f * LOOP_LEN / 22050);
+    int same = 0;
+    for (int i = 0; i < 4 * LOOP_LEN; i++) {
+      same += output.Buf[i] == loop[i % LOOP_LEN];
+    }
+    MAS_CHECK(same == 4 * LOOP_LEN);
+  }
+  //--------------------------------------------------------------------two sound systems
+  Two_Readers(a, b);
+  //--------------------------------------------------------------------------underruns
+  // 8 voices at 4x speed and an output that does not wait: the reader falls behind.
+  {
+    Test_Output output(1024); // outlives the player task of audio
+    ESP32_MAS<8> audio;
+    MAS_Channel_Info info[8];
+    audio.setOutput(&output);
+    for (int c = 0; c < 8; c++) {
+      audio.setPitch(c, 3);
+      audio.loopFile(c, c & 1 ? "/a.wav" : "/b.wav");
+    }
+    audio.startDAC();
+    uint32_t underrun = 0;
+    for (int t = 0; t < 2000 && underrun == 0; t++) {
+      usleep(1000);
+      for (int c = 0; c < 8; c++) {
+        underrun += audio.getUnderrun(c);
+      }
+    }
+    MAS_CHECK(underrun > 0);
+    audio.getStates(info);
+    for (int c = 0; c < 8; c++) {
+      MAS_CHECK(info[c].underrun <= audio.getUnderrun(c));
+    }
+    printf("underruns of 8 voices at 4x: %u\n", underrun);
+  }
+  return Test_Done("Test_Stream");
+}
@@ -0,0 +1,79 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Channel count and voices: ESP32_MAS<channels> mixes every channel, the sum saturates,
+  playAny and loopAny take a stopped channel first, then the oldest channel of the lowest
+  priority, never a channel of a higher priority.
+  The mix cost per block over the voices is the scene mix/<voices> of MAS_Bench.
+  -------------------------------------------------------------------------------------------*/
+#include "MAS_Test.h"
+
+#define DC_LEN 2000
+
+// Last sample of a render of all channels looping /dc.wav.
+template <uint8_t channels> static int16_t Mix_All() {
+  Test_Output output(4096);
+  ESP32_MAS<channels> audio;
+  audio.setOutput(&output);
+  MAS_CHECK(audio.preloadFile("/dc.wav"));
+  for (int c = 0; c < channels; c++) {
+    audio.setGain(c, 255);
+    audio.loopFile(c, "/dc.wav");
+    if (c % 16 == 15) {
+      audio.renderOffline(0.001f); // at most MAS_COMMAND_SIZE commands between two calls
+    }
+  }
+  audio.renderOffline(0.1f);
+  MAS_CHECK(audio.getState(channels - 1) > MAS_BRAKE);
+  return output.Buf[output.Count - 1];
+}
+//---------------------------------------------------------------------------voice stealing
+static void Stealing() {
+  Test_Output output(1 << 16);
+  ESP32_MAS<4> audio;
+  audio.setOutput(&output);
+  for (int c = 0; c < 4; c++) {
+    MAS_CHECK(audio.loopAny("/dc.wav", 10) == c); // stopped channels in order
+  }
+  audio.renderOffline(0.05f);
+  MAS_CHECK(audio.playAny("/dc.wav", 9) == -1); // all channels have a higher priority
+  MAS_CHECK(audio.loopAny("/dc.wav", 10) == 0); // the oldest of the same priority
+  MAS_CHECK(audio.loopAny("/dc.wav", 10) == 1);
+  audio.setPriority(3, 2);
+  MAS_CHECK(audio.loopAny("/dc.wav", 5) == 3); // the lowest priority
+  MAS_CHECK(audio.getPriority(3) == 5);
+  MAS_CHECK(audio.loopAny("/dc.wav", 6) == 3); // now the only one of priority <= 6
+  audio.renderOffline(0.05f);
+  for (int c = 0; c < 4; c++) {
+    MAS_CHECK(audio.getState(c) > MAS_BRAKE);
+  }
+  audio.stopChan(2);
+  audio.renderOffline(0.05f);
+  MAS_CHECK(audio.playAny("/dc.wav", 0) == 2); // a stopped channel, whatever its priority
+  MAS_CHECK(audio.playAny("/dc.wav", 1) == 2); // priority 0, its file is still queued
+}//                                                                            voice stealing
+
+int main() {
+  MAS_Set_Root(Test_Dir().c_str());
+  std::vector<int16_t> dc(DC_LEN, 1000);
+  MAS_CHECK(Test_Write_WAV("/dc.wav", dc.data(), DC_LEN, 22050, 1));
+  //--------------------------------------------------------------------------channel count
+  MAS_CHECK(Mix_All<1>() == 1000);
+  MAS_CHECK(Mix_All<3>() == 3000);
+  MAS_CHECK(Mix_All<16>() == 16000);
+  MAS_CHECK(Mix_All<32>() == 32000);
+  MAS_CHECK(Mix_All<40>() == 32767); // saturated
+  MAS_CHECK(Mix_All<127>() == 32767);
+  Stealing();
+  return Test_Done("Test_Voices");
+}
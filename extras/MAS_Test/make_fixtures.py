@@ -0,0 +1,261 @@
+#!/usr/bin/env python3
+# Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+# You should have received a copy of the GNU General Public License
+# along with this program.
+# If not, see <http://www.gnu.org/licenses/>.
+# --------------------------------------------------------------------------------------------
+# Writes the decoder fixtures of extras/MAS_Test/data, run from the root of the library:
+#   python3 extras/MAS_Test/make_fixtures.py
+# Every format of MAS_Decoder.h gets a file and <file>.ref, the expected mono samples as
+# signed 16 bit little endian. The IMA-ADPCM files are encoded here, their reference is the
+# IMA decoder of the specification, independent of src/MAS_Decoder.cpp.
+# The output is the same in every run, the files are committed.
+import math
+import os
+import struct
+
+RATE = 22050
+LEN = 3000  # frames of a fixture
+DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "data")
+
+STEP = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552,
+    1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484,
+    7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385,
+    24623, 27086, 29794, 32767]
+INDEX = [-1, -1, -1, -1, 2, 4, 6, 8]
+
+
+def cdiv(a, b):  # integer division of C, rounds toward zero
+    q = abs(a) // abs(b)
+    return q if (a >= 0) == (b > 0) else -q
+
+
+def signal(channel):
+    # chirp with a decay, full scale peaks and silence, different per channel
+    out = []
+    for i in range(LEN):
+        t = i / RATE
+        v = math.sin(2 * math.pi * (200 + 3000 * t) * t + channel) * 30000 * math.exp(-t * channel)
+        if 1000 <= i < 1100:
+            v = 32767 if (i // 10) % 2 else -32768
+        if 2000 <= i < 2050:
+            v = 0
+        out.append(max(-32768, min(32767, int(round(v)))))
+    return out
+
+
+#-------------------------------------------------------------------------------------IMA
+def ima_decode(nibble, state):
+    predictor, index = state
+    step = STEP[index]
+    diff = step >> 3
+    if nibble & 4:
+        diff += step
+    if nibble & 2:
+        diff += step >> 1
+    if nibble & 1:
+        diff += step >> 2
+    predictor = predictor - diff if nibble & 8 else predictor + diff
+    predictor = max(-32768, min(32767, predictor))
+    index = max(0, min(88, index + INDEX[nibble & 7]))
+    return predictor, index
+
+
+def ima_encode(sample, state):
+    predictor, index = state
+    step = STEP[index]
+    diff = sample - predictor
+    nibble = 0
+    if diff < 0:
+        nibble = 8
+        diff = -diff
+    for bit in (4, 2, 1):
+        if diff >= step:
+            nibble |= bit
+            diff -= step
+        step >>= 1
+    return nibble, ima_decode(nibble, state)
+
+
+def wave_ima(channels, block_align, frames):
+    # WAVE 0x11: per block and channel a header of the first sample, then 4 bytes per channel
+    # of 8 nibbles. The last block is shorter.
+    per_block = (block_align - 4 * channels) * 2 // channels + 1
+    state = [(0, 0)] * channels
+    data = bytearray()
+    ref = []
+    pos = 0
+    while pos < LEN:
+        count = min(per_block, LEN - pos)
+        count = 1 + (count - 1) // 8 * 8  # whole groups of 8 nibbles
+        if count <= 1:
+            break
+        decoded = []
+        for c in range(channels):
+            first = frames[c][pos]
+            state[c] = (first, state[c][1])
+            data += struct.pack("<hBB", first, state[c][1], 0)
+            decoded.append([first])
+        nibbles = [[] for c in range(channels)]
+        for s in range(1, count):
+            for c in range(channels):
+                nibble, state[c] = ima_encode(frames[c][pos + s], state[c])
+                nibbles[c].append(nibble)
+                decoded[c].append(state[c][0])
+        for group in range(0, count - 1, 8):
+            for c in range(channels):
+                for b in range(4):
+                    data.append(nibbles[c][group + 2 * b] | nibbles[c][group + 2 * b + 1] << 4)
+        ref += mix_ima(decoded)
+        pos += count
+    return bytes(data), ref
+
+
+def aifc_ima4(channels, frames):
+    # AIFC ima4: 34 byte packets of 64 samples per channel, the header holds the upper 9 bits
+    # of the predictor and the index.
+    state = [(0, 0)] * channels
+    data = bytearray()
+    ref = []
+    packets = 0
+    for pos in range(0, LEN - 63, 64):
+        decoded = []
+        for c in range(channels):
+            predictor, index = state[c]
+            predictor = struct.unpack(">h", struct.pack(">H", predictor & 0xFF80))[0]
+            state[c] = (predictor, index)
+            packet = bytearray(struct.pack(">H", (predictor & 0xFF80) | index))
+            nibbles = []
+            decoded.append([])
+            for s in range(64):
+                nibble, state[c] = ima_encode(frames[c][pos + s], state[c])
+                nibbles.append(nibble)
+                decoded[c].append(state[c][0])
+            for b in range(32):
+                packet.append(nibbles[2 * b] | nibbles[2 * b + 1] << 4)
+            data += packet
+        ref += mix_ima(decoded)
+        packets += 1
+    return bytes(data), ref, packets
+
+
+def mix_ima(decoded):
+    # mono mix of the IMA decoders: running mean of the channels, rounded like C
+    out = []
+    for s in range(len(decoded[0])):
+        v = decoded[0][s]
+        for c in range(1, len(decoded)):
+            v += cdiv(decoded[c][s] - v, c + 1)
+        out.append(v)
+    return out
+
+
+#-------------------------------------------------------------------------------------PCM
+def mix_pcm(frames, bits):
+    # mono mix of the PCM decoder: sum / channels, 8 bit * 256
+    out = []
+    for s in range(LEN):
+        if bits == 8:
+            out.append(cdiv(sum(to8(f[s]) for f in frames), len(frames)) * 256)
+        else:
+            out.append(cdiv(sum(f[s] for f in frames), len(frames)))
+    return out
+
+
+def to8(sample):
+    return max(-128, min(127, (sample + 128) >> 8))
+
+
+def pcm_bytes(frames, bits, big_endian, unsigned=False):
+    data = bytearray()
+    for s in range(LEN):
+        for f in frames:
+            if bits == 8:
+                data.append((to8(f[s]) + (128 if unsigned else 0)) & 0xFF)
+            else:
+                data += struct.pack(">h" if big_endian else "<h", f[s])
+    return bytes(data)
+
+
+#---------------------------------------------------------------------------------headers
+def extended(rate):
+    # 80 bit IEEE 754 extended of AIFF
+    exponent = 16383 + 31
+    mantissa = rate
+    while mantissa < 0x80000000:
+        mantissa <<= 1
+        exponent -= 1
+    return struct.pack(">HII", exponent, mantissa, 0)
+
+
+def chunk(name, data, big_endian):
+    head = name + struct.pack(">I" if big_endian else "<I", len(data))
+    return head + data + (b"\0" if len(data) & 1 else b"")
+
+
+def aiff(channels, bits, data, frames, compression=None):
+    comm = struct.pack(">hIh", channels, frames, bits) + extended(RATE)
+    if compression is not None:
+        comm += compression + b"\x0bnot checked"
+    body = (b"AIFC" if compression is not None else b"AIFF")
+    if compression is not None:
+        body += chunk(b"FVER", struct.pack(">I", 0xA2805140), True)
+    body += chunk(b"COMM", comm, True)
+    body += chunk(b"NAME", b"MAS fixture", True)  # skipped, odd length
+    body += chunk(b"SSND", struct.pack(">II", 0, 0) + data, True)
+    return b"FORM" + struct.pack(">I", len(body)) + body
+
+
+def wave(tag, channels, bits, block_align, data, extra=b""):
+    rate = RATE * block_align if tag == 1 else RATE * block_align // (
+        (block_align - 4 * channels) * 2 // channels + 1)
+    fmt = struct.pack("<HHIIHH", tag, channels, RATE, rate, block_align, bits) + extra
+    body = b"WAVE" + chunk(b"fmt ", fmt, False) + chunk(b"LIST", b"INFOtest", False)
+    body += chunk(b"data", data, False)
+    return b"RIFF" + struct.pack("<I", len(body)) + body
+
+
+#-----------------------------------------------------------------------------------write
+def write(name, data, ref):
+    with open(os.path.join(DIR, name), "wb") as f:
+        f.write(data)
+    with open(os.path.join(DIR, name + ".ref"), "wb") as f:
+        f.write(struct.pack("<%dh" % len(ref), *ref))
+
+
+def main():
+    os.makedirs(DIR, exist_ok=True)
+    mono = [signal(0)]
+    stereo = [signal(0), signal(1)]
+    write("pcm16.aiff", aiff(1, 16, pcm_bytes(mono, 16, True), LEN), mix_pcm(mono, 16))
+    write("pcm8.aiff", aiff(1, 8, pcm_bytes(mono, 8, True), LEN), mix_pcm(mono, 8))
+    write("stereo16.aiff", aiff(2, 16, pcm_bytes(stereo, 16, True), LEN), mix_pcm(stereo, 16))
+    write("twos16.aifc", aiff(1, 16, pcm_bytes(mono, 16, True), LEN, b"twos"),
+          mix_pcm(mono, 16))
+    write("sowt16.aifc", aiff(2, 16, pcm_bytes(stereo, 16, False), LEN, b"sowt"),
+          mix_pcm(stereo, 16))
+    for channels, frames in ((1, mono), (2, stereo)):
+        data, ref, packets = aifc_ima4(channels, frames)
+        write("ima4_%d.aifc" % channels, aiff(channels, 16, data, packets, b"ima4"), ref)
+        data, ref = wave_ima(channels, 256 * channels, frames)
+        write("ima_%d.wav" % channels, wave(0x11, channels, 4, 256 * channels, data,
+                                            struct.pack("<HH", 2, 505)), ref)
+    write("pcm16.wav", wave(1, 1, 16, 2, pcm_bytes(mono, 16, False)), mix_pcm(mono, 16))
+    write("pcm8.wav", wave(1, 1, 8, 1, pcm_bytes(mono, 8, False, True)), mix_pcm(mono, 8))
+    write("stereo16.wav", wave(1, 2, 16, 4, pcm_bytes(stereo, 16, False)), mix_pcm(stereo, 16))
+    write("pcm8.raw", pcm_bytes(mono, 8, False), mix_pcm(mono, 8))
+
+
+if __name__ == "__main__":
+    main()
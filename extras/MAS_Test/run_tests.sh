@@ -0,0 +1,63 @@
+#!/bin/sh
+# Host tests of the ESP32_MAS, run from the root of the library:
+#   sh extras/MAS_Test/run_tests.sh                 -O2, all tests
+#   sh extras/MAS_Test/run_tests.sh asan            AddressSanitizer, LeakSanitizer and UBSan
+#   sh extras/MAS_Test/run_tests.sh asan Test_Queue only the named tests
+# Every extras/MAS_Test/Test_<name>.cpp is a program of its own, built against src/*.cpp.
+# Test_Bank packs examples/data with mas_pack of MAS_PACK, built here.
+# The tests of asan also run MAS_Bench once over every scene, every scene of
+# extras/MAS_Bench/baseline.txt must run (the times are not compared).
+# The exit code is 1 if a test fails.
+MODE=${1:-release}
+[ $# -gt 0 ] && shift
+case $MODE in
+  release) FLAGS="-O2" ;;
+  asan) FLAGS="-O1 -g -fno-omit-frame-pointer -fsanitize=address,undefined -fno-sanitize-recover=undefined" ;;
+  *) echo "use: run_tests.sh [release|asan] [Test_name ...]"; exit 2 ;;
+esac
+CXX=${CXX:-g++}
+BUILD=extras/MAS_Test/build/$MODE
+mkdir -p $BUILD || exit 2
+#-----------------------------------------------------------------------------------library
+for source in src/*.cpp; do
+  $CXX $FLAGS -pthread -Wall -I src -c $source -o $BUILD/$(basename $source .cpp).o || exit 2
+done
+#---------------------------------------------------------------------------------tools
+$CXX $FLAGS -pthread -I src extras/MAS_Pack/MAS_Pack.cpp $BUILD/*.o -o $BUILD/mas_pack || exit 2
+export MAS_PACK=$BUILD/mas_pack
+#-------------------------------------------------------------------------------------tests
+TESTS=$*
+if [ -z "$TESTS" ]; then
+  TESTS=$(cd extras/MAS_Test && ls Test_*.cpp | sed 's/\.cpp$//')
+fi
+FAILED=""
+for test in $TESTS; do
+  $CXX $FLAGS -pthread -Wall -I src -I extras/MAS_Test extras/MAS_Test/$test.cpp $BUILD/*.o \
+    -o $BUILD/$test || exit 2
+  if $BUILD/$test; then
+    echo "PASS $test"
+  else
+    echo "FAIL $test"
+    FAILED="$FAILED $test"
+  fi
+done
+#---------------------------------------------------------------------------benchmark paths
+if [ $MODE = asan ] && [ $# -eq 0 ]; then
+  $CXX $FLAGS -pthread -I src extras/MAS_Bench/MAS_Bench.cpp $BUILD/*.o -o $BUILD/mas_bench \
+    || exit 2
+  mkdir -p $BUILD/data && cp examples/data/* $BUILD/data/ &&
+    $MAS_PACK $BUILD/data $BUILD/data/sounds.bin > /dev/null || exit 2
+  if $BUILD/mas_bench -d $BUILD/data -k sounds.bin -r 1 -b extras/MAS_Bench/baseline.txt \
+    -t 1000000 > $BUILD/mas_bench.txt; then
+    echo "PASS MAS_Bench"
+  else
+    cat $BUILD/mas_bench.txt
+    echo "FAIL MAS_Bench"
+    FAILED="$FAILED MAS_Bench"
+  fi
+fi
+if [ -n "$FAILED" ]; then
+  echo "failed:$FAILED"
+  exit 1
+fi
+echo "all tests passed"
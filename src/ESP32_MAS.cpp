@@ -11,316 +11,2064 @@
   along with this program.
   If not, see <http://www.gnu.org/licenses/>.*/
 
-#include <Arduino.h>
-#include <FS.h>
-#include "driver/i2s.h"
-#include "esp_task.h"
+#include "MAS_Platform.h"
 #include "ESP32_MAS.h"
-#include "SPIFFS.h"
+#include "MAS_Decoder.h"
+#include "MAS_Engine.h"
+#include "MAS_Filter.h"
+#include "MAS_Mixer.h"
+#include "MAS_Ramp.h"
+#include "MAS_Resampler.h"
 
-void Audio_Player(void *ptr) {
-  Serial.println("Task Audio Player gestartet");
+//-------------------------------------------------------------------------------queued file
+struct MAS_Segment {
+  char file[MAS_NAME_SIZE] = {}; // "" = no file
+  int8_t cache_slot = -1; // -1 = not in the sample cache
+  uint8_t type = MAS_CMD_PLAY; // MAS_CMD_PLAY or MAS_CMD_LOOP
+  MAS_Sound sound; // samples in the cache or the sound bank, no data = SPIFFS
+};
+//--------------------------------------------------------------------------------file voice
+// Read position of a file of the player, in the sample cache or in the ring buffer.
+struct MAS_Voice {
+  const int16_t *ptr = NULL; // NULL = ring buffer
+  const int16_t *begin = NULL;
+  const int16_t *end = NULL;
+  uint32_t tail = 0; // next sample in the ring buffer
+  uint32_t file_end = 0; // end of the file in the ring buffer
+  uint32_t phase = 0; // Q16 position between two samples, can be more than one sample
+  uint32_t rate = 22050; // sample rate of the file
+  int8_t slot = -1; // cache slot, -1 = SPIFFS
+  bool wait = false; // waits for open_ack of the reader
+  uint32_t left = 0; // crossfade: samples to output
+  uint32_t pos = 0; // crossfade: samples output
+  uint32_t len = 0; // crossfade: samples of the crossfade
+};
+//-------------------------------------------------------------------------------cache use
+// Player only. Counts the queued, played and fading files of a cache slot.
+static inline void Use_Cache(volatile uint16_t *cache_use, int8_t slot, int count) {
+  if (slot >= 0) {
+    cache_use[slot] += count;
+  }
+}//                                                                               cache use
+//-------------------------------------------------------------------------------open channel
+// Opens the file of segment for voice. restart = true drops the file read ahead,
+// repeat = true starts a loop in memory at its loop start.
+void Open_File(MAS_Stream *stream, MAS_Voice *voice, const MAS_Segment *segment, bool restart,
+               bool repeat) {
+  const MAS_Sound *sound = &segment->sound;
+  voice->slot = segment->cache_slot;
+  voice->wait = false;
+  if (sound->data != NULL) {
+    //-----------------------------------------------------------cached file or sound bank
+    bool loop = segment->type == MAS_CMD_LOOP;
+    voice->ptr = sound->data + (loop && repeat ? sound->loop_start : 0);
+    voice->begin = sound->data;
+    voice->end = sound->data + (loop ? sound->loop_end : sound->len);
+    voice->rate = sound->rate;
+    if (stream->stream) {
+      //---------------------------------------------------------------let reader close the file
+      stream->stream = false;
+      __sync_synchronize();
+      stream->open_req++;
+    }
+  }
+  else {
+    //-----------------------------------------------------------------------------SPIFFS file
+    voice->ptr = NULL;
+    voice->begin = NULL;
+    voice->end = NULL;
+    if (!restart && stream->next_ready && stream->open_ack == stream->open_req &&
+        stream->next_gen == stream->file_gen) {
+      //--------------------------------------------------------------take the file read ahead
+      voice->tail = stream->next_start;
+      voice->file_end = stream->next_end;
+      voice->rate = stream->next_rate;
+      stream->stream = true;
+      __sync_synchronize();
+      stream->next_ready = false;
+    }
+    else {
+      //-----------------------------------------------------------------request a new file
+      memcpy(stream->open_name, segment->file, MAS_NAME_SIZE);
+      stream->stream = true;
+      voice->wait = true;
+      __sync_synchronize();
+      stream->open_req++;
+    }
+  }
+}//                                                                              open channel
+//-------------------------------------------------------------------------------channel state
+// Sets the state of channel h and reports the change to the class.
+void Set_State(volatile uint8_t *channel, uint8_t h, uint8_t state, MAS_Event_Queue *event) {
+  if (channel[h] != state) {
+    MAS_Event change;
+    channel[h] = state;
+    change.channel = h;
+    change.state = state;
+    event->push(change); // queue full: the event is lost, getChan still has the state
+  }
+}//                                                                              channel state
+//-----------------------------------------------------------------------------set next file
+// Player only. file_gen is odd while the name is written.
+void Set_File(MAS_Stream *stream, const char *file) {
+  stream->file_gen++;
+  __sync_synchronize();
+  memcpy(stream->file_name, file, MAS_NAME_SIZE);
+  __sync_synchronize();
+  stream->file_gen++;
+}//                                                                             set next file
+//---------------------------------------------------------------------------------next segment
+// Player only. The reader reads the next file of the channel ahead.
+void Set_Next(MAS_Stream *stream, const MAS_Segment *segment) {
+  stream->next_stream = segment->sound.data == NULL;
+  Set_File(stream, segment->file);
+}//                                                                              next segment
+//----------------------------------------------------------------------------copy file name
+// Reader only. Returns the file_gen of the copied name.
+uint32_t Copy_File(MAS_Stream *stream, char *file) {
+  uint32_t gen;
+  do {
+    gen = stream->file_gen;
+    __sync_synchronize();
+    memcpy(file, stream->file_name, MAS_NAME_SIZE);
+    __sync_synchronize();
+  } while ((gen & 1) || gen != stream->file_gen);
+  return gen;
+}//                                                                            copy file name
+//---------------------------------------------------------------------------available samples
+int Available_File(const MAS_Voice *voice) {
+  if (voice->ptr != NULL) {
+    return voice->end - voice->ptr;
+  }
+  if (voice->wait) {
+    return MAS_STREAM_SIZE;
+  }
+  return (int32_t)(voice->file_end - voice->tail);
+}//                                                                         available samples
+//------------------------------------------------------------------------------output samples
+// Output samples until the end of the file at the Q16 step.
+uint32_t Out_Samples(int avail, uint32_t phase, uint32_t step) {
+  uint64_t end = (uint64_t)(avail > 0 ? avail : 0) << MAS_PHASE_BITS;
+  return end > phase ? (end - phase + step - 1) / step : 0;
+}//                                                                            output samples
+//---------------------------------------------------------------------------------ring in use
+// Player only. Publishes the oldest sample of the ring buffer the player still reads.
+void Keep_Ring(MAS_Stream *stream, const MAS_Voice *voice, const MAS_Voice *fade) {
+  bool in_use = false;
+  uint32_t tail = 0;
+  if (voice->ptr == NULL && stream->stream && !voice->wait) {
+    // A waiting voice reads nothing, the reader keeps the ring from file_start.
+    tail = voice->tail;
+    in_use = true;
+  }
+  if (fade->left > 0 && fade->ptr == NULL) {
+    if (!in_use || (int32_t)(fade->tail - tail) < 0) {
+      tail = fade->tail;
+    }
+    in_use = true;
+  }
+  if (in_use) {
+    stream->tail = tail;
+    __sync_synchronize();
+  }
+  stream->in_use = in_use;
+}//                                                                               ring in use
+//--------------------------------------------------------------------------------skip samples
+// Moves over the samples of count output samples like the resampler without reading them.
+// left = samples until the end of the file, frac = Q16 fraction. Returns the samples moved.
+uint32_t Skip_Samples(uint32_t left, uint32_t *frac, uint32_t step, int count) {
+  if (left == 0) {
+    return 0;
+  }
+  uint64_t pos = *frac + (uint64_t)(count > 0 ? count : 0) * step;
+  if ((pos >> MAS_PHASE_BITS) < left) {
+    *frac = pos & MAS_PHASE_MASK;
+    return pos >> MAS_PHASE_BITS;
+  }
+  //------------------------------------------the output sample that reaches the end of the file
+  pos = *frac + ((((uint64_t)left << MAS_PHASE_BITS) - *frac + step - 1) / step) * step;
+  *frac = pos & MAS_PHASE_MASK;
+  return left;
+}//                                                                              skip samples
+//-------------------------------------------------------------------------read file to buffer
+// Every output sample moves the file position by "step" (Q16), phase holds the fraction.
+// file_buf = NULL moves the position without output, for a voice at gain 0.
+void Read_File(MAS_Stream *stream, MAS_Voice *voice, int16_t *file_buf, int from, int to,
+               uint32_t step, uint8_t mode) {
+  bool box = mode == MAS_BOX && step > MAS_PHASE_ONE;
+  uint32_t frac = voice->phase & MAS_PHASE_MASK;
+  uint32_t n = voice->phase >> MAS_PHASE_BITS; // whole samples left over by the last file
+  if (file_buf == NULL && voice->ptr != NULL) {
+    //-----------------------------------------------------------------------cached file, skip
+    n = n < (uint32_t)(voice->end - voice->ptr) ? n : voice->end - voice->ptr;
+    voice->ptr += n;
+    voice->ptr += Skip_Samples(voice->end - voice->ptr, &frac, step, to - from);
+  }
+  else if (voice->ptr != NULL) {
+    //-----------------------------------------------------------------------------cached file
+    const int16_t *ptr = voice->ptr;
+    const int16_t *cache_begin = voice->begin;
+    const int16_t *cache_end = voice->end;
+    ptr += n < (uint32_t)(cache_end - ptr) ? n : cache_end - ptr;
+    for (int i = from; i < to; i++) {
+      if (ptr >= cache_end) {
+        file_buf[i] = 0;
+        continue;
+      }
+      int32_t x1 = ptr[0];
+      int32_t x0 = ptr > cache_begin ? ptr[-1] : x1;
+      int32_t x2 = ptr + 1 < cache_end ? ptr[1] : x1;
+      int32_t x3 = ptr + 2 < cache_end ? ptr[2] : x2;
+      file_buf[i] = box ? MAS_Box(ptr, 0xFFFFFFFF, 0, cache_end - ptr, frac, step) :
+                    MAS_Interpolate(mode, x0, x1, x2, x3, frac);
+      frac += step;
+      n = frac >> MAS_PHASE_BITS;
+      frac &= MAS_PHASE_MASK;
+      if (n > (uint32_t)(cache_end - ptr)) {
+        n = cache_end - ptr;
+      }
+      ptr += n;
+    }
+    voice->ptr = ptr;
+  }
+  else if (voice->wait) {
+    //------------------------------------------------------------------------wait for reader
+    for (int i = from; i < to && file_buf != NULL; i++) {
+      file_buf[i] = 0;
+    }
+    frac = voice->phase;
+  }
+  else {
+    //-----------------------------------------------------------------------------ring buffer
+    // Samples behind the file end may already belong to the next file, the resampler
+    // reads them as neighbours up to head. The reader keeps the sample before tail.
+    const int16_t *buf = stream->buf;
+    uint32_t tail = voice->tail;
+    uint32_t end = voice->file_end;
+    uint32_t head = stream->head;
+    bool underrun = false;
+    __sync_synchronize();
+    if ((int32_t)(end - head) > 0) {
+      end = head;
+      underrun = true;
+    }
+    tail += n < end - tail ? n : end - tail;
+    if (file_buf == NULL) {
+      tail += Skip_Samples(end - tail, &frac, step, to - from);
+    }
+    for (int i = from; i < to && file_buf != NULL; i++) {
+      if (tail == end) {
+        file_buf[i] = 0;
+        continue;
+      }
+      int32_t x1 = buf[tail & (MAS_STREAM_SIZE - 1)];
+      int32_t x0 = buf[(tail - 1) & (MAS_STREAM_SIZE - 1)];
+      int32_t x2 = head - tail > 1 ? buf[(tail + 1) & (MAS_STREAM_SIZE - 1)] : x1;
+      int32_t x3 = head - tail > 2 ? buf[(tail + 2) & (MAS_STREAM_SIZE - 1)] : x2;
+      file_buf[i] = box ? MAS_Box(buf, MAS_STREAM_SIZE - 1, tail, head - tail, frac, step) :
+                    MAS_Interpolate(mode, x0, x1, x2, x3, frac);
+      frac += step;
+      n = frac >> MAS_PHASE_BITS;
+      frac &= MAS_PHASE_MASK;
+      if (n > end - tail) {
+        n = end - tail;
+      }
+      tail += n;
+    }
+    if (underrun && tail == end && from < to) {
+      stream->underrun++;
+    }
+    voice->tail = tail;
+  }
+  voice->phase = frac;
+}//                                                                       read file to buffer
+//-----------------------------------------------------------------------------open for reader
+// Opens the file and reads the header. Returns the number of samples, 0 = not playable.
+uint32_t Open_Stream(MAS_Stream *stream, const char *audio_file) {
+  if (!stream->file.open(audio_file) || !MAS_Read_Format(&stream->file, &stream->format) ||
+      stream->format.block_align > MAS_STREAM_BLOCK) {
+    stream->file.close();
+    stream->remain = 0;
+    return 0;
+  }
+  stream->remain = stream->format.data_len;
+  return stream->format.decoder->samples(&stream->format, stream->format.data_len);
+}//                                                                           open for reader
+#if MAS_STATS
+//--------------------------------------------------------------------------------statistics
+void Stats_Time(MAS_Time_Stats *time, uint32_t cycles) {
+  time->count++;
+  time->min = cycles < time->min ? cycles : time->min;
+  time->max = cycles > time->max ? cycles : time->max;
+  time->total += cycles;
+}
+// Reader only. Adds a reader pass that read or opened files.
+void Stats_Read(ESP32_MAS_Base *mas, uint32_t cycles) {
+  uint32_t reset = mas->Stats_Reset;
+  mas->Read_Gen++;
+  __sync_synchronize();
+  if (mas->Read_Done != reset) {
+    mas->Read_Stats = MAS_Time_Stats();
+    mas->Read_Done = reset;
+  }
+  Stats_Time(&mas->Read_Stats, cycles);
+  __sync_synchronize();
+  mas->Read_Gen++;
+}//                                                                              statistics
+#endif
+//---------------------------------------------------------------------------------reader step
+// One pass of the reader over all channels. Returns false if there was nothing to do.
+bool Reader_Step(ESP32_MAS_Base *mas) {
+  volatile uint8_t *Channel = mas->Channel; // 0 = STOP, 1 = BRAKE, 2 = PLAY, 3 = LOOP, ...
+  MAS_Stream *Stream = mas->Stream; // ring buffers of the channels
+  int ic = mas->Channels;
+
+  char file[MAS_NAME_SIZE];
+  uint8_t *file_buf = mas->Read_Buf; // MAS_STREAM_BLOCK bytes of the file
+  int16_t *pcm_buf = mas->Read_PCM; // decoded samples of file_buf
+  bool busy = false;
+  int len;
+  int count;
+  int free_len;
+  int pos;
+  uint32_t gen;
+  uint32_t keep;
+#if MAS_STATS
+  uint32_t read_start = MAS_Cycles();
+#endif
+  for (int h = 0; h < ic; h++) {
+    MAS_Stream *stream = &Stream[h];
+    gen = stream->file_gen;
+    __sync_synchronize();
+    if (stream->open_req != stream->open_ack) {
+      //-------------------------------------------------------------------------open new file
+      uint32_t req = stream->open_req;
+      __sync_synchronize();
+      stream->file.close();
+      stream->remain = 0;
+      stream->next_ready = false;
+      if (stream->stream) {
+        memcpy(file, stream->open_name, MAS_NAME_SIZE);
+        count = Open_Stream(stream, file);
+        stream->file_start = stream->head;
+        stream->file_end = stream->head + count;
+        stream->file_rate = stream->format.rate;
+      }
+      __sync_synchronize();
+      stream->open_ack = req;
+      busy = true;
+    }//                                                                          open new file
+    else if (stream->next_ready && stream->next_gen != gen) {
+      //-------------------------------------------the next file was changed, drop the old one
+      stream->next_ready = false;
+      stream->file.close();
+      stream->remain = 0;
+      __sync_synchronize();
+      stream->head = stream->next_start;
+      busy = true;
+    }
+    //------------------------------------------------------oldest sample the player still needs
+    if (stream->in_use) {
+      __sync_synchronize();
+      keep = stream->tail;
+    }
+    else {
+      // A voice waiting for the opened file reads it from file_start, also after a file was
+      // read ahead.
+      keep = stream->next_ready && !stream->stream ? stream->next_start : stream->file_start;
+    }
+    // The sample before keep is kept for the cubic resampler.
+    free_len = MAS_STREAM_SIZE - 1 - (stream->head - keep);
+    if (stream->remain > 0) {
+      //------------------------------------------------------------read and decode to buffer
+      len = MAS_STREAM_BLOCK - MAS_STREAM_BLOCK % stream->format.block_align;
+      if (len > (int)stream->remain) {
+        len = stream->remain;
+      }
+      if ((int)stream->format.decoder->samples(&stream->format, len) > free_len) {
+        continue;
+      }
+      len = stream->file.read(file_buf, len);
+      if (len <= 0) {
+        stream->remain = 0;
+        continue;
+      }
+      stream->remain -= len;
+      count = stream->format.decoder->decode(&stream->format, file_buf, len, pcm_buf);
+      pos = stream->head & (MAS_STREAM_SIZE - 1);
+      for (int i = 0; i < count; i++) {
+        stream->buf[pos] = pcm_buf[i];
+        pos = (pos + 1) & (MAS_STREAM_SIZE - 1);
+      }
+      __sync_synchronize();
+      stream->head += count;
+      busy = true;
+    }//                                                                  read and decode to buffer
+    else if (!stream->next_ready && stream->next_stream && Channel[h] > 1 && Channel[h] < 5) {
+      //--------------------------------------------------------------------read next file ahead
+      // Also while the channel plays from the cache, the file starts at head.
+      gen = Copy_File(stream, file);
+      stream->file.close();
+      count = Open_Stream(stream, file);
+      stream->next_start = stream->head;
+      stream->next_end = stream->head + count;
+      stream->next_rate = stream->format.rate;
+      stream->next_gen = gen;
+      __sync_synchronize();
+      stream->next_ready = true;
+      busy = true;
+    }//                                                                    read next file ahead
+  }
+#if MAS_STATS
+  if (busy) {
+    Stats_Read(mas, MAS_Cycles() - read_start);
+  }
+#endif
+  return busy;
+}//                                                                               reader step
 
-  unsigned int ptr_array[18];
-  String *Audio_File[3];
-  uint8_t *I2S_PORT; // PORT NUM
-  uint8_t *I2S_BCK; // BCK
-  uint8_t *I2S_WS; // WS
-  uint8_t *I2S_DATA; // DATA
-  bool *I2S_noDAC; // noDAC
-  uint8_t *Volume; // 0-255, 0 = mute, 255 = 0dB
-  uint8_t *Channel[3]; // 0 = STOP, 1 = BRAKE, 2 = PLAY, 3 = LOOP, 4 = RUN, 5 = OUT
-  uint8_t *Gain[3]; // 0-255, 0 = mute, 255 = 0dB
-  float *Pitch[3]; // 0 - 1, 0 = normal speed, 1 = double speed
+void Audio_Reader(void *ptr) {
+  MAS_Log("Task Audio Reader gestartet");
 
-  unsigned int is = sizeof ptr;
-  int ic = 3;
-  int ip = 0;
+  ESP32_MAS_Base *mas = (ESP32_MAS_Base*)ptr;
+  while (!mas->Stopping) {
+    //------------------------------------------------------------------------AUDIO READER LOOP
+    if (!Reader_Step(mas)) {
+      MAS_Sleep(1);
+    }
+  }//                                                                         AUDIO READER LOOP
+  __sync_fetch_and_sub(&mas->Tasks, 1);
+  MAS_End_Task();
+}//                                                                           VOID AUDIO READER
 
-  for (int i = 0; i < 18; i++) {
-    ptr_array[i] = *(unsigned int*)ptr;
-    ptr += is;
-  }
-  for (int i = 0; i < ic; i++) {
-    Audio_File[i] = (String*)ptr_array[ip];
-    ip++;
-  }
-  I2S_PORT = (uint8_t*)ptr_array[ip];  ip++;
-  I2S_BCK = (uint8_t*)ptr_array[ip];  ip++;
-  I2S_WS = (uint8_t*)ptr_array[ip];  ip++;
-  I2S_DATA = (uint8_t*)ptr_array[ip];  ip++;
-  I2S_noDAC = (bool*)ptr_array[ip];  ip++;
-  Volume = (uint8_t*)ptr_array[ip];  ip++;
-  for (int i = 0; i < ic; i++) {
-    Channel[i] = (uint8_t*)ptr_array[ip];
-    ip++;
-  }
-  for (int i = 0; i < ic; i++) {
-    Gain[i] = (uint8_t*)ptr_array[ip];
-    ip++;
-  }
-  for (int i = 0; i < ic; i++) {
-    Pitch[i] = (float*)ptr_array[ip];
-    ip++;
-  }
-  int file_buf_len;
-  int8_t out_buf_8[64];
-  int buf_len_8 = sizeof(out_buf_8);
-  int16_t out_buf_16[sizeof(out_buf_8) / 2];
-  int buf_len_16 = sizeof(out_buf_8) / 2;
-  int8_t file_buf[3][sizeof(out_buf_8) / 2];
-  float pitch[3] = {0, 0, 0};
-  float pitch_loc;
-  bool end_file = false;
-  File aiff_file[3];
-  //-------------------------------------------------------------------------I2S-configuration
-  const int I2S_PORT_NUM = (const int) * I2S_PORT;
-  //--------------------------------------------------------------------------I2S-interlal DAC
-  i2s_config_t i2s_config_noDAC = {
-    .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX | I2S_MODE_DAC_BUILT_IN),
-    .sample_rate = 22050,
-    .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
-    .channel_format = I2S_CHANNEL_FMT_ONLY_RIGHT,
-    .communication_format = (i2s_comm_format_t)(I2S_COMM_FORMAT_I2S | I2S_COMM_FORMAT_I2S_MSB),
-    .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-    .dma_buf_count = 8,
-    .dma_buf_len = 64,
-    .use_apll  =  true
-  };
-  //----------------------------------------------------------------------------I2S-extern DAC
-  i2s_config_t i2s_config_DAC = {
-    .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX),
-    .sample_rate = 22050,
-    .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
-    .channel_format = I2S_CHANNEL_FMT_ONLY_RIGHT,
-    .communication_format = (i2s_comm_format_t)(I2S_COMM_FORMAT_I2S | I2S_COMM_FORMAT_I2S_MSB),
-    .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-    .dma_buf_count = 8,
-    .dma_buf_len = 64,
-    .use_apll  =  true
-  };
-  //-----------------------------------------------------------------------------I2S-pin-config
-  i2s_pin_config_t pin_config = {
-    .bck_io_num = (int) * I2S_BCK,
-    .ws_io_num = (int) * I2S_WS,
-    .data_out_num = (int) * I2S_DATA,
-    .data_in_num = I2S_PIN_NO_CHANGE
-  };
-  //-----------------------------------------------------------------------------------open I2S
-  if (*I2S_noDAC) {
-    i2s_driver_install((i2s_port_t)I2S_PORT_NUM, &i2s_config_noDAC, 0, NULL);
+//------------------------------------------------------------------------------state of the player
+struct MAS_Player {
+  int16_t *out_buf_16; // output block, interleaved frames in stereo
+  int32_t *mix_buf; // master, in stereo left block then right block
+  int32_t *bus_buf; // submix of one bus, like mix_buf
+  int16_t *fade_buf; // file faded out
+  //---------------------------------------------------------------------state of the commands
+  MAS_Ramp volume; // Q15 master volume
+  MAS_Ramp bus_gain[MAS_BUSES]; // Q15 gain of the buses
+  uint8_t out_channels; // 1 = mono, 2 = stereo
+  uint8_t interpolation; // 0 = NONE, 1 = LINEAR, 2 = CUBIC, 3 = BOX
+  MAS_Biquad bus_filter[MAS_BUSES][2][MAS_FILTERS]; // inserts of the buses, left and right
+  MAS_Biquad master_filter[2][MAS_FILTERS]; // inserts of the master, left and right
+  MAS_Limiter limiter; // last insert of the master
+  //------------------------------------------------------------------------one per channel
+  int16_t **file_buf;
+  MAS_Voice *voice; // file played
+  MAS_Voice *fade; // file faded out by a crossfade
+  MAS_Segment *current; // file played
+  MAS_Segment (*segment)[MAS_SEGMENTS]; // queued files, [0] = next file
+  uint8_t *segments; // number of queued files
+  MAS_Ramp *gain; // Q15 gain
+  MAS_Ramp *pitch; // Q16 pitch, 0 = normal speed, 1 << 16 = double speed
+  MAS_Envelope *envelope; // level of the channel
+  int8_t *pan; // -127 = left, 0 = center, 127 = right
+  int32_t (*pan_gain)[2]; // Q15 left and right gain of the pan at the end of the last block
+  uint8_t *bus; // submix bus
+  MAS_Biquad (*filter)[MAS_FILTERS]; // inserts of the channel
+  uint16_t *crossfade; // samples of a crossfade to a queued file, 0 = none
+  bool *restart; // drop the played file
+  MAS_Engine *engine; // layers and rpm of the engine voice
+  bool *engine_on; // the channel plays the engine voice instead of files
+  bool *silent; // file_buf has no sample louder than MAS_SILENCE and is not mixed
+  bool *mixed; // the channel was mixed in a part of this block
+  //------------------------------------------------------------------------------------idle
+  uint32_t silent_blocks; // blocks in a row without a playing channel and without output
+  uint16_t skipped; // channel blocks of this block that were not mixed
+  uint8_t idled; // the player slept since the last block
+  uint16_t unscheduled; // timed commands taken at once since the last block, schedule full
+  //--------------------------------------------------------------------------------schedule
+  uint32_t clock; // sample clock of the first sample of the block
+  MAS_Command *schedule; // timed commands for later samples in the order of their clock
+  uint8_t scheduled; // commands in the schedule
+#if MAS_STATS
+  //--------------------------------------------------------------------------statistics
+  uint32_t lap; // MAS_Cycles at the end of the last measured part of the block
+  uint32_t cycles[MAS_STAGES]; // cycles of the stages in this block
+#endif
+};
+#if MAS_STATS
+// Adds the cycles since the last lap to a stage.
+#define MAS_STATS_LAP(stage) Stats_Lap(player, stage)
+#define MAS_STATS_BEGIN() Stats_Begin(player)
+static inline void Stats_Begin(MAS_Player *player) {
+  memset(player->cycles, 0, sizeof(player->cycles));
+  player->lap = MAS_Cycles();
+}
+static inline void Stats_Lap(MAS_Player *player, int stage) {
+  uint32_t now = MAS_Cycles();
+  player->cycles[stage] += now - player->lap;
+  player->lap = now;
+}
+#else
+#define MAS_STATS_LAP(stage)
+#define MAS_STATS_BEGIN()
+#endif
+//---------------------------------------------------------------------------------player begin
+MAS_Player *Player_Begin(ESP32_MAS_Base *mas) {
+  int ic = mas->Channels;
+  int buf_len_16 = mas->Block_Len;
+  int oc = mas->Out_Channels;
+  MAS_Player *player = new MAS_Player;
+  player->out_buf_16 = new int16_t[buf_len_16 * oc];
+  player->mix_buf = new int32_t[buf_len_16 * oc];
+  player->bus_buf = new int32_t[buf_len_16 * oc];
+  player->fade_buf = new int16_t[buf_len_16];
+  player->out_channels = oc;
+  MAS_Ramp_Set(&player->volume, MAS_Gain_Q15(mas->Volume), 0);
+  for (int b = 0; b < MAS_BUSES; b++) {
+    MAS_Ramp_Set(&player->bus_gain[b], MAS_Gain_Q15(mas->Bus_Gain[b]), 0);
+  }
+  player->interpolation = mas->Interpolation;
+  player->file_buf = new int16_t*[ic];
+  player->voice = new MAS_Voice[ic];
+  player->fade = new MAS_Voice[ic];
+  player->current = new MAS_Segment[ic];
+  player->segment = new MAS_Segment[ic][MAS_SEGMENTS];
+  player->segments = new uint8_t[ic]();
+  player->gain = new MAS_Ramp[ic];
+  player->pitch = new MAS_Ramp[ic];
+  player->envelope = new MAS_Envelope[ic];
+  player->pan = new int8_t[ic];
+  player->pan_gain = new int32_t[ic][2];
+  player->bus = new uint8_t[ic];
+  player->filter = new MAS_Biquad[ic][MAS_FILTERS];
+  player->crossfade = new uint16_t[ic];
+  player->restart = new bool[ic]();
+  player->engine = new MAS_Engine[ic];
+  player->engine_on = new bool[ic]();
+  player->silent = new bool[ic];
+  player->mixed = new bool[ic];
+  player->silent_blocks = 0;
+  player->skipped = 0;
+  player->idled = 0;
+  player->unscheduled = 0;
+  player->clock = 0;
+  player->schedule = new MAS_Command[MAS_SCHEDULE];
+  player->scheduled = 0;
+  for (int h = 0; h < ic; h++) {
+    player->file_buf[h] = new int16_t[buf_len_16];
+    MAS_Ramp_Set(&player->gain[h], MAS_Gain_Q15(mas->Gain[h]), 0);
+    MAS_Ramp_Set(&player->pitch[h], mas->Pitch[h] * 65536, 0);
+    MAS_Envelope_Init(&player->envelope[h]);
+    player->pan[h] = mas->Pan[h];
+    MAS_Pan_Q15(mas->Pan[h], &player->pan_gain[h][0], &player->pan_gain[h][1]);
+    player->bus[h] = mas->Bus[h];
+    player->crossfade[h] = mas->Crossfade[h];
+    player->silent[h] = true;
+  }
+  return player;
+}//                                                                              player begin
+//-----------------------------------------------------------------------------------player end
+void Player_End(ESP32_MAS_Base *mas, MAS_Player *player) {
+  for (int h = 0; h < mas->Channels; h++) {
+    delete[] player->file_buf[h];
+  }
+  delete[] player->out_buf_16;
+  delete[] player->mix_buf;
+  delete[] player->bus_buf;
+  delete[] player->fade_buf;
+  delete[] player->file_buf;
+  delete[] player->voice;
+  delete[] player->fade;
+  delete[] player->current;
+  delete[] player->segment;
+  delete[] player->segments;
+  delete[] player->gain;
+  delete[] player->pitch;
+  delete[] player->envelope;
+  delete[] player->pan;
+  delete[] player->pan_gain;
+  delete[] player->bus;
+  delete[] player->filter;
+  delete[] player->crossfade;
+  delete[] player->restart;
+  delete[] player->engine;
+  delete[] player->engine_on;
+  delete[] player->silent;
+  delete[] player->mixed;
+  delete[] player->schedule;
+  delete player;
+}//                                                                                player end
+//-----------------------------------------------------------------------------------stop fade
+void Stop_Fade(MAS_Voice *fade, volatile uint16_t *cache_use) {
+  if (fade->left > 0) {
+    Use_Cache(cache_use, fade->slot, -1);
+    fade->left = 0;
+  }
+}//                                                                                 stop fade
+//----------------------------------------------------------------------------------clear queue
+void Clear_Queue(MAS_Player *player, uint8_t h, volatile uint16_t *cache_use) {
+  for (int i = 0; i < player->segments[h]; i++) {
+    Use_Cache(cache_use, player->segment[h][i].cache_slot, -1);
+  }
+  player->segments[h] = 0;
+}//                                                                               clear queue
+//---------------------------------------------------------------------------------drop file
+// Drops the played file and the queued files of channel h.
+void Drop_File(MAS_Player *player, uint8_t h, volatile uint16_t *cache_use) {
+  MAS_Voice *voice = &player->voice[h];
+  Clear_Queue(player, h, cache_use);
+  Use_Cache(cache_use, player->current[h].cache_slot, -1);
+  player->current[h].cache_slot = -1;
+  player->current[h].file[0] = 0;
+  voice->ptr = NULL;
+  voice->wait = false;
+  voice->tail = voice->file_end;
+}//                                                                               drop file
+//------------------------------------------------------------------------------------next file
+// Starts the first queued file of channel h, or the played file again if nothing is queued.
+// Returns false if there is no file.
+bool Next_File(ESP32_MAS_Base *mas, MAS_Player *player, uint8_t h, bool restart) {
+  MAS_Stream *stream = &mas->Stream[h];
+  MAS_Segment *segment = player->segment[h];
+  MAS_Segment *current = &player->current[h];
+  bool next = player->segments[h] > 0;
+  if (next) {
+    //-------------------------------------------------------------------take the queued file
+    Use_Cache(mas->Cache_Use, current->cache_slot, -1);
+    *current = segment[0];
+    player->segments[h]--;
+    for (int i = 0; i < player->segments[h]; i++) {
+      segment[i] = segment[i + 1];
+    }
+  }
+  if (current->file[0] == 0) {
+    return false;
+  }
+  player->voice[h].phase = 0;
+  Open_File(stream, &player->voice[h], current, restart, !next);
+  if (next) {
+    //-----------------------------------------the reader reads the next file or the loop ahead
+    Set_Next(stream, player->segments[h] > 0 ? &segment[0] : current);
+  }
+  if (player->segments[h] > 0) {
+    Set_State(mas->Channel, h, segment[0].type, &mas->Event);
+  }
+  else if (next) {
+    Set_State(mas->Channel, h, current->type == MAS_CMD_LOOP ? 4 : 5, &mas->Event);
+  }
+  return true;
+}//                                                                                 next file
+//-------------------------------------------------------------------------------player command
+// Takes one command of the class.
+void Player_Command(ESP32_MAS_Base *mas, MAS_Player *player, const MAS_Command &command) {
+  volatile uint8_t *Channel = mas->Channel; // 0 = STOP, 1 = BRAKE, 2 = PLAY, 3 = LOOP, ...
+  volatile uint16_t *Cache_Use = mas->Cache_Use; // files of the cache slots in use
+  MAS_Event_Queue *Event = &mas->Event; // state changes to the class
+  MAS_Stream *Stream = mas->Stream; // ring buffers of the channels
+
+  MAS_Ramp *gain = player->gain;
+  MAS_Ramp *pitch = player->pitch;
+  bool *restart = player->restart;
+  uint8_t h = command.channel;
+  MAS_Segment *segment = player->segment[h];
+  uint8_t n = player->segments[h];
+  MAS_Engine *engine = &player->engine[h];
+  MAS_Envelope *envelope = &player->envelope[h];
+  switch (command.type) {
+    case MAS_CMD_PLAY:
+    case MAS_CMD_LOOP:
+      player->engine_on[h] = false;
+      if (command.value == 0) {
+        //------------------------------------------------------------replace the queued files
+        Clear_Queue(player, h, Cache_Use);
+        n = 0;
+      }
+      else if (n == MAS_SEGMENTS) {
+        //--------------------------------------------------------queue full, replace the last
+        n--;
+        Use_Cache(Cache_Use, segment[n].cache_slot, -1);
+      }
+      memcpy(segment[n].file, command.file, MAS_NAME_SIZE);
+      segment[n].cache_slot = command.cache_slot;
+      segment[n].sound = command.sound;
+      segment[n].type = command.type;
+      Use_Cache(Cache_Use, command.cache_slot, 1);
+      player->segments[h] = n + 1;
+      if (n == 0) {
+        restart[h] = command.restart || Channel[h] == 0;
+        if (!restart[h]) {
+          Set_Next(&Stream[h], &segment[0]); // follows the played file, Next_File sets it else
+        }
+        Set_State(Channel, h, command.type, Event);
+      }
+      break;
+    case MAS_CMD_STOP:
+      player->engine_on[h] = false;
+      Clear_Queue(player, h, Cache_Use);
+      Stop_Fade(&player->fade[h], Cache_Use);
+      Set_State(Channel, h, command.type, Event);
+      break;
+    case MAS_CMD_BRAKE:
+    case MAS_CMD_RUN:
+    case MAS_CMD_OUT:
+      Set_State(Channel, h, command.type, Event);
+      break;
+    case MAS_CMD_GAIN:
+      MAS_Ramp_Set(&gain[h], MAS_Gain_Q15(command.value), command.time[0]);
+      break;
+    case MAS_CMD_PITCH:
+      MAS_Ramp_Set(&pitch[h], command.pitch * 65536, command.time[0]);
+      break;
+    case MAS_CMD_VOLUME:
+      MAS_Ramp_Set(&player->volume, MAS_Gain_Q15(command.value), command.time[0]);
+      break;
+    case MAS_CMD_INTERPOLATION:
+      player->interpolation = command.value;
+      break;
+    case MAS_CMD_CROSSFADE:
+      player->crossfade[h] = command.value;
+      break;
+    case MAS_CMD_LAYER:
+      if (command.sound.data == NULL) {
+        //-------------------------------------------------------------------clear the layers
+        for (int i = 0; i < engine->layers; i++) {
+          Use_Cache(Cache_Use, engine->layer[i].slot, -1);
+        }
+        engine->layers = 0;
+      }
+      else if (MAS_Engine_Add(engine, command.sound.data, command.sound.loop_end,
+                              command.sound.rate, command.value, command.cache_slot)) {
+        Use_Cache(Cache_Use, command.cache_slot, 1);
+      }
+      break;
+    case MAS_CMD_RPM:
+      engine->rpm = command.value;
+      break;
+    case MAS_CMD_ENGINE:
+      //----------------------------------------------------the engine starts at its rpm
+      Drop_File(player, h, Cache_Use);
+      Stop_Fade(&player->fade[h], Cache_Use);
+      restart[h] = false;
+      engine->rpm_now = engine->rpm;
+      player->engine_on[h] = true;
+      MAS_Envelope_Start(envelope);
+      Set_State(Channel, h, MAS_CMD_RUN, Event);
+      break;
+    case MAS_CMD_ENVELOPE:
+      envelope->attack = command.time[0];
+      envelope->decay = command.time[1];
+      envelope->release = command.time[2];
+      envelope->sustain = MAS_Gain_Q15(command.value);
+      if (envelope->stage == MAS_ENV_SUSTAIN) {
+        //-------------------------------------------------------move to the new sustain level
+        envelope->stage = MAS_ENV_DECAY;
+        MAS_Ramp_Set(&envelope->level, envelope->sustain, envelope->decay);
+      }
+      break;
+    case MAS_CMD_PAN:
+      player->pan[h] = (int8_t)command.value;
+      break;
+    case MAS_CMD_BUS:
+      player->bus[h] = command.value;
+      break;
+    case MAS_CMD_BUS_GAIN:
+      MAS_Ramp_Set(&player->bus_gain[command.value >> 8], MAS_Gain_Q15(command.value & 255),
+                   command.time[0]);
+      break;
+    case MAS_CMD_RELEASE:
+      if (Channel[h] > 1 && envelope->stage < MAS_ENV_RELEASE) {
+        MAS_Envelope_Release(envelope);
+      }
+      break;
+    case MAS_CMD_FILTER:
+      MAS_Biquad_Set(&player->filter[h][command.filter.slot], &command.filter, 22050);
+      break;
+    case MAS_CMD_BUS_FILTER:
+      for (int c = 0; c < 2; c++) {
+        MAS_Biquad_Set(&player->bus_filter[command.value][c][command.filter.slot],
+                       &command.filter, 22050);
+      }
+      break;
+    case MAS_CMD_MASTER_FILTER:
+      for (int c = 0; c < 2; c++) {
+        MAS_Biquad_Set(&player->master_filter[c][command.filter.slot], &command.filter, 22050);
+      }
+      break;
+    case MAS_CMD_LIMITER:
+      MAS_Limiter_Set(&player->limiter, command.value, command.time[0]);
+      break;
+  }
+  if (command.timed && (command.type == MAS_CMD_PLAY || command.type == MAS_CMD_LOOP ||
+                        command.type == MAS_CMD_ENGINE)) {
+    __sync_synchronize();
+    Stream[h].at_ack++;
+  }
+}//                                                                            player command
+//----------------------------------------------------------------------------------start files
+// Starts the files of restarted channels.
+void Player_Start(ESP32_MAS_Base *mas, MAS_Player *player) {
+  volatile uint8_t *Channel = mas->Channel; // 0 = STOP, 1 = BRAKE, 2 = PLAY, 3 = LOOP, ...
+  volatile uint16_t *Cache_Use = mas->Cache_Use; // files of the cache slots in use
+  bool *restart = player->restart;
+  for (int h = 0; h < mas->Channels; h++) {
+    if (restart[h] && Channel[h] > 1) {
+      //-----------------------------------------------------------------drop the played file
+      restart[h] = false;
+      Stop_Fade(&player->fade[h], Cache_Use);
+      Next_File(mas, player, h, true);
+      MAS_Envelope_Start(&player->envelope[h]);
+    }
+  }
+}//                                                                               start files
+//------------------------------------------------------------------------------------schedule
+// Player only. Inserts a timed command in the order of its sample clock, behind the commands
+// of the same clock. Its cache slot stays in use until the command is taken.
+void Schedule(ESP32_MAS_Base *mas, MAS_Player *player, const MAS_Command &command) {
+  int i = player->scheduled;
+  while (i > 0 && (int32_t)(player->schedule[i - 1].at - command.at) > 0) {
+    player->schedule[i] = player->schedule[i - 1];
+    i--;
+  }
+  player->schedule[i] = command;
+  player->scheduled++;
+  Use_Cache(mas->Cache_Use, command.cache_slot, 1);
+}//                                                                                  schedule
+//------------------------------------------------------------------------------player commands
+// Takes the commands of the class and starts the files of restarted channels.
+// A timed command for a later block waits in the schedule, a full schedule takes it at once
+// and counts it in the statistics.
+void Player_Commands(ESP32_MAS_Base *mas, MAS_Player *player) {
+  MAS_Command command;
+  while (mas->Command.pop(&command)) {
+    if (command.timed && (int32_t)(command.at - player->clock) > 0) {
+      if (player->scheduled < MAS_SCHEDULE) {
+        Schedule(mas, player, command);
+        continue;
+      }
+      player->unscheduled++;
+    }
+    Player_Command(mas, player, command);
+  }
+  Player_Start(mas, player);
+}//                                                                           player commands
+//----------------------------------------------------------------------------------due commands
+// Takes the scheduled commands due at frame pos of the block.
+// Returns the frames until the next scheduled command or the end of the block.
+int Player_Due(ESP32_MAS_Base *mas, MAS_Player *player, int pos) {
+  MAS_Command command;
+  int end = mas->Block_Len;
+  bool taken = false;
+  while (player->scheduled > 0 && (int32_t)(player->schedule[0].at - player->clock) <= pos) {
+    command = player->schedule[0];
+    player->scheduled--;
+    for (int i = 0; i < player->scheduled; i++) {
+      player->schedule[i] = player->schedule[i + 1];
+    }
+    Player_Command(mas, player, command);
+    Use_Cache(mas->Cache_Use, command.cache_slot, -1);
+    taken = true;
+  }
+  if (taken) {
+    Player_Start(mas, player);
+  }
+  if (player->scheduled > 0 && (int32_t)(player->schedule[0].at - player->clock) < end) {
+    end = player->schedule[0].at - player->clock;
+  }
+  return end - pos;
+}//                                                                              due commands
+//------------------------------------------------------------------------------------muted
+// true if channel h stays at gain 0 for the whole block: its gain, the master volume or
+// the gain of its bus is 0 and does not ramp.
+static inline bool Muted(MAS_Player *player, uint8_t h) {
+  const MAS_Ramp *bus = &player->bus_gain[player->bus[h]];
+  return (player->gain[h].value == 0 && player->gain[h].target == 0) ||
+         (player->volume.value == 0 && player->volume.target == 0) ||
+         (bus->value == 0 && bus->target == 0);
+}//                                                                                    muted
+//----------------------------------------------------------------------------------mix channel
+// Adds a channel to the accumulator, a changing gain moves linearly over the block.
+static void Mix_Channel(int32_t *acc, const int16_t *in, int32_t gain_from, int32_t gain_to,
+                        int len) {
+  if (gain_from == gain_to) {
+    MAS_Mix_Add(acc, in, gain_to, len);
   }
   else {
-    i2s_driver_install((i2s_port_t)I2S_PORT_NUM, &i2s_config_DAC, 0, NULL);
+    MAS_Mix_Ramp(acc, in, gain_from, gain_to, len);
   }
-  i2s_set_pin((i2s_port_t)I2S_PORT_NUM, &pin_config);
-  i2s_zero_dma_buffer((i2s_port_t)I2S_PORT_NUM);
-  Serial.print("RUN I2S ON PORT_NUM: ");
-  Serial.println(I2S_PORT_NUM);
+}//                                                                               mix channel
+//--------------------------------------------------------------------------------player render
+// Renders buf_len_16 samples of the block from sample "from" on to player->out_buf_16.
+void Player_Render(ESP32_MAS_Base *mas, MAS_Player *player, int from, int buf_len_16) {
+  volatile uint8_t *Channel = mas->Channel; // 0 = STOP, 1 = BRAKE, 2 = PLAY, 3 = LOOP, ...
+  volatile uint16_t *Cache_Use = mas->Cache_Use; // files of the cache slots in use
+  MAS_Event_Queue *Event = &mas->Event; // state changes to the class
+  MAS_Stream *Stream = mas->Stream; // ring buffers of the channels
+  int ic = mas->Channels;
 
-  while (true) {
-    //------------------------------------------------------------------------AUDIO PLAYER LOOP
-    for (int h = 0; h < ic; h++) {
-      //--------------------------------------------------------------------------read channels
-      if (*Channel[h] > 1) {
-        pitch_loc = *Pitch[h];
-        //---------------------------------------------------------------------------------play
-        if (!aiff_file[h].available()) {
-          //--------------------------------------------------------------------------open file
-          aiff_file[h] = SPIFFS.open(*Audio_File[h], "r");
-          switch (*Channel[h]) {
-            case 2:
-              *Channel[h] = 5;
-              break;
-            case 3:
-              *Channel[h] = 4;
-              break;
-            case 4:
-              *Channel[h] = 4;
-              break;
-          }
-        }//                                                                           open file
-        //------------------------------------------------------------------read file to buffer
-        file_buf_len = aiff_file[h].available();
-        file_buf_len =  file_buf_len - (file_buf_len * pitch_loc) / 2;
-        if (file_buf_len > buf_len_16) {
-          file_buf_len = buf_len_16;
-          end_file = false;
+  int16_t **file_buf = player->file_buf;
+  int16_t *out; // file_buf of the channel, NULL = the voice moves without output
+  MAS_Ramp *gain = player->gain;
+  MAS_Envelope *envelope = player->envelope;
+  int32_t volume_from;
+  int32_t volume_to;
+  int32_t gain_from;
+  int32_t gain_to;
+  int32_t bus_from;
+  int32_t bus_to;
+  int32_t pan_left;
+  int32_t pan_right;
+  int oc = player->out_channels;
+  int32_t *acc;
+  bool direct;
+  bool used;
+  int16_t *out_buf_16 = player->out_buf_16 + from * player->out_channels;
+  float pitch_loc;
+  uint32_t step; // Q16
+  int avail;
+  uint32_t rem; // output samples until the end of the file
+  uint32_t fade_len;
+  uint32_t cut; // output samples until the next file starts
+  uint32_t carry; // Q16 position in the next file after a gapless change
+  int pos;
+  int fade_from;
+  int count;
+  for (int h = 0; h < ic; h++) {
+    //----------------------------------------------------------------------------read channels
+    MAS_Stream *stream = &Stream[h];
+    MAS_Voice *voice = &player->voice[h];
+    MAS_Voice *fade = &player->fade[h];
+    // A pitch ramp changes the pitch once per block to the value at the end of the block.
+    pitch_loc = MAS_Ramp_Next(&player->pitch[h], buf_len_16) / 65536.0f;
+    out = file_buf[h];
+    if (Channel[h] > 1 && player->engine_on[h]) {
+      //-----------------------------------------------------------------------------engine
+      // OUT fades the engine out over the block and stops it.
+      MAS_Engine_Render(&player->engine[h], file_buf[h], player->fade_buf, buf_len_16,
+                        pitch_loc, player->interpolation);
+      if (Channel[h] == 5) {
+        for (int i = 0; i < buf_len_16; i++) {
+          file_buf[h][i] = file_buf[h][i] * (buf_len_16 - i) / buf_len_16;
         }
-        else {
-          end_file = true;
+        player->engine_on[h] = false;
+        Set_State(Channel, h, 0, Event);
+      }
+    }//                                                                                  engine
+    else if (Channel[h] > 1) {
+      out = Muted(player, h) ? NULL : file_buf[h];
+      if (voice->wait && stream->open_ack == stream->open_req) {
+        //----------------------------------------------------------------------reader is ready
+        __sync_synchronize();
+        voice->tail = stream->file_start;
+        voice->file_end = stream->file_end;
+        voice->rate = stream->file_rate;
+        voice->wait = false;
+      }
+      //-----------------------------------------------------------------------------------play
+      // The next file starts at the output sample after the end of the file, the position
+      // behind the end is carried over. With a crossfade the next file starts fade_len
+      // samples before the end. At most 8 files per block, shorter files are cut.
+      pos = 0;
+      fade_from = -1;
+      for (int n = 0; pos < buf_len_16; n++) {
+        step = (1 + pitch_loc) * voice->rate / 22050 * MAS_PHASE_ONE;
+        avail = Available_File(voice);
+        rem = Out_Samples(avail, voice->phase, step);
+        fade_len = 0;
+        if (Channel[h] < 5 && player->segments[h] > 0 && fade->left == 0) {
+          fade_len = player->crossfade[h] < rem ? player->crossfade[h] : rem;
         }
-        for (int i = 0; i < file_buf_len; i++) {
-          file_buf[h][i] = aiff_file[h].read();
-          pitch[h] += pitch_loc;
-          if (pitch[h] >= 1) {
-            file_buf[h][i] = aiff_file[h].read();
-            pitch[h] -= 1;
+        cut = rem - fade_len;
+        if (n >= 8 || cut >= (uint32_t)(buf_len_16 - pos)) {
+          Read_File(stream, voice, out, pos, buf_len_16, step, player->interpolation);
+          break;
+        }
+        carry = voice->phase + (uint64_t)rem * step - ((uint64_t)(avail > 0 ? avail : 0) <<
+                MAS_PHASE_BITS);
+        Read_File(stream, voice, out, pos, pos + cut, step, player->interpolation);
+        pos += cut;
+        //------------------------------------------------------------------------end of file
+        if (fade_len > 0) {
+          //---------------------------------------------------------fade out the played file
+          *fade = *voice;
+          fade->left = fade_len;
+          fade->pos = 0;
+          fade->len = fade_len;
+          Use_Cache(Cache_Use, fade->slot, 1);
+          fade_from = pos;
+        }
+        if (Channel[h] > 4 || !Next_File(mas, player, h, false)) {
+          //---------------------------------------------------------------------stop channel
+          Drop_File(player, h, Cache_Use);
+          Set_State(Channel, h, 0, Event);
+          for (int i = pos; i < buf_len_16 && out != NULL; i++) {
+            file_buf[h][i] = 0;
           }
-        }//                                                                 read file to buffer
-        if (end_file) {
-          //--------------------------------------------------------------------------file emty
-          if (*Channel[h] < 5 && *Channel[h] > 1) {
-            //--------------------------------------------------------------------open new file
-            aiff_file[h] = SPIFFS.open(*Audio_File[h], "r");
-            switch (*Channel[h]) {
-              case 2:
-                *Channel[h] = 5;
-                break;
-              case 3:
-                *Channel[h] = 4;
-                break;
-              case 4:
-                *Channel[h] = 4;
-                break;
-            }
-            //-------------------------------------------------------read new file to to buffer
-            for (int i = file_buf_len; i  < buf_len_16; i++) {
-              file_buf[h][i] = aiff_file[h].read();
-              pitch[h] += pitch_loc;
-              if (pitch[h] >= 1) {
-                file_buf[h][i] = aiff_file[h].read();
-                pitch[h] -= 1;
-              }
-            }
-          }//                                                        read new file to to buffer
-          else {
-            //-----------------------------------------------------------cleare rest of channel
-            aiff_file[h].close();
-            *Channel[h] = 0;
-            for (int i = file_buf_len; i < buf_len_16; i++) {
-              file_buf[h][i] = 0;
-            }//for
-          }//                                                        cleare rest of the channel
-        }//                                                                           file emty
-      }//                                                                                  play
+          break;
+        }
+        if (fade_len == 0) {
+          voice->phase = carry;
+        }
+      }
+      if (fade->left > 0) {
+        //-------------------------------------------------------------------------crossfade
+        pos = fade_from < 0 ? 0 : fade_from;
+        count = buf_len_16 - pos;
+        count = (uint32_t)count < fade->left ? count : fade->left;
+        step = (1 + pitch_loc) * fade->rate / 22050 * MAS_PHASE_ONE;
+        Read_File(stream, fade, out == NULL ? NULL : player->fade_buf, 0, count, step,
+                  player->interpolation);
+        if (out != NULL) {
+          MAS_Mix_Fade(file_buf[h] + pos, player->fade_buf, fade->pos, fade->len, count);
+        }
+        fade->pos += count;
+        fade->left -= count;
+        if (fade->left == 0) {
+          Use_Cache(Cache_Use, fade->slot, -1);
+        }
+      }//                                                                           crossfade
+    }//                                                                                    play
+    else if (!player->silent[h]) {
+      //-----------------------------------------------------------------------------------stop
+      // Zeros until the filters of the channel have rung out, then the channel is silent.
+      for (int i = 0; i < buf_len_16; i++) {
+        //------------------------------------------------------------------write clear channel
+        file_buf[h][i] = 0;
+      }//                                                                   write clear channel
+    }//                                                                                    stop
+#if MAS_STATS
+    if (Channel[h] > 1 && from + buf_len_16 == mas->Block_Len) {
+      stream->active++;
+    }
+#endif
+    MAS_STATS_LAP(MAS_STAGE_VOICE);
+    if (out == NULL) {
+      player->silent[h] = true;
+    }
+    else if (Channel[h] > 1 || !player->silent[h]) {
+      MAS_Filter_Chain16(player->filter[h], file_buf[h], buf_len_16);
+      player->silent[h] = MAS_Mix_Silent(file_buf[h], buf_len_16, MAS_SILENCE);
+      if (player->silent[h] && Channel[h] <= 1) {
+        MAS_Filter_Clear(player->filter[h]); // the next file starts from silence
+      }
+    }
+    MAS_STATS_LAP(MAS_STAGE_DSP);
+    Keep_Ring(stream, voice, fade);
+  }//read channels
+  //--------------------------------------------------------------------------------------MIXER
+  // The master volume and the envelope are folded into the Q15 gain of every channel,
+  // the gain moves linearly from its value at the start to the value at the end of the block.
+  // The channels of a bus are summed in bus_buf and added to the master with the bus gain,
+  // a bus at a steady 0dB without filters adds its channels to the master directly.
+  // Silent channels and channels at gain 0 are not mixed, their ramps and envelopes move on.
+  // The inserts run on the 32 bit sums: the filters of a bus before its gain,
+  // the filters of the master and the limiter before the output.
+  volume_from = player->volume.value;
+  volume_to = MAS_Ramp_Next(&player->volume, buf_len_16);
+  MAS_Mix_Clear(player->mix_buf, buf_len_16 * oc);
+  for (int b = 0; b < MAS_BUSES; b++) {
+    //-------------------------------------------------------------------------------------bus
+    bus_from = player->bus_gain[b].value;
+    bus_to = MAS_Ramp_Next(&player->bus_gain[b], buf_len_16);
+    direct = bus_from == 32768 && bus_to == 32768 && !MAS_Filter_Used(player->bus_filter[b][0]);
+    acc = direct ? player->mix_buf : player->bus_buf;
+    used = MAS_Filter_Used(player->bus_filter[b][0]); // the filters ring out
+    if (used) {
+      MAS_Mix_Clear(acc, buf_len_16 * oc);
+    }
+    for (int h = 0; h < ic; h++) {
+      if (player->bus[h] != b) {
+        continue;
+      }
+      gain_from = MAS_Gain_Mul(MAS_Gain_Mul(gain[h].value, envelope[h].level.value), volume_from);
+      gain_to = MAS_Gain_Mul(MAS_Gain_Mul(MAS_Ramp_Next(&gain[h], buf_len_16),
+                                          MAS_Envelope_Next(&envelope[h], buf_len_16)), volume_to);
+      if (player->silent[h] || (gain_from == 0 && gain_to == 0)) {
+        //---------------------------------------------------------------inaudible, not mixed
+        if (oc == 2) {
+          MAS_Pan_Q15(player->pan[h], &player->pan_gain[h][0], &player->pan_gain[h][1]);
+        }
+      }
       else {
-        //---------------------------------------------------------------------------------stop
-        for (int i = 0; i < buf_len_16; i++) {
-          //----------------------------------------------------------------write clear channel
-          file_buf[h][i] = 0;
-        }//                                                                 write clear channel
-      }//                                                                                  stop
-    }//read channels
-    //------------------------------------------------------------------------------------MIXER
-    for (int i = 0; i < buf_len_16; i++) {
-      out_buf_16[i] = (file_buf[0][i] * (*Gain[0]) +
-                       file_buf[1][i] * (*Gain[1]) +
-                       file_buf[2][i] * (*Gain[2]))
-                      * float(*Volume / 255);
-    }//                                                                                   MIXER
-    for (int i = 0; i < buf_len_8; i = i + 2) {
-      //-----------------------------------------------------------------------write IS2 buffer
-      out_buf_8[i] = lowByte(out_buf_16[i / 2]);
-      out_buf_8[i + 1] = highByte(out_buf_16[i / 2]);
-    }//                                                                        write IS2 buffer
-    i2s_write_bytes((i2s_port_t)I2S_PORT_NUM, (const char *)&out_buf_8, buf_len_8, 500);
+        if (!used && !direct) {
+          MAS_Mix_Clear(acc, buf_len_16 * oc);
+        }
+        used = true;
+        player->mixed[h] = true;
+        if (oc == 1) {
+          Mix_Channel(acc, file_buf[h], gain_from, gain_to, buf_len_16);
+        }
+        else {
+          //-------------------------------------------------------constant power pan, stereo
+          MAS_Pan_Q15(player->pan[h], &pan_left, &pan_right);
+          Mix_Channel(acc, file_buf[h], MAS_Gain_Mul(gain_from, player->pan_gain[h][0]),
+                      MAS_Gain_Mul(gain_to, pan_left), buf_len_16);
+          Mix_Channel(acc + buf_len_16, file_buf[h],
+                      MAS_Gain_Mul(gain_from, player->pan_gain[h][1]),
+                      MAS_Gain_Mul(gain_to, pan_right), buf_len_16);
+          player->pan_gain[h][0] = pan_left;
+          player->pan_gain[h][1] = pan_right;
+        }
+      }
+      if (envelope[h].stage == MAS_ENV_END && Channel[h] > 1) {
+        //-------------------------------------------------------------the release has ended
+        player->engine_on[h] = false;
+        Drop_File(player, h, Cache_Use);
+        Stop_Fade(&player->fade[h], Cache_Use);
+        Set_State(Channel, h, 0, Event);
+      }
+    }
+    if (used && !direct) {
+      for (int c = 0; c < oc; c++) {
+        MAS_STATS_LAP(MAS_STAGE_MIX);
+        MAS_Filter_Chain(player->bus_filter[b][c], acc + c * buf_len_16, buf_len_16);
+        MAS_STATS_LAP(MAS_STAGE_DSP);
+        MAS_Mix_Bus(player->mix_buf + c * buf_len_16, acc + c * buf_len_16, bus_from, bus_to,
+                    buf_len_16);
+      }
+    }
+  }//                                                                                     bus
+  MAS_STATS_LAP(MAS_STAGE_MIX);
+  for (int c = 0; c < oc; c++) {
+    MAS_Filter_Chain(player->master_filter[c], player->mix_buf + c * buf_len_16, buf_len_16);
+  }
+  if (player->limiter.threshold > 0) {
+    MAS_Limiter_Run(&player->limiter, player->mix_buf,
+                    oc == 1 ? NULL : player->mix_buf + buf_len_16, buf_len_16);
+  }
+  MAS_STATS_LAP(MAS_STAGE_DSP);
+  if (oc == 1) {
+    MAS_Mix_Out(player->mix_buf, out_buf_16, buf_len_16);
+  }
+  else if (mas->Output->right_first) {
+    MAS_Mix_Out_Stereo(player->mix_buf + buf_len_16, player->mix_buf, out_buf_16, buf_len_16);
+  }
+  else {
+    MAS_Mix_Out_Stereo(player->mix_buf, player->mix_buf + buf_len_16, out_buf_16, buf_len_16);
+  }
+  MAS_STATS_LAP(MAS_STAGE_MIX);
+  //                                                                                      MIXER
+}//                                                                              player render
+//---------------------------------------------------------------------------------player block
+// Takes the commands and renders one block of Block_Len samples to player->out_buf_16.
+// A scheduled command splits the block, it takes effect at the sample of its clock.
+void Player_Block(ESP32_MAS_Base *mas, MAS_Player *player) {
+  volatile uint8_t *Channel = mas->Channel; // 0 = STOP, 1 = BRAKE, 2 = PLAY, 3 = LOOP, ...
+  int ic = mas->Channels;
+
+  int buf_len_16 = mas->Block_Len; // samples of a block = samples of a DMA buffer
+  int oc = player->out_channels;
+  bool quiet;
+  uint32_t block_start = MAS_Micros();
+  uint32_t render_time;
+  int count;
+  MAS_STATS_BEGIN();
+  memset(player->mixed, 0, ic * sizeof(bool));
+  Player_Commands(mas, player);
+  for (int pos = 0; pos < buf_len_16; pos += count) {
+    count = Player_Due(mas, player, pos);
+    Player_Render(mas, player, pos, count);
+  }
+  player->skipped = 0;
+  for (int h = 0; h < ic; h++) {
+    player->skipped += !player->mixed[h]; // once per block, also if the block was split
+  }
+  player->clock += buf_len_16;
+  mas->Clock = player->clock;
+  //--------------------------------------------------------------------------------------idle
+  // The player may sleep after Block_Count blocks without a playing channel and without
+  // output, then all buffers of the output hold silence.
+  quiet = MAS_Mix_Silent(player->out_buf_16, buf_len_16 * oc, 0);
+  quiet = quiet && player->scheduled == 0;
+  for (int h = 0; h < ic && quiet; h++) {
+    quiet = Channel[h] <= 1 && player->silent[h];
+  }
+  player->silent_blocks = quiet ? player->silent_blocks + 1 : 0;
+  //--------------------------------------------------------------------------------statistics
+  render_time = MAS_Micros() - block_start;
+  mas->Render_Time += ((int32_t)render_time - (int32_t)mas->Render_Time) / 16;
+  if (render_time > mas->Render_Max) {
+    mas->Render_Max = render_time;
+  }
+}//                                                                               player block
+#if MAS_STATS
+//----------------------------------------------------------------------------block statistics
+// Player only. Adds the block to the statistics, behind = result of Output->wait,
+// done = result of Output->write.
+void Stats_Block(ESP32_MAS_Base *mas, MAS_Player *player, uint8_t behind, bool done) {
+  MAS_Stats *stats = &mas->Stats;
+  uint32_t reset = mas->Stats_Reset;
+  uint32_t render = player->cycles[MAS_STAGE_VOICE] + player->cycles[MAS_STAGE_MIX] +
+                    player->cycles[MAS_STAGE_DSP];
+  uint32_t step;
+  mas->Stats_Gen++;
+  __sync_synchronize();
+  if (mas->Stats_Done != reset) {
+    *stats = MAS_Stats();
+    mas->Stats_Done = reset;
+  }
+  stats->cycle_rate = MAS_Cycle_Rate();
+  stats->block_cycles = (uint64_t)mas->Block_Len * stats->cycle_rate / 22050;
+  for (int s = MAS_STAGE_VOICE; s < MAS_STAGES; s++) {
+    Stats_Time(&stats->stage[s], player->cycles[s]);
+  }
+  Stats_Time(&stats->render, render);
+  step = (uint64_t)render * 10 / stats->block_cycles;
+  stats->load[step < MAS_LOAD_STEPS ? step : MAS_LOAD_STEPS - 1]++;
+  if (behind > 0) {
+    stats->late++;
+  }
+  if (behind > 0 && behind + 1 >= mas->Block_Count) {
+    stats->underrun++; // no DMA buffer was left
+  }
+  if (!done) {
+    stats->dropped++;
+  }
+  stats->skipped += player->skipped;
+  stats->idle += player->idled;
+  stats->unscheduled += player->unscheduled;
+  player->idled = 0;
+  player->unscheduled = 0;
+  __sync_synchronize();
+  mas->Stats_Gen++;
+}//                                                                          block statistics
+#endif
+//--------------------------------------------------------------------------------player output
+// Writes the block to the output, behind = result of Output->wait.
+void Player_Output(ESP32_MAS_Base *mas, MAS_Player *player, uint8_t behind) {
+#if MAS_STATS
+  bool done = mas->Output->write(player->out_buf_16, mas->Block_Len * mas->Out_Channels);
+  MAS_STATS_LAP(MAS_STAGE_OUT);
+  Stats_Block(mas, player, behind, done);
+#else
+  mas->Output->write(player->out_buf_16, mas->Block_Len * mas->Out_Channels);
+#endif
+}//                                                                             player output
+
+void Audio_Player(void *ptr) {
+  MAS_Log("Task Audio Player gestartet");
+
+  ESP32_MAS_Base *mas = (ESP32_MAS_Base*)ptr;
+  MAS_Player *player = Player_Begin(mas);
+  mas->Output->begin(22050, mas->Block_Len, mas->Block_Count, mas->Out_Channels);
+  while (!mas->Stopping) {
+    //------------------------------------------------------------------------AUDIO PLAYER LOOP
+    // The output sleeps until a block is free (I2S: a DMA buffer was sent), the player
+    // renders one block into it.
+    if (player->silent_blocks >= mas->Block_Count) {
+      //-----------------------------------------------------------sleep until the next command
+      // Sleeping is set before the queue is read, so a command queued after the read
+      // finds it set and gives Wake (see wakePlayer).
+      mas->Output->idle(true);
+      mas->Sleeping = true;
+      __sync_synchronize();
+      while (mas->Command.pushed() == mas->Command.popped() && !mas->Stopping) {
+        mas->Wake.take(1000);
+      }
+      mas->Sleeping = false;
+      mas->Output->idle(false);
+      player->silent_blocks = 0;
+      player->idled++;
+    }
+    uint8_t behind = mas->Output->wait();
+    Player_Block(mas, player);
+    Player_Output(mas, player, behind);
   }//                                                                         AUDIO PLAYER LOOP
+  mas->Output->end();
+  Player_End(mas, player);
+  __sync_fetch_and_sub(&mas->Tasks, 1);
+  MAS_End_Task();
 }//                                                                           VOID AUDIO PLAYER
 
-ESP32_MAS::ESP32_MAS() {
-  int iz = 0;
-  int ic = 3;
-  for (int i = 0; i < ic; i++) {
-    ptr_array[iz] = &Audio_File[i];
-    iz++;
-  }
-  ptr_array[iz] = &I2S_PORT; iz++;
-  ptr_array[iz] = &I2S_BCK; iz++;
-  ptr_array[iz] = &I2S_WS; iz++;
-  ptr_array[iz] = &I2S_DATA; iz++;
-  ptr_array[iz] = &I2S_noDAC; iz++;
-  ptr_array[iz] = &Volume;  iz++;
-  for (int i = 0; i < ic; i++) {
-    ptr_array[iz] = &Channel[i];
-    iz++;
-  }
-  for (int i = 0; i < ic; i++) {
-    ptr_array[iz] = &Gain[i];
-    iz++;
-  }
-  for (int i = 0; i < ic; i++) {
-    ptr_array[iz] = &Pitch[i];
-    iz++;
-  }
-};
-void ESP32_MAS::setPort(uint8_t port) {
-  I2S_PORT = port;
-};
-void ESP32_MAS::setOut(uint8_t bck, uint8_t ws, uint8_t data) {
-  I2S_BCK = bck;
-  I2S_WS = ws;
-  I2S_DATA = data;
-};
-void ESP32_MAS::setDAC(bool dac) {
-  I2S_noDAC = dac;
-};
-void ESP32_MAS::startDAC() {
-  xTaskCreatePinnedToCore(Audio_Player, "Audio_Player", 10000, (void*)&ptr_array, 1, NULL, 0);
-  Serial.println("Pinned AUDIO PLAYER to core 0");
-};
-void ESP32_MAS::setVolume(uint8_t volume) {
-  Volume = volume;
+ESP32_MAS_Base::ESP32_MAS_Base(uint8_t channels, uint8_t *channel, uint8_t *gain, float *pitch,
+                               uint8_t *priority, uint32_t *voice_age, uint32_t *chan_cmd,
+                               int8_t *cache_slot, uint16_t *crossfade, uint16_t *rpm,
+                               uint8_t *layers, int8_t *pan, uint8_t *bus,
+                               MAS_Stream *stream) :
+  Channels(channels) {
+  Channel = channel;
+  Gain = gain;
+  Pitch = pitch;
+  Priority = priority;
+  Voice_Age = voice_age;
+  Chan_Cmd = chan_cmd;
+  Cache_Slot = cache_slot;
+  Crossfade = crossfade;
+  RPM = rpm;
+  Layers = layers;
+  Pan = pan;
+  Bus = bus;
+  Stream = stream;
+  for (int b = 0; b < MAS_BUSES; b++) {
+    Bus_Gain[b] = 255;
+  }
+#ifdef ARDUINO
+  Output = &I2S_Output;
+#endif
 };
-void ESP32_MAS::stopChan(uint8_t channel) {
-  Channel[channel] = 0;
+void ESP32_MAS_Base::initChannels() {
+  for (int i = 0; i < Channels; i++) {
+    Channel[i] = 0;
+    Gain[i] = 128;
+    Pitch[i] = 0;
+    Priority[i] = 0;
+    Voice_Age[i] = 0;
+    Chan_Cmd[i] = 0;
+    Cache_Slot[i] = -1;
+    Crossfade[i] = 0;
+    RPM[i] = 0;
+    Layers[i] = 0;
+    Pan[i] = 0;
+    Bus[i] = 0;
+  }
 };
-void ESP32_MAS::brakeChan(uint8_t channel) {
-  Channel[channel] = 1;
+void ESP32_MAS_Base::endChannels() {
+  //-----------------------------------------------------------stop the player and the reader
+  // Called by the destructor of ESP32_MAS<channels> while the channel arrays exist.
+  Stopping = true;
+  wakePlayer();
+  while (Tasks > 0) {
+    MAS_Sleep(1);
+  }
+  if (Player != NULL) {
+    Player_End(this, Player);
+    Player = NULL;
+  }
+  for (int i = 0; i < Channels; i++) {
+    Stream[i].file.close();
+    free(Stream[i].buf);
+    Stream[i].buf = NULL;
+  }
+  free(Read_Buf);
+  free(Read_PCM);
+  Read_Buf = NULL;
+  Read_PCM = NULL;
 };
-void ESP32_MAS::playFile(uint8_t channel, String audio_file) {
-  Audio_File[channel] = audio_file;
-  Channel[channel] = 2;
+ESP32_MAS_Base::~ESP32_MAS_Base() {
+  free(Cache_Slab);
 };
-void ESP32_MAS::loopFile(uint8_t channel, String audio_file) {
-  Audio_File[channel] = audio_file;
-  Channel[channel] = 3;
+void ESP32_MAS_Base::setPort(uint8_t port) {
+#ifdef ARDUINO
+  I2S_Output.port = port;
+#endif
 };
-void ESP32_MAS::runChan(uint8_t channel) {
-  Channel[channel] = 4;
+void ESP32_MAS_Base::setOut(uint8_t bck, uint8_t ws, uint8_t data) {
+#ifdef ARDUINO
+  I2S_Output.bck = bck;
+  I2S_Output.ws = ws;
+  I2S_Output.data = data;
+#endif
 };
-void ESP32_MAS::outChan(uint8_t channel) {
-  Channel[channel] = 5;
+void ESP32_MAS_Base::setDAC(bool dac) {
+#ifdef ARDUINO
+  I2S_Output.internal_dac = dac;
+#endif
 };
-void ESP32_MAS::setGain(uint8_t channel, uint8_t gain) {
-  Gain[channel] = gain;
+void ESP32_MAS_Base::setOutput(MAS_Output *output) {
+  Output = output;
 };
-void ESP32_MAS::setPitch(uint8_t channel, float pitch) {
-  if (pitch < 0) {
-    pitch = 0;
+void ESP32_MAS_Base::setCache(uint32_t size) {
+  if (Cache_Slab == NULL) {
+    Cache_Size = size & ~1ul;
   }
-  if (pitch > 1) {
-    pitch = 1;
+};
+void ESP32_MAS_Base::setStereo(bool stereo) {
+  if (!Started && Player == NULL) {
+    Out_Channels = stereo ? 2 : 1;
   }
-  Pitch[channel] = pitch;
 };
-String ESP32_MAS::getChan(uint8_t channel) {
-  String Return;
-  switch (Channel[channel]) {
-    case 0: //  0 = STOP, 1 = BRAKE, 2 = PLAY, 3 = LOOP, 4 = RUN, 5 = OUT
-      Return = "STOP";
-      break;
-    case 1:
-      Return = "BRAKE";
-      break;
-    case 2:
-      Return = "PLAY";
-      break;
-    case 3:
-      Return = "LOOP";
+bool ESP32_MAS_Base::openBank(const char *name) {
+  return Bank.open(name);
+};
+void ESP32_MAS_Base::setBuffer(uint16_t block, uint8_t count) {
+  Block_Len = block < 32 ? 32 : block > 1024 ? 1024 : block;
+  Block_Count = count < 2 ? 2 : count;
+};
+void ESP32_MAS_Base::initStreams() {
+  for (int i = 0; i < Channels; i++) {
+    Stream[i].buf = (int16_t*)calloc(MAS_STREAM_SIZE, sizeof(int16_t));
+  }
+  Read_Buf = (uint8_t*)malloc(MAS_STREAM_BLOCK);
+  Read_PCM = (int16_t*)malloc(MAS_STREAM_PCM * sizeof(int16_t));
+};
+void ESP32_MAS_Base::startDAC() {
+  if (Started || Player != NULL || Output == NULL) {
+    MAS_Log("NO OUTPUT FOR THE AUDIO PLAYER");
+    return;
+  }
+  initStreams();
+  Started = true;
+  Tasks = 2;
+  MAS_Start_Task(Audio_Reader, "Audio_Reader", 4096, (void*)this, 2, 1);
+  MAS_Log("Pinned AUDIO READER to core 1");
+  MAS_Start_Task(Audio_Player, "Audio_Player", 10000, (void*)this, 1, 0);
+  MAS_Log("Pinned AUDIO PLAYER to core 0");
+};
+uint32_t ESP32_MAS_Base::renderOffline(float seconds) {
+  if (Started || Output == NULL) {
+    return 0;
+  }
+  if (Player == NULL) {
+    //-------------------------------------------------------------------------first call
+    initStreams();
+    Player = Player_Begin(this);
+    Output->begin(22050, Block_Len, Block_Count, Out_Channels);
+  }
+  uint32_t blocks = (seconds * 22050 + Block_Len - 1) / Block_Len;
+  for (uint32_t b = 0; b < blocks; b++) {
+    //--------------------------the reader opens and fills all files of the commands in time
+    Player_Commands(this, Player);
+    while (Reader_Step(this)) {
+    }
+    Player_Block(this, Player);
+    Player_Output(this, Player, 0);
+  }
+  return blocks * Block_Len;
+};
+void ESP32_MAS_Base::setVolume(uint8_t volume) {
+  rampVolume(volume, 0);
+};
+void ESP32_MAS_Base::rampVolume(uint8_t volume, uint16_t ms) {
+  MAS_Command command;
+  Volume = volume;
+  command.type = MAS_CMD_VOLUME;
+  command.value = volume;
+  command.time[0] = (uint32_t)ms * 22050 / 1000;
+  sendCommand(&command);
+};
+bool ESP32_MAS_Base::preloadFile(String audio_file) {
+  int slot = findCache(audio_file.c_str());
+  int gap = -1;
+  MAS_Format format;
+  MAS_Sound sound;
+  if (Bank.find(audio_file.c_str(), &sound)) {
+    return true; // played from the sound bank
+  }
+  if (slot >= 0) {
+    Cache_Age[slot] = ++Cache_Tick;
+    return true;
+  }
+  MAS_File aiff_file;
+  if (!aiff_file.open(audio_file.c_str())) {
+    return false;
+  }
+  if (!MAS_Read_Format(&aiff_file, &format) || format.block_align > MAS_STREAM_BLOCK) {
+    aiff_file.close();
+    return false;
+  }
+  uint32_t len = format.decoder->samples(&format, format.data_len);
+  if (len == 0 || len > Cache_Size / 2) {
+    aiff_file.close();
+    return false;
+  }
+  if (Cache_Slab == NULL) {
+    //-----------------------------------------------------------------------allocate the slab
+    Cache_Slab = (int16_t*)MAS_Alloc_Large(Cache_Size);
+    if (Cache_Slab == NULL) {
+      aiff_file.close();
+      return false;
+    }
+  }
+  for (int i = 0; i < MAS_CACHE_SLOTS; i++) {
+    if (Cache_Ptr[i] == NULL) {
+      slot = i;
       break;
-    case 4:
-      Return = "RUN";
+    }
+  }
+  while (true) {
+    if (slot >= 0) {
+      gap = findGap(len);
+      if (gap >= 0) {
+        break;
+      }
+    }
+    //----------------------------------------------------------remove least recently used file
+    while (Started && Command.popped() != Command.pushed()) {
+      //-------------------------------------------------the player takes the queued cache slots
+      MAS_Sleep(1);
+    }
+    if (Command.popped() != Command.pushed() || Batch_Len > 0) {
+      //-------------no player is running or a batch is open, the commands keep their slots
+      aiff_file.close();
+      return false;
+    }
+    int lru = -1;
+    for (int i = 0; i < MAS_CACHE_SLOTS; i++) {
+      bool used = Cache_Ptr[i] == NULL || Cache_Use[i] > 0;
+      for (int c = 0; c < Channels; c++) {
+        if (Cache_Slot[c] == i) {
+          used = true;
+        }
+      }
+      if (!used && (lru < 0 || Cache_Age[i] < Cache_Age[lru])) {
+        lru = i;
+      }
+    }
+    if (lru < 0) {
+      aiff_file.close();
+      return false;
+    }
+    Cache_Ptr[lru] = NULL;
+    Cache_File[lru] = "";
+    if (slot < 0) {
+      slot = lru;
+    }
+  }
+  //-------------------------------------------------------------------decode file to the slab
+  uint8_t file_buf[MAS_STREAM_BLOCK];
+  uint32_t remain = format.data_len;
+  uint32_t count = 0;
+  int block = MAS_STREAM_BLOCK - MAS_STREAM_BLOCK % format.block_align;
+  while (remain > 0) {
+    int read_len = aiff_file.read(file_buf, remain < (uint32_t)block ? remain : block);
+    if (read_len <= 0) {
       break;
-    case 5:
-      Return = "OUT";
+    }
+    remain -= read_len;
+    count += format.decoder->decode(&format, file_buf, read_len, Cache_Slab + gap + count);
+  }
+  aiff_file.close();
+  Cache_File[slot] = audio_file;
+  Cache_Len[slot] = count;
+  Cache_Rate[slot] = format.rate;
+  Cache_Age[slot] = ++Cache_Tick;
+  Cache_Ptr[slot] = Cache_Slab + gap;
+  return true;
+};
+int8_t ESP32_MAS_Base::findSound(const char *audio_file, MAS_Sound *sound) {
+  //------------------------------------------sound bank, sample cache, else -1 and no data
+  if (Bank.find(audio_file, sound)) {
+    return -1;
+  }
+  int slot = findCache(audio_file);
+  if (slot >= 0) {
+    Cache_Age[slot] = ++Cache_Tick;
+    sound->data = Cache_Ptr[slot];
+    sound->len = Cache_Len[slot];
+    sound->rate = Cache_Rate[slot];
+    sound->loop_start = 0;
+    sound->loop_end = Cache_Len[slot];
+  }
+  return slot;
+};
+int ESP32_MAS_Base::findCache(const char *audio_file) {
+  for (int i = 0; i < MAS_CACHE_SLOTS; i++) {
+    if (Cache_Ptr[i] != NULL && strcmp(Cache_File[i].c_str(), audio_file) == 0) {
+      return i;
+    }
+  }
+  return -1;
+};
+int ESP32_MAS_Base::findGap(uint32_t len) {
+  //--------------------------------first free range of the slab that is big enough (samples)
+  for (int c = -1; c < MAS_CACHE_SLOTS; c++) {
+    uint32_t start = 0;
+    if (c >= 0) {
+      if (Cache_Ptr[c] == NULL) {
+        continue;
+      }
+      start = (Cache_Ptr[c] - Cache_Slab) + Cache_Len[c];
+    }
+    bool fits = start + len <= Cache_Size / 2;
+    for (int i = 0; i < MAS_CACHE_SLOTS && fits; i++) {
+      if (Cache_Ptr[i] != NULL) {
+        uint32_t begin = Cache_Ptr[i] - Cache_Slab;
+        if (start < begin + Cache_Len[i] && begin < start + len) {
+          fits = false;
+        }
+      }
+    }
+    if (fits) {
+      return start;
+    }
+  }
+  return -1;
+};
+// Returns false if the command was lost: the queue is full and the player does not run.
+bool ESP32_MAS_Base::sendCommand(MAS_Command *command) {
+  command->timed = Timed;
+  command->at = Time_At;
+  if (Batching) {
+    //----------------------------------------------------------------collect for sendBatch
+    if (Batch_Len == MAS_BATCH) {
+      pushBatch();
+    }
+    Batch[Batch_Len++] = *command;
+    return true;
+  }
+  while (!Command.push(*command)) {
+    if (!Started) {
+      return false; // the player is not running, gain, pitch and volume are taken at start
+    }
+    MAS_Sleep(1);
+  }
+  wakePlayer();
+  return true;
+};
+// Returns false if the batch was lost, its file commands no longer hold their channels.
+bool ESP32_MAS_Base::pushBatch() {
+  bool pushed = true;
+  while (!Command.push(Batch, Batch_Len)) {
+    if (!Started) {
+      pushed = false; // the player is not running, the batch is lost like single commands
       break;
+    }
+    MAS_Sleep(1);
+  }
+  for (int i = 0; i < Batch_Len && !pushed; i++) {
+    //--------------------------------------------------------------------release lost voices
+    MAS_Command *lost = &Batch[i];
+    if (lost->type == MAS_CMD_PLAY || lost->type == MAS_CMD_LOOP ||
+        lost->type == MAS_CMD_ENGINE) {
+      Chan_Cmd[lost->channel] = Command.pushed();
+      Stream[lost->channel].at_req -= lost->timed;
+    }
+  }
+  Batch_Len = 0;
+  wakePlayer();
+  return pushed;
+};
+// Wakes the player if it sleeps without commands. Sleeping is read after the command was
+// queued, the player sets it before it reads the queue: one of both sees the other.
+void ESP32_MAS_Base::wakePlayer() {
+  __sync_synchronize();
+  if (Sleeping) {
+    Wake.give();
+  }
+};
+MAS_Voice_Handle ESP32_MAS_Base::sendFile(uint8_t type, uint8_t channel,
+                                          const char *audio_file, bool restart, bool queue) {
+  MAS_Command command;
+  MAS_Voice_Handle voice;
+  command.type = type;
+  command.channel = channel;
+  command.restart = restart;
+  command.value = queue;
+  command.cache_slot = findSound(audio_file, &command.sound);
+  strncpy(command.file, audio_file, MAS_NAME_SIZE - 1);
+  if (!sendCommand(&command)) {
+    return voice; // lost, the channel keeps its file
+  }
+  Cache_Slot[channel] = command.cache_slot;
+  Chan_Cmd[channel] = Command.pushed() + Batch_Len;
+  if (Timed) {
+    Stream[channel].at_req++;
+  }
+  voice.channel = channel;
+  voice.state = type == MAS_CMD_LOOP ? MAS_LOOP : MAS_PLAY;
+  voice.command = Chan_Cmd[channel];
+  return voice;
+};
+MAS_Voice_Handle ESP32_MAS_Base::sendAny(uint8_t type, const char *audio_file,
+                                         uint8_t priority) {
+  int8_t channel = findVoice(priority);
+  if (channel < 0) {
+    return MAS_Voice_Handle();
+  }
+  Priority[channel] = priority;
+  Voice_Age[channel] = ++Voice_Tick;
+  return sendFile(type, channel, audio_file, true, false);
+};
+void ESP32_MAS_Base::stopChan(uint8_t channel) {
+  MAS_Command command;
+  command.type = MAS_CMD_STOP;
+  command.channel = channel;
+  sendCommand(&command);
+};
+void ESP32_MAS_Base::brakeChan(uint8_t channel) {
+  MAS_Command command;
+  command.type = MAS_CMD_BRAKE;
+  command.channel = channel;
+  sendCommand(&command);
+};
+void ESP32_MAS_Base::playFile(uint8_t channel, String audio_file) {
+  sendFile(MAS_CMD_PLAY, channel, audio_file.c_str(), false, false);
+};
+void ESP32_MAS_Base::loopFile(uint8_t channel, String audio_file) {
+  sendFile(MAS_CMD_LOOP, channel, audio_file.c_str(), false, false);
+};
+void ESP32_MAS_Base::queueFile(uint8_t channel, String audio_file, bool loop) {
+  sendFile(loop ? MAS_CMD_LOOP : MAS_CMD_PLAY, channel, audio_file.c_str(), false, true);
+};
+int8_t ESP32_MAS_Base::playAny(String audio_file, uint8_t priority) {
+  return sendAny(MAS_CMD_PLAY, audio_file.c_str(), priority).channel;
+};
+int8_t ESP32_MAS_Base::loopAny(String audio_file, uint8_t priority) {
+  return sendAny(MAS_CMD_LOOP, audio_file.c_str(), priority).channel;
+};
+MAS_Sound_Id ESP32_MAS_Base::addSound(const char *audio_file) {
+  for (uint16_t i = 0; i < Sound_Count; i++) {
+    if (strcmp(Sound_File[i], audio_file) == 0) {
+      return i;
+    }
+  }
+  if (Sound_Count >= MAS_SOUNDS) {
+    return -1;
+  }
+  Sound_File[Sound_Count] = audio_file;
+  return Sound_Count++;
+};
+void ESP32_MAS_Base::setSounds(const char *const *audio_files, uint16_t count) {
+  Sound_Count = count < MAS_SOUNDS ? count : MAS_SOUNDS;
+  for (uint16_t i = 0; i < Sound_Count; i++) {
+    Sound_File[i] = audio_files[i];
+  }
+};
+MAS_Voice_Handle ESP32_MAS_Base::playSound(uint8_t channel, MAS_Sound_Id sound) {
+  if (sound < 0 || sound >= Sound_Count) {
+    return MAS_Voice_Handle();
+  }
+  return sendFile(MAS_CMD_PLAY, channel, Sound_File[sound], false, false);
+};
+MAS_Voice_Handle ESP32_MAS_Base::loopSound(uint8_t channel, MAS_Sound_Id sound) {
+  if (sound < 0 || sound >= Sound_Count) {
+    return MAS_Voice_Handle();
+  }
+  return sendFile(MAS_CMD_LOOP, channel, Sound_File[sound], false, false);
+};
+MAS_Voice_Handle ESP32_MAS_Base::queueSound(uint8_t channel, MAS_Sound_Id sound, bool loop) {
+  if (sound < 0 || sound >= Sound_Count) {
+    return MAS_Voice_Handle();
+  }
+  return sendFile(loop ? MAS_CMD_LOOP : MAS_CMD_PLAY, channel, Sound_File[sound], false, true);
+};
+MAS_Voice_Handle ESP32_MAS_Base::playAny(MAS_Sound_Id sound, uint8_t priority) {
+  if (sound < 0 || sound >= Sound_Count) {
+    return MAS_Voice_Handle();
+  }
+  return sendAny(MAS_CMD_PLAY, Sound_File[sound], priority);
+};
+MAS_Voice_Handle ESP32_MAS_Base::loopAny(MAS_Sound_Id sound, uint8_t priority) {
+  if (sound < 0 || sound >= Sound_Count) {
+    return MAS_Voice_Handle();
+  }
+  return sendAny(MAS_CMD_LOOP, Sound_File[sound], priority);
+};
+bool ESP32_MAS_Base::stopVoice(MAS_Voice_Handle voice) {
+  if (getVoice(voice) == MAS_STOP) {
+    return false; // ended or the channel was taken by another file
+  }
+  stopChan(voice.channel);
+  return true;
+};
+int8_t ESP32_MAS_Base::findVoice(uint8_t priority) {
+  //-------------------------first stopped channel, else the oldest channel of lowest priority
+  int8_t voice = -1;
+  for (int c = 0; c < Channels; c++) {
+    if (Channel[c] == 0 && (int32_t)(Command.popped() - Chan_Cmd[c]) >= 0 &&
+        Stream[c].at_req == Stream[c].at_ack) {
+      //-------------------------------------------stopped and no file command queued or scheduled
+      return c;
+    }
+    if (Priority[c] <= priority &&
+        (voice < 0 || Priority[c] < Priority[voice] ||
+         (Priority[c] == Priority[voice] && Voice_Age[c] < Voice_Age[voice]))) {
+      voice = c;
+    }
+  }
+  return voice;
+};
+void ESP32_MAS_Base::runChan(uint8_t channel) {
+  MAS_Command command;
+  command.type = MAS_CMD_RUN;
+  command.channel = channel;
+  sendCommand(&command);
+};
+void ESP32_MAS_Base::outChan(uint8_t channel) {
+  MAS_Command command;
+  command.type = MAS_CMD_OUT;
+  command.channel = channel;
+  sendCommand(&command);
+};
+void ESP32_MAS_Base::setGain(uint8_t channel, uint8_t gain) {
+  rampGain(channel, gain, 0);
+};
+void ESP32_MAS_Base::rampGain(uint8_t channel, uint8_t gain, uint16_t ms) {
+  MAS_Command command;
+  Gain[channel] = gain;
+  command.type = MAS_CMD_GAIN;
+  command.channel = channel;
+  command.value = gain;
+  command.time[0] = (uint32_t)ms * 22050 / 1000;
+  sendCommand(&command);
+};
+void ESP32_MAS_Base::setEnvelope(uint8_t channel, uint16_t attack, uint16_t decay,
+                                 uint8_t sustain, uint16_t release) {
+  MAS_Command command;
+  command.type = MAS_CMD_ENVELOPE;
+  command.channel = channel;
+  command.value = sustain;
+  command.time[0] = (uint32_t)attack * 22050 / 1000;
+  command.time[1] = (uint32_t)decay * 22050 / 1000;
+  command.time[2] = (uint32_t)release * 22050 / 1000;
+  sendCommand(&command);
+};
+void ESP32_MAS_Base::releaseChan(uint8_t channel) {
+  MAS_Command command;
+  command.type = MAS_CMD_RELEASE;
+  command.channel = channel;
+  sendCommand(&command);
+};
+void ESP32_MAS_Base::setPan(uint8_t channel, int8_t pan) {
+  MAS_Command command;
+  Pan[channel] = pan < -127 ? -127 : pan;
+  command.type = MAS_CMD_PAN;
+  command.channel = channel;
+  command.value = (uint8_t)Pan[channel];
+  sendCommand(&command);
+};
+void ESP32_MAS_Base::setBus(uint8_t channel, uint8_t bus) {
+  MAS_Command command;
+  Bus[channel] = bus < MAS_BUSES ? bus : MAS_BUSES - 1;
+  command.type = MAS_CMD_BUS;
+  command.channel = channel;
+  command.value = Bus[channel];
+  sendCommand(&command);
+};
+void ESP32_MAS_Base::setBusGain(uint8_t bus, uint8_t gain) {
+  rampBusGain(bus, gain, 0);
+};
+void ESP32_MAS_Base::rampBusGain(uint8_t bus, uint8_t gain, uint16_t ms) {
+  MAS_Command command;
+  if (bus >= MAS_BUSES) {
+    return;
+  }
+  Bus_Gain[bus] = gain;
+  command.type = MAS_CMD_BUS_GAIN;
+  command.value = bus << 8 | gain;
+  command.time[0] = (uint32_t)ms * 22050 / 1000;
+  sendCommand(&command);
+};
+void ESP32_MAS_Base::sendFilter(uint8_t type, uint8_t channel, uint8_t bus, uint8_t slot,
+                                uint8_t filter, uint16_t freq, float q, float gain) {
+  MAS_Command command;
+  if (slot >= MAS_FILTERS) {
+    return;
+  }
+  command.type = type;
+  command.channel = channel;
+  command.value = bus;
+  command.filter.type = filter;
+  command.filter.slot = slot;
+  command.filter.freq = freq;
+  command.filter.q = q;
+  command.filter.gain = gain;
+  sendCommand(&command);
+};
+void ESP32_MAS_Base::setFilter(uint8_t channel, uint8_t slot, uint8_t type, uint16_t freq,
+                               float q, float gain) {
+  sendFilter(MAS_CMD_FILTER, channel, 0, slot, type, freq, q, gain);
+};
+void ESP32_MAS_Base::setBusFilter(uint8_t bus, uint8_t slot, uint8_t type, uint16_t freq,
+                                  float q, float gain) {
+  if (bus < MAS_BUSES) {
+    sendFilter(MAS_CMD_BUS_FILTER, 0, bus, slot, type, freq, q, gain);
+  }
+};
+void ESP32_MAS_Base::setMasterFilter(uint8_t slot, uint8_t type, uint16_t freq, float q,
+                                     float gain) {
+  sendFilter(MAS_CMD_MASTER_FILTER, 0, 0, slot, type, freq, q, gain);
+};
+void ESP32_MAS_Base::setLimiter(uint8_t threshold, uint16_t release) {
+  MAS_Command command;
+  command.type = MAS_CMD_LIMITER;
+  command.value = threshold;
+  command.time[0] = (uint32_t)release * 22050 / 1000;
+  sendCommand(&command);
+};
+void ESP32_MAS_Base::setPriority(uint8_t channel, uint8_t priority) {
+  Priority[channel] = priority;
+};
+void ESP32_MAS_Base::setCrossfade(uint8_t channel, uint16_t samples) {
+  MAS_Command command;
+  Crossfade[channel] = samples;
+  command.type = MAS_CMD_CROSSFADE;
+  command.channel = channel;
+  command.value = samples;
+  sendCommand(&command);
+};
+bool ESP32_MAS_Base::addLayer(uint8_t channel, String audio_file, uint16_t rpm) {
+  MAS_Command command;
+  if (Layers[channel] >= MAS_ENGINE_LAYERS || !preloadFile(audio_file)) {
+    return false;
   }
-  return Return;
+  command.type = MAS_CMD_LAYER;
+  command.channel = channel;
+  command.value = rpm;
+  command.cache_slot = findSound(audio_file.c_str(), &command.sound);
+  sendCommand(&command);
+  Layers[channel]++;
+  return true;
 };
-uint8_t ESP32_MAS::getGain(uint8_t channel) {
+void ESP32_MAS_Base::clearLayers(uint8_t channel) {
+  MAS_Command command;
+  command.type = MAS_CMD_LAYER;
+  command.channel = channel;
+  sendCommand(&command);
+  Layers[channel] = 0;
+};
+void ESP32_MAS_Base::startEngine(uint8_t channel) {
+  MAS_Command command;
+  command.type = MAS_CMD_ENGINE;
+  command.channel = channel;
+  if (!sendCommand(&command)) {
+    return;
+  }
+  Cache_Slot[channel] = -1;
+  Chan_Cmd[channel] = Command.pushed() + Batch_Len;
+  if (Timed) {
+    Stream[channel].at_req++;
+  }
+};
+void ESP32_MAS_Base::setRPM(uint8_t channel, uint16_t rpm) {
+  MAS_Command command;
+  RPM[channel] = rpm;
+  command.type = MAS_CMD_RPM;
+  command.channel = channel;
+  command.value = rpm;
+  sendCommand(&command);
+};
+void ESP32_MAS_Base::setPitch(uint8_t channel, float pitch) {
+  rampPitch(channel, pitch, 0);
+};
+void ESP32_MAS_Base::rampPitch(uint8_t channel, float pitch, uint16_t ms) {
+  if (pitch < -0.75) {
+    pitch = -0.75;
+  }
+  if (pitch > 3) {
+    pitch = 3;
+  }
+  MAS_Command command;
+  Pitch[channel] = pitch;
+  command.type = MAS_CMD_PITCH;
+  command.channel = channel;
+  command.pitch = pitch;
+  command.time[0] = (uint32_t)ms * 22050 / 1000;
+  sendCommand(&command);
+};
+String ESP32_MAS_Base::getChan(uint8_t channel) {
+  static const char *const State_Name[] = {"STOP", "BRAKE", "PLAY", "LOOP", "RUN", "OUT"};
+  return State_Name[getState(channel)];
+};
+MAS_State ESP32_MAS_Base::getState(uint8_t channel) {
+  return (MAS_State)Channel[channel];
+};
+MAS_State ESP32_MAS_Base::getVoice(MAS_Voice_Handle voice) {
+  if (voice.channel < 0 || voice.channel >= Channels || Chan_Cmd[voice.channel] != voice.command) {
+    return MAS_STOP; // another file command was sent to the channel
+  }
+  if ((int32_t)(Command.popped() - voice.command) < 0 ||
+      Stream[voice.channel].at_req != Stream[voice.channel].at_ack) {
+    return voice.state; // the player has not taken or not started the command yet
+  }
+  return getState(voice.channel);
+};
+void ESP32_MAS_Base::getStates(MAS_Channel_Info *info) {
+  for (int c = 0; c < Channels; c++) {
+    info[c].state = getState(c);
+    info[c].gain = Gain[c];
+    info[c].priority = Priority[c];
+    info[c].rpm = RPM[c];
+    info[c].pan = Pan[c];
+    info[c].bus = Bus[c];
+    info[c].pitch = Pitch[c];
+    info[c].underrun = Stream[c].underrun;
+    info[c].active = Stream[c].active;
+  }
+};
+void ESP32_MAS_Base::setInterpolation(uint8_t mode) {
+  MAS_Command command;
+  Interpolation = mode <= MAS_BOX ? mode : 1;
+  command.type = MAS_CMD_INTERPOLATION;
+  command.value = Interpolation;
+  sendCommand(&command);
+};
+uint8_t ESP32_MAS_Base::getGain(uint8_t channel) {
   return Gain[channel];
 };
-float ESP32_MAS::getPitch(uint8_t channel) {
+float ESP32_MAS_Base::getPitch(uint8_t channel) {
   return Pitch[channel];
 };
+uint8_t ESP32_MAS_Base::getPriority(uint8_t channel) {
+  return Priority[channel];
+};
+uint16_t ESP32_MAS_Base::getCrossfade(uint8_t channel) {
+  return Crossfade[channel];
+};
+uint16_t ESP32_MAS_Base::getRPM(uint8_t channel) {
+  return RPM[channel];
+};
+int8_t ESP32_MAS_Base::getPan(uint8_t channel) {
+  return Pan[channel];
+};
+uint8_t ESP32_MAS_Base::getBus(uint8_t channel) {
+  return Bus[channel];
+};
+uint8_t ESP32_MAS_Base::getBusGain(uint8_t bus) {
+  return bus < MAS_BUSES ? Bus_Gain[bus] : 0;
+};
+uint8_t ESP32_MAS_Base::getChannels() {
+  return Channels;
+};
+uint32_t ESP32_MAS_Base::getUnderrun(uint8_t channel) {
+  return Stream[channel].underrun;
+};
+uint32_t ESP32_MAS_Base::getRenderTime() {
+  return Render_Time;
+};
+uint32_t ESP32_MAS_Base::getRenderMax() {
+  uint32_t render_max = Render_Max;
+  Render_Max = 0;
+  return render_max;
+};
+bool ESP32_MAS_Base::getStats(MAS_Stats *stats) {
+#if MAS_STATS
+  uint32_t gen;
+  do {
+    gen = Stats_Gen;
+    __sync_synchronize();
+    *stats = Stats;
+    __sync_synchronize();
+  } while ((gen & 1) || gen != Stats_Gen);
+  do {
+    gen = Read_Gen;
+    __sync_synchronize();
+    stats->stage[MAS_STAGE_READ] = Read_Stats;
+    __sync_synchronize();
+  } while ((gen & 1) || gen != Read_Gen);
+  return true;
+#else
+  return false;
+#endif
+};
+void ESP32_MAS_Base::resetStats() {
+#if MAS_STATS
+  Stats_Reset++;
+#endif
+};
+float ESP32_MAS_Base::getLoad() {
+  //--------------------------------------------------------render time / duration of a block
+  return Render_Time * 100.0f * 22050 / (Block_Len * 1000000.0f);
+};
+void ESP32_MAS_Base::beginBatch() {
+  Batching = true;
+};
+void ESP32_MAS_Base::sendBatch() {
+  if (Batch_Len > 0) {
+    pushBatch();
+  }
+  Batching = false;
+};
+void ESP32_MAS_Base::scheduleAt(uint32_t clock) {
+  Timed = true;
+  Time_At = clock;
+};
+void ESP32_MAS_Base::scheduleNow() {
+  Timed = false;
+};
+uint32_t ESP32_MAS_Base::getClock() {
+  return Clock;
+};
+bool ESP32_MAS_Base::getEvent(uint8_t *channel, uint8_t *state) {
+  MAS_Event event;
+  if (!Event.pop(&event)) {
+    return false;
+  }
+  *channel = event.channel;
+  *state = event.state;
+  return true;
+};
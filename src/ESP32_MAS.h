@@ -16,16 +16,24 @@
   ESP32 Model Audio System
   https://github.com/JohannesMTC/ESP32_MAS.git
   ---------------------------------------------------------------------------------------------
-  3 CANNEL AUDIO PLAYER FOR THE ESP32.
+  MULTI CANNEL AUDIO PLAYER FOR THE ESP32.
   This library allows you to play and loop sounds through a DAC or on chip DAC
   using Espressif's ESP32.
-  The sound system supports 3 channels mono which can be controlled separately
-  in the volume an pitch.
-  The sound output is realized via Core 0. Please do not start any further tasks on Core 0,
-  because this is completely exhausted with the special edition! There is no "vTaskDelay"
-  within this function. The task is accessed via pointers without exception.
-  The class controlling methods run on Core 1.
-  Thus, calls to the class variables via pointers are also directly possible.
+  The sound system supports 3 channels mono (or the number of channels set by ESP32_MAS<channels>)
+  which can be controlled separately in the volume an pitch.
+  The sound output is realized via Core 0. The task "Audio_Player" renders one block for every
+  DMA buffer the I2S driver has sent and sleeps on the event queue of the driver in between.
+  The class controlling methods run on Core 1. Every call is sent as a command through a lock free
+  queue (see MAS_Queue.h), the player takes all commands at the start of the next audio block.
+  Commands with a time of the sample clock (see scheduleAt) are taken at their sample.
+  State changes of the channels come back through a second queue, see getEvent.
+  Files which are not in the sample cache are read by the task "Audio_Reader" on Core 1
+  in blocks of MAS_STREAM_BLOCK bytes into a ring buffer of MAS_STREAM_SIZE bytes per channel.
+  The reader opens the next file of a loop or sequence before the current file ends.
+  The channels are mixed in fixed point (see MAS_Mixer.h) and the sum is limited to 16 bit.
+  The output is mono or stereo with a constant power pan per channel, the channels can be
+  grouped in submix buses with their own gain.
+  A channel can play an engine voice which blends cached recordings by rpm (see MAS_Engine.h).
 
   This library is optimized for use in model and robotic construction.
   If you are looking for optimal sound quality or want to play MP3 or WAVE files and do without
@@ -33,11 +41,14 @@
   https://github.com/earlephilhower/ESP8266Audio
   ---------------------------------------------------------------------------------------------
   The files to be played must be:
-  aiff formated,
-  PCM signed 8 bit,
-  22050 sample / sec,
   stored in the SPIFF,
   Filename max 16 char
+  Supported formats (see MAS_Decoder.h):
+  AIFF/AIFC PCM 8 or 16 bit, AIFC IMA-ADPCM (ima4),
+  WAVE PCM 8 or 16 bit, WAVE IMA-ADPCM,
+  RAW files without header: PCM signed 8 bit, 22050 sample / sec.
+  Files are played mono with 22050 sample / sec, other sample rates and stereo files
+  are converted while playing.
   ---------------------------------------------------------------------------------------------
   Use of the SPIFF:
   Currently, the data upload tool for the ESP32 still has an error.
@@ -59,8 +70,12 @@
   ---------------------------------------------------------------------------------------------
   In the head of your sketch:
 
-  "ESP32_MAS()"
+  "ESP32_MAS<channels>()"
   Initiaise a instance of the sound system.
+  channels = number of channels, 1 - 127 (ESP32_MAS<> = 3 channels)
+  Every channel needs a ring buffer of MAS_STREAM_SIZE samples (2 bytes per sample) in RAM.
+  The destructor stops the tasks of startDAC and frees the ring buffers, the player and the
+  sample cache, the sound bank stays mapped.
   ---------------------------------------------------------------------------------------------
   In the "setup" function of your sketch:
   (Methods may only be executed before the method "ESP32_MAS.startDAC()".)
@@ -84,12 +99,61 @@
   Defauld assignment of the DAC:
   I2S_noDAC = false
   Allows output via an external IS2 DAC such as the "Adafruit I2S 3W Class D Amplifier".
+
+  "ESP32_MAS.setBuffer(uint16_t block, uint8_t count)"
+  Sets the size of an audio block and the number of DMA buffers.
+  block = samples of an audio block and of a DMA buffer (32 - 1024)
+  count = number of DMA buffers (min. 2)
+  Defauld assignment:
+  block = 256, count = 4
+  The output latency is about block * count samples, commands take effect after one block.
+  After count blocks of silence with all channels stopped the player sleeps and stops
+  the output (I2S: zeroed DMA buffers). It waits on a semaphore without CPU time, the next
+  command wakes it at once.
+
+  "ESP32_MAS.setOutput(MAS_Output * output)"
+  Sends the audio blocks to another output instead of the IS2 output (see MAS_Platform.h).
+  output = MAS_Memory_Output (RAM), MAS_WAV_Output (WAVE file, host only) or an own MAS_Output
+  Defauld assignment:
+  IS2 output on the ESP32, no output on the host
+
+  "ESP32_MAS.setCache(uint32_t size)"
+  Sets the size of the sample cache, only before the first preloadFile.
+  size = bytes of the sample cache (2 bytes per sample)
+  Defauld assignment:
+  size = MAS_CACHE_SIZE (65536)
+  The 8 layers E_engine1 - E_engine8 of the example need 81822 bytes.
+
+  "ESP32_MAS.setStereo(bool stereo)"
+  Switches the output to interleaved stereo frames (left, right), see setPan.
+  The I2S output sends both channels (I2S_CHANNEL_FMT_RIGHT_LEFT), the output of setOutput
+  gets 2 samples per frame.
+  Defauld assignment:
+  stereo = false (mono, the pan is not used)
+
+  "bool ESP32_MAS.openBank(const char * name)"
+  Maps a sound bank, the sounds of the bank are played from the flash without SPIFFS.
+  name = label of the data partition of the bank (file in the directory of MAS_Set_Root on the host)
+  Return: false if there is no valid bank.
+  The bank is built by the host tool extras/MAS_Pack, see MAS_Bank.h.
+  playFile, loopFile, queueFile, playAny, loopAny and addLayer look up a file name in the bank
+  first. A loop of the bank repeats from its loop start to its loop end.
   ---------------------------------------------------------------------------------------------
   Method may only be executed once.
   (Subsequent changes to the port, pin or DAC functions are no longer taken into account.)
 
   "ESP32_MAS.startDAC()"
   Starts the IS2 output with the predefined or defauld configuration.
+
+  "uint32_t ESP32_MAS.renderOffline(float seconds)"
+  Renders the sound system as fast as possible to the output of setOutput, without the tasks.
+  seconds = time to render, rounded up to whole blocks
+  Return: frames rendered (samples per channel), 0 if startDAC was called or there is no output.
+  Before every block the reader fills all buffers, so the output is the same in every run.
+  Commands are taken at the next call, at most MAS_COMMAND_SIZE commands between two calls.
+  Without ARDUINO the library builds for the host, see MAS_Platform.h.
+  The host tool extras/MAS_Bench measures the render time of scenes with renderOffline,
+  the host tests are in extras/MAS_Test (run_tests.sh).
   ---------------------------------------------------------------------------------------------
   In any function:
   (Methods can be called any number of times.)
@@ -100,39 +164,204 @@
   Defauld assignment:
   Volume = 255
 
+  "ESP32_MAS.rampVolume(uint8_t volume, uint16_t ms)"
+  Moves the master volume linearly to volume within ms milliseconds, 0 = at once.
+
+  "bool ESP32_MAS.preloadFile(String filname)"
+  Decodes a file once into the sample cache in RAM (PSRAM if available).
+  filename = full path of the file to be cached
+  Return: true if the file is in the cache or in the sound bank (nothing is copied).
+  playFile and loopFile play cached files directly from RAM without SPIFFS access,
+  so loops are repeated without reopening the file.
+  The cache holds MAS_CACHE_SIZE bytes (2 bytes per sample) in MAS_CACHE_SLOTS files. If it is full,
+  the least recently used file that is not played by any channel is removed.
+
   "ESP32_MAS.playFile(uint8_t channel, String filname)"
   Send a new file to the sound system for playback.
-  channel = channel to play the file. (0 - 2)
+  channel = channel to play the file. (0 - channels-1)
   filename = full path of the file to be played
   The output starts immediately (delay approx. 2 ms) and stops at the end of the file.
   If the channel is running a file, this file will be attached to the active file.
+  Files queued by queueFile are replaced.
 
   "ESP32_MAS.loopFile(uint8_t channel, String filname)"
   Loads a file into the loop buffer and repeats it continuously.
-  channel = channel to play the file. (0 - 2)
+  channel = channel to play the file. (0 - channels-1)
   filename = full path of the file to be played
   If the channel is running a file, this file will be attached to the active file.
+  Files queued by queueFile are replaced.
+
+  "ESP32_MAS.queueFile(uint8_t channel, String filname, bool loop)"
+  Attaches a file to the files queued on the channel, for example in - loop - out sequences.
+  channel = channel to play the file. (0 - channels-1)
+  filename = full path of the file to be played
+  loop = true repeats the file until the next file is queued
+  A running loop ends at the end of the file, the next file follows without a gap.
+  The channel queues MAS_SEGMENTS files, if the queue is full the last file is replaced.
+  Loops shorter than an audio block should be preloaded, streamed they get gaps.
+
+  "ESP32_MAS.setCrossfade(uint8_t channel, uint16_t samples)"
+  Fades the end of a file into the next queued file instead of joining them.
+  channel = channel whose crossfade is to be changed. (0 - channels-1)
+  samples = length of the equal power crossfade, 0 = none
+  Defauld assignment:
+  samples = 0
+
+  "int8_t ESP32_MAS.playAny(String filname, uint8_t priority)"
+  "int8_t ESP32_MAS.loopAny(String filname, uint8_t priority)"
+  Plays or loops a file on the first stopped channel.
+  If no channel is stopped, the oldest channel with the lowest priority is taken if its
+  priority is not higher than "priority". The file on the taken channel is dropped at once.
+  filename = full path of the file to be played
+  priority = 0-255, 255 = highest
+  Return: channel of the file, -1 = no channel free.
+
+  "MAS_Sound_Id ESP32_MAS.addSound(const char * filename)"
+  "ESP32_MAS.setSounds(const char * const * filenames, uint16_t count)"
+  Registers sounds once so they can be played by id without String.
+  filename = full path of the file, the text is not copied and must stay valid (a literal)
+  filenames = table of count file names, for example a constexpr table, id = index
+  Return: id of the sound, -1 = MAS_SOUNDS sounds are registered.
+  setSounds replaces all sounds of addSound.
+
+  "MAS_Voice_Handle ESP32_MAS.playSound(uint8_t channel, MAS_Sound_Id sound)"
+  "MAS_Voice_Handle ESP32_MAS.loopSound(uint8_t channel, MAS_Sound_Id sound)"
+  "MAS_Voice_Handle ESP32_MAS.queueSound(uint8_t channel, MAS_Sound_Id sound, bool loop)"
+  "MAS_Voice_Handle ESP32_MAS.playAny(MAS_Sound_Id sound, uint8_t priority)"
+  "MAS_Voice_Handle ESP32_MAS.loopAny(MAS_Sound_Id sound, uint8_t priority)"
+  Like playFile, loopFile, queueFile, playAny and loopAny with the id of a registered sound.
+  These methods and the methods of the handle do not allocate memory.
+  Return: handle of the voice, channel = -1 if the id is unknown, no channel is free or the
+  command was lost (the command queue is full and the player does not run).
+  The voice ends with the end of the file or the next file command on the channel.
+
+  "bool ESP32_MAS.stopVoice(MAS_Voice_Handle voice)"
+  Stops the channel of the voice like stopChan if the voice still plays.
+  Return: false if the voice has ended, another file is not stopped.
+
+  "ESP32_MAS.setPriority(uint8_t channel, uint8_t priority)"
+  Sets the priority of the channel for playAny and loopAny.
+  channel = channel whose priority is to be changed. (0 - channels-1)
+  priority = 0-255, 255 = highest
 
   "ESP32_MAS.outChan(uint8_t channel)"
   Lets the looped channel run to end of file and stoped file output.
-  channel = loop channel that should leak. (0 - 2)
+  channel = loop channel that should leak. (0 - channels-1)
 
   "ESP32_MAS.setGain(uint8_t channel, uint8_t gain)"
   Sets the volume of the respective channel.
-  channel = channel whose volume is to be changed. (0 - 2)
-  gain = desired volume (0 = mute, 255 = 1dB)
+  channel = channel whose volume is to be changed. (0 - channels-1)
+  gain = desired volume (0 = mute, 255 = 0dB)
 
   "ESP32_MAS.setPitch(uint8_t channel, float pitch)"
-  channel = channel whose playback speed is to be changed. (0 - 2)
-  pitch = desired acceleration of the channel. (0 = 0, 1 = doubble speed)
+  channel = channel whose playback speed is to be changed. (0 - channels-1)
+  pitch = desired acceleration of the channel. (-0.75 = quarter speed, 0 = 0, 1 = doubble speed,
+  3 = 4 times speed)
+
+  "ESP32_MAS.rampGain(uint8_t channel, uint8_t gain, uint16_t ms)"
+  "ESP32_MAS.rampPitch(uint8_t channel, float pitch, uint16_t ms)"
+  Moves the gain or the pitch of the channel linearly to the new value within ms milliseconds,
+  0 = at once like setGain and setPitch. A new ramp starts from the current value.
+  The player computes the ramps once per audio block: the gain moves sample by sample,
+  the pitch changes once per block. The target is reached at the end of the block in which
+  the ramp ends (see MAS_Ramp.h).
+
+  "ESP32_MAS.setEnvelope(uint8_t channel, uint16_t attack, uint16_t decay, uint8_t sustain,
+                         uint16_t release)"
+  Sets the envelope of the channel, it starts with every file that starts the stopped channel,
+  with playAny, loopAny and startEngine.
+  attack = ms from 0 to 0dB, decay = ms from 0dB to sustain, release = ms from sustain to 0
+  sustain = level while the file plays (0 = mute, 255 = 0dB)
+  Defauld assignment:
+  attack = 0, decay = 0, sustain = 255, release = 0 (no envelope)
+
+  "ESP32_MAS.releaseChan(uint8_t channel)"
+  Starts the release of the envelope and stops the channel at its end.
+  channel = channel to be released. (0 - channels-1)
+
+  "ESP32_MAS.setPan(uint8_t channel, int8_t pan)"
+  Sets the position of the channel in the stereo output, the pan moves over one block.
+  pan = -127 = left, 0 = center (-3dB on both sides), 127 = right
+  Defauld assignment:
+  pan = 0
+
+  "ESP32_MAS.setBus(uint8_t channel, uint8_t bus)"
+  Routes the channel to a submix bus.
+  bus = 0 - MAS_BUSES-1
+  Defauld assignment:
+  bus = 0
+
+  "ESP32_MAS.setBusGain(uint8_t bus, uint8_t gain)"
+  "ESP32_MAS.rampBusGain(uint8_t bus, uint8_t gain, uint16_t ms)"
+  Sets the gain of a bus at once or moves it linearly within ms milliseconds.
+  gain = 0 = mute, 255 = 0dB
+  The channels of a bus are summed and the sum is multiplied by the gain of the bus,
+  a bus at 0dB adds its channels to the output directly.
+  Defauld assignment:
+  gain = 255
+
+  "ESP32_MAS.setFilter(uint8_t channel, uint8_t slot, uint8_t type, uint16_t freq, float q,
+                      float gain)"
+  "ESP32_MAS.setBusFilter(uint8_t bus, uint8_t slot, uint8_t type, uint16_t freq, float q,
+                         float gain)"
+  "ESP32_MAS.setMasterFilter(uint8_t slot, uint8_t type, uint16_t freq, float q, float gain)"
+  Sets a biquad filter of a channel, of a bus or of the master output (see MAS_Filter.h).
+  slot = filter of the chain (0 - MAS_FILTERS-1), the filters run in the order of the slots
+  type = MAS_FILTER_OFF, MAS_FILTER_LOWPASS, MAS_FILTER_HIGHPASS, MAS_FILTER_PEAK,
+         MAS_FILTER_LOWSHELF, MAS_FILTER_HIGHSHELF
+  freq = Hz, corner of the pass filters and the shelves, center of the peak
+  q = 0.7071 = Butterworth pass filters and flat shelves, higher = sharper
+  gain = dB of the peak and the shelves (-24 - 24)
+  The coefficients are computed when the filter is set, a bus with filters is not added
+  to the output directly.
+  Defauld assignment:
+  type = MAS_FILTER_OFF
+
+  "ESP32_MAS.setLimiter(uint8_t threshold, uint16_t release)"
+  Turns on the look-ahead peak limiter of the master output, it delays the output by
+  2 * MAS_LIMIT_STEP samples. No peak gets louder than the threshold, the gain moves back
+  to 0dB within the release time.
+  threshold = 0 = off, 255 = full scale
+  release = ms from the lowest gain back to 0dB
+  Defauld assignment:
+  threshold = 0
+
+  "ESP32_MAS.setInterpolation(uint8_t mode)"
+  Sets the interpolation of all channels when they are played with pitch or another sample rate.
+  mode = 0 = NONE (cheapest), 1 = LINEAR, 2 = CUBIC (float math),
+         3 = BOX (damps the aliasing at high pitch, LINEAR up to normal speed), see MAS_Resampler.h
+  Defauld assignment:
+  mode = 1
 
   "ESP32_MAS.stopChan(uint8_t channel)"
   Stops the output of the channel immediately.
-  channel = channel to be stopped. (0 - 2)
+  channel = channel to be stopped. (0 - channels-1)
+
+  "bool ESP32_MAS.addLayer(uint8_t channel, String filname, uint16_t rpm)"
+  Loads a recording of an engine into the sample cache and adds it to the engine voice.
+  channel = channel of the engine voice. (0 - channels-1)
+  filename = full path of the loop recorded at rpm
+  rpm = rpm of the recording, any unit of the throttle
+  Return: false if the file is not in the cache or the channel has MAS_ENGINE_LAYERS layers.
+
+  "ESP32_MAS.clearLayers(uint8_t channel)"
+  Removes all layers of the engine voice of the channel.
+  channel = channel of the engine voice. (0 - channels-1)
+
+  "ESP32_MAS.startEngine(uint8_t channel)"
+  Drops the files of the channel and plays its engine voice until stopChan, outChan or playFile.
+  channel = channel of the engine voice. (0 - channels-1)
+  Only the two layers next to the rpm are mixed, see MAS_Engine.h.
+  setPitch and setGain work on the whole engine voice, outChan fades it out within one block.
+
+  "ESP32_MAS.setRPM(uint8_t channel, uint16_t rpm)"
+  Sets the rpm of the engine voice of the channel.
+  channel = channel of the engine voice. (0 - channels-1)
+  rpm = rpm in the unit of addLayer, the change is ramped over one audio block
 
   "String ESP32_MAS.getChan(uint8_t channel)"
   Queries the state of the respective channel.
-  channel = channel whose state is to be queried. (0 - 2)
+  channel = channel whose state is to be queried. (0 - channels-1)
   Return:
   PLAY = File ready to play and goto out.
   LOOP File ready to loop and goto run.
@@ -141,57 +370,479 @@
   STOP = No output on this channel.
   BRAKE = Channel stoped file uotput and wait for run or out.
 
+  "MAS_State ESP32_MAS.getState(uint8_t channel)"
+  Queries the state of the respective channel without String.
+  Return:
+  MAS_STOP, MAS_BRAKE, MAS_PLAY, MAS_LOOP, MAS_RUN or MAS_OUT, see getChan.
+
+  "MAS_State ESP32_MAS.getVoice(MAS_Voice_Handle voice)"
+  Return:
+  State of the voice, MAS_STOP if it has ended.
+
+  "ESP32_MAS.getStates(MAS_Channel_Info * info)"
+  Copies state, gain, priority, rpm, pan, bus, pitch, underruns and played blocks of all
+  channels in one call.
+  info = array of getChannels() MAS_Channel_Info
+
   "uint8_t ESP32_MAS.getGain(uint8_t channel)"
-  channel = channel whose state is to be queried. (0 - 2)
+  channel = channel whose state is to be queried. (0 - channels-1)
   Return:
   Gain of the queried channel.
 
   "float ESP32_MAS.getPitch(uint8_t channel)"
-  channel = channel whose state is to be queried. (0 - 2)
+  channel = channel whose state is to be queried. (0 - channels-1)
   Return:
   Pitch of the queried channel.
+
+  "uint8_t ESP32_MAS.getPriority(uint8_t channel)"
+  channel = channel whose state is to be queried. (0 - channels-1)
+  Return:
+  Priority of the queried channel.
+
+  "uint16_t ESP32_MAS.getCrossfade(uint8_t channel)"
+  channel = channel whose state is to be queried. (0 - channels-1)
+  Return:
+  Crossfade of the queried channel in samples.
+
+  "uint16_t ESP32_MAS.getRPM(uint8_t channel)"
+  channel = channel whose state is to be queried. (0 - channels-1)
+  Return:
+  rpm of the engine voice of the queried channel.
+
+  "int8_t ESP32_MAS.getPan(uint8_t channel)"
+  "uint8_t ESP32_MAS.getBus(uint8_t channel)"
+  channel = channel whose state is to be queried. (0 - channels-1)
+  Return:
+  Pan or submix bus of the queried channel.
+
+  "uint8_t ESP32_MAS.getBusGain(uint8_t bus)"
+  Return:
+  Gain of the bus.
+
+  "uint8_t ESP32_MAS.getChannels()"
+  Return:
+  Number of channels of the sound system.
+
+  "uint32_t ESP32_MAS.getRenderTime()"
+  Return:
+  Average render time of an audio block in us.
+
+  "uint32_t ESP32_MAS.getRenderMax()"
+  Return:
+  Longest render time of an audio block in us since the last call.
+
+  "float ESP32_MAS.getLoad()"
+  Return:
+  Average render time / duration of a block in percent.
+
+  "bool ESP32_MAS.getStats(MAS_Stats * stats)"
+  Copies the statistics of the player and the reader task, it does not stop them.
+  stats = cycles of the stages of a block (min, max, total / count), the render time of a
+          block, the load histogram and the late, underrun and dropped blocks, see MAS_Stats.
+          skipped = channel blocks not mixed (silent or gain 0), idle = times the player slept.
+          unscheduled = timed commands taken at once because the schedule was full.
+          Cycles are CPU cycles on the ESP32 and ns on the host, cycle_rate per second.
+  Stages: MAS_STAGE_READ (reader pass: read and decode files), MAS_STAGE_VOICE (resampler,
+          engine voices), MAS_STAGE_MIX, MAS_STAGE_DSP (filters, limiter), MAS_STAGE_OUT (I2S write)
+  Return:
+  false if the statistics are not compiled (#define MAS_STATS 0).
+
+  "ESP32_MAS.resetStats()"
+  Starts new statistics with the next block and the next reader pass.
+
+  "bool ESP32_MAS.getEvent(uint8_t * channel, uint8_t * state)"
+  Reads the next state change of a channel reported by the player.
+  channel = channel whose state changed
+  state = new state, 0 = STOP, 1 = BRAKE, 2 = PLAY, 3 = LOOP, 4 = RUN, 5 = OUT
+  Return:
+  false if there is no event. The queue holds MAS_EVENT_SIZE events, newer events are lost
+  if it is full. getChan always returns the current state.
+
+  "ESP32_MAS.beginBatch()"
+  Collects the following commands until sendBatch. The player takes the whole batch in the
+  same block. A batch of more than MAS_BATCH commands is sent in parts.
+
+  "ESP32_MAS.sendBatch()"
+  Sends the commands of beginBatch in one push to the queue.
+
+  "ESP32_MAS.scheduleAt(uint32_t clock)"
+  The following commands take effect at the sample of the clock until scheduleNow.
+  clock = sample of getClock, a clock of the past takes effect at once
+  The player holds MAS_SCHEDULE commands for later blocks, a full schedule takes commands at
+  once and counts them in unscheduled of getStats.
+  Files of the sample cache and the sound bank start at the exact sample, files of the SPIFFS
+  start when the reader has opened them.
+
+  "ESP32_MAS.scheduleNow()"
+  The following commands take effect at the next block again.
+
+  "uint32_t ESP32_MAS.getClock()"
+  Return:
+  Samples rendered by the player, 22050 per second. The clock wraps after 54 hours and stops
+  while the player sleeps. Example: scheduleAt(getClock() + 5513) = in 250 ms
+
+  "uint32_t ESP32_MAS.getUnderrun(uint8_t channel)"
+  channel = channel whose state is to be queried. (0 - channels-1)
+  Return:
+  Number of audio blocks in which the reader task did not deliver the data in time.
   -------------------------------------------------------------------------------------------*/
 #ifndef _ESP32_MAS_
 #define _ESP32_MAS_
-#include <Arduino.h>
-#include <FS.h>
-#include "driver/i2s.h"
-#include "esp_task.h"
+#include "MAS_Platform.h"
 #include "ESP32_MAS.h"
+#include "MAS_Bank.h"
+#include "MAS_Decoder.h"
+#include "MAS_Queue.h"
 
-class ESP32_MAS {
+#ifndef MAS_CACHE_SIZE
+#define MAS_CACHE_SIZE 65536 // bytes of the sample cache
+#endif
+#ifndef MAS_CACHE_SLOTS
+#define MAS_CACHE_SLOTS 16 // max. files in the sample cache
+#endif
+#ifndef MAS_STREAM_SIZE
+#define MAS_STREAM_SIZE 4096 // samples of the ring buffer of a channel, power of 2
+#endif
+#ifndef MAS_STREAM_BLOCK
+#define MAS_STREAM_BLOCK 1024 // bytes per SPIFFS read of the reader task
+#endif
+#define MAS_STREAM_PCM (MAS_STREAM_BLOCK * 2 + 2) // samples of a decoded read, IMA = 2 per byte
+#ifndef MAS_SEGMENTS
+#define MAS_SEGMENTS 4 // files queued per channel
+#endif
+#ifndef MAS_SOUNDS
+#define MAS_SOUNDS 64 // sounds of addSound and setSounds
+#endif
+#ifndef MAS_BUSES
+#define MAS_BUSES 4 // submix buses
+#endif
+#ifndef MAS_SCHEDULE
+#define MAS_SCHEDULE 32 // timed commands the player holds for later blocks
+#endif
+#ifndef MAS_BATCH
+#define MAS_BATCH 16 // commands of a batch, at most MAS_COMMAND_SIZE
+#endif
+#ifndef MAS_STATS
+#define MAS_STATS 1 // 0 = the statistics of getStats are not compiled
+#endif
+
+//-----------------------------------------------------------------------------render stages
+#define MAS_STAGE_READ 0 // reader task: read and decode files to the ring buffers, per pass
+#define MAS_STAGE_VOICE 1 // player: commands, resampler, engine voices and crossfades
+#define MAS_STAGE_MIX 2 // player: gains, envelopes, pan, buses and the output samples
+#define MAS_STAGE_DSP 3 // player: filters and limiter
+#define MAS_STAGE_OUT 4 // player: write of the block to the output (I2S DMA)
+#define MAS_STAGES 5
+#define MAS_LOAD_STEPS 11 // render time in 10% of a block, the last step = longer than a block
+
+//----------------------------------------------------------------------------state of a channel
+enum MAS_State : uint8_t {
+  MAS_STOP = 0, MAS_BRAKE = 1, MAS_PLAY = 2, MAS_LOOP = 3, MAS_RUN = 4, MAS_OUT = 5
+};
+
+typedef int16_t MAS_Sound_Id; // index of the name of addSound or setSounds, -1 = no sound
+
+//-------------------------------------------------------------------------------voice handle
+// A file command on a channel. The voice ends with the next file command on the channel.
+struct MAS_Voice_Handle {
+  int8_t channel = -1; // -1 = no voice
+  MAS_State state = MAS_STOP; // MAS_PLAY or MAS_LOOP as sent
+  uint32_t command = 0; // Chan_Cmd of the file command
+};
+
+//------------------------------------------------------------------------snapshot of a channel
+struct MAS_Channel_Info {
+  MAS_State state;
+  uint8_t gain;
+  uint8_t priority;
+  uint16_t rpm;
+  int8_t pan;
+  uint8_t bus;
+  float pitch;
+  uint32_t underrun;
+  uint32_t active; // blocks the channel played
+};
+
+//--------------------------------------------------------------------------------statistics
+// Cycles of MAS_Cycles: CPU cycles on the ESP32, ns on the host.
+struct MAS_Time_Stats {
+  uint32_t count = 0; // measured blocks or reader passes
+  uint32_t min = 0xFFFFFFFF;
+  uint32_t max = 0;
+  uint64_t total = 0; // total / count = average
+};
+
+struct MAS_Stats {
+  uint32_t cycle_rate = 0; // cycles per second
+  uint32_t block_cycles = 0; // cycles of the duration of a block
+  MAS_Time_Stats stage[MAS_STAGES]; // MAS_STAGE_...
+  MAS_Time_Stats render; // voice, mix and dsp of a block
+  uint32_t load[MAS_LOAD_STEPS] = {}; // blocks by render time, load[i] = i * 10% of a block
+  uint32_t late = 0; // blocks rendered after the output had sent the block before
+  uint32_t underrun = 0; // late blocks after the output had sent all DMA buffers
+  uint32_t dropped = 0; // blocks the output did not take in full
+  uint32_t skipped = 0; // channel blocks not mixed: silent, stopped or at gain 0
+  uint32_t idle = 0; // times the player slept without a playing channel
+  uint32_t unscheduled = 0; // timed commands taken at once, the schedule was full
+};
+
+//---------------------------------------------------------------------------stream of a channel
+// Single producer (Audio_Reader) single consumer (Audio_Player) ring buffer.
+// head and tail count samples since start and only grow, the ring index is count & (SIZE - 1).
+struct MAS_Stream {
+  int16_t *buf = NULL; // MAS_STREAM_SIZE decoded samples, allocated by startDAC
+  volatile uint32_t head = 0; // samples written, reader only
+  volatile uint32_t tail = 0; // oldest sample the player still reads, player only
+  volatile uint32_t file_start = 0; // first sample of the file after an open request
+  volatile uint32_t file_end = 0; // end of the file played by the player
+  volatile uint32_t next_start = 0; // start of the file read ahead by the reader
+  volatile uint32_t next_end = 0; // end of the file read ahead by the reader
+  volatile uint32_t next_gen = 0; // file_gen of the file read ahead
+  volatile uint32_t file_rate = 22050; // sample rate of the file after an open request
+  volatile uint32_t next_rate = 22050; // sample rate of the file read ahead
+  volatile uint32_t file_gen = 0; // counts file changes, odd while the player writes file_name
+  volatile uint32_t open_req = 0; // player requests a new file
+  volatile uint32_t open_ack = 0; // reader opened the requested file
+  volatile uint32_t underrun = 0; // blocks with missing data
+  volatile uint32_t active = 0; // blocks the player played the channel
+  volatile uint32_t at_req = 0; // timed file commands sent by the class
+  volatile uint32_t at_ack = 0; // timed file commands started by the player
+  volatile bool next_ready = false; // the reader reads the next file ahead
+  volatile bool stream = false; // channel reads from SPIFFS
+  volatile bool in_use = false; // the player reads the ring buffer from tail
+  volatile bool next_stream = false; // the next file is read from SPIFFS
+  char file_name[MAS_NAME_SIZE] = {}; // next file of the channel, player only writes
+  char open_name[MAS_NAME_SIZE] = {}; // file of open_req, player only writes
+  MAS_File file; // reader only
+  MAS_Format format; // reader only
+  uint32_t remain = 0; // bytes of the file to read, reader only
+};
+
+struct MAS_Player;
+
+//-------------------------------------------------------------------------------sound system
+// All methods of the sound system. The channel arrays are stored in ESP32_MAS<channels>.
+class ESP32_MAS_Base {
   public:
-    ESP32_MAS();
     void setPort(uint8_t port);
     void setOut(uint8_t bck, uint8_t ws, uint8_t data);
     void setDAC(bool dac);
+    void setBuffer(uint16_t block, uint8_t count);
+    void setOutput(MAS_Output *output);
+    void setCache(uint32_t size);
+    void setStereo(bool stereo);
+    bool openBank(const char *name);
     void startDAC();
+    uint32_t renderOffline(float seconds);
     void setVolume(uint8_t volume);
+    void rampVolume(uint8_t volume, uint16_t ms);
+    bool preloadFile(String audio_file);
     void stopChan(uint8_t channel);
     void playFile(uint8_t channel, String audio_file);
     void loopFile(uint8_t channel, String audio_file);
+    void queueFile(uint8_t channel, String audio_file, bool loop);
+    int8_t playAny(String audio_file, uint8_t priority);
+    int8_t loopAny(String audio_file, uint8_t priority);
+    MAS_Sound_Id addSound(const char *audio_file);
+    void setSounds(const char *const *audio_files, uint16_t count);
+    MAS_Voice_Handle playSound(uint8_t channel, MAS_Sound_Id sound);
+    MAS_Voice_Handle loopSound(uint8_t channel, MAS_Sound_Id sound);
+    MAS_Voice_Handle queueSound(uint8_t channel, MAS_Sound_Id sound, bool loop);
+    MAS_Voice_Handle playAny(MAS_Sound_Id sound, uint8_t priority);
+    MAS_Voice_Handle loopAny(MAS_Sound_Id sound, uint8_t priority);
+    bool stopVoice(MAS_Voice_Handle voice);
     void runChan(uint8_t channel);
     void brakeChan(uint8_t channel);
     void outChan(uint8_t channel);
     void setGain(uint8_t channel, uint8_t gain);
     void setPitch(uint8_t channel, float pitch);
+    void rampGain(uint8_t channel, uint8_t gain, uint16_t ms);
+    void rampPitch(uint8_t channel, float pitch, uint16_t ms);
+    void setEnvelope(uint8_t channel, uint16_t attack, uint16_t decay, uint8_t sustain,
+                     uint16_t release);
+    void releaseChan(uint8_t channel);
+    void setPan(uint8_t channel, int8_t pan);
+    void setBus(uint8_t channel, uint8_t bus);
+    void setBusGain(uint8_t bus, uint8_t gain);
+    void rampBusGain(uint8_t bus, uint8_t gain, uint16_t ms);
+    void setFilter(uint8_t channel, uint8_t slot, uint8_t type, uint16_t freq, float q,
+                   float gain);
+    void setBusFilter(uint8_t bus, uint8_t slot, uint8_t type, uint16_t freq, float q,
+                      float gain);
+    void setMasterFilter(uint8_t slot, uint8_t type, uint16_t freq, float q, float gain);
+    void setLimiter(uint8_t threshold, uint16_t release);
+    void setInterpolation(uint8_t mode);
+    void setPriority(uint8_t channel, uint8_t priority);
+    void setCrossfade(uint8_t channel, uint16_t samples);
+    bool addLayer(uint8_t channel, String audio_file, uint16_t rpm);
+    void clearLayers(uint8_t channel);
+    void startEngine(uint8_t channel);
+    void setRPM(uint8_t channel, uint16_t rpm);
     String getChan(uint8_t channel);
+    MAS_State getState(uint8_t channel);
+    MAS_State getVoice(MAS_Voice_Handle voice);
+    void getStates(MAS_Channel_Info *info);
     uint8_t getGain(uint8_t channel);
     float getPitch(uint8_t channel);
+    uint8_t getPriority(uint8_t channel);
+    uint16_t getCrossfade(uint8_t channel);
+    uint16_t getRPM(uint8_t channel);
+    int8_t getPan(uint8_t channel);
+    uint8_t getBus(uint8_t channel);
+    uint8_t getBusGain(uint8_t bus);
+    uint8_t getChannels();
+    uint32_t getUnderrun(uint8_t channel);
+    bool getEvent(uint8_t *channel, uint8_t *state);
+    void beginBatch();
+    void sendBatch();
+    void scheduleAt(uint32_t clock);
+    void scheduleNow();
+    uint32_t getClock();
+    uint32_t getRenderTime();
+    uint32_t getRenderMax();
+    float getLoad();
+    bool getStats(MAS_Stats *stats);
+    void resetStats();
+    virtual ~ESP32_MAS_Base();
+    friend void Audio_Player(void *ptr);
+    friend void Audio_Reader(void *ptr);
+    friend bool Reader_Step(ESP32_MAS_Base *mas);
+    friend MAS_Player *Player_Begin(ESP32_MAS_Base *mas);
+    friend void Player_End(ESP32_MAS_Base *mas, MAS_Player *player);
+    friend void Player_Command(ESP32_MAS_Base *mas, MAS_Player *player,
+                               const MAS_Command &command);
+    friend void Player_Start(ESP32_MAS_Base *mas, MAS_Player *player);
+    friend void Schedule(ESP32_MAS_Base *mas, MAS_Player *player, const MAS_Command &command);
+    friend void Player_Commands(ESP32_MAS_Base *mas, MAS_Player *player);
+    friend int Player_Due(ESP32_MAS_Base *mas, MAS_Player *player, int pos);
+    friend void Player_Render(ESP32_MAS_Base *mas, MAS_Player *player, int from, int buf_len_16);
+    friend void Player_Block(ESP32_MAS_Base *mas, MAS_Player *player);
+    friend void Player_Output(ESP32_MAS_Base *mas, MAS_Player *player, uint8_t behind);
+    friend bool Next_File(ESP32_MAS_Base *mas, MAS_Player *player, uint8_t h, bool restart);
+#if MAS_STATS
+    friend void Stats_Read(ESP32_MAS_Base *mas, uint32_t cycles);
+    friend void Stats_Block(ESP32_MAS_Base *mas, MAS_Player *player, uint8_t behind, bool done);
+#endif
+  protected:
+    ESP32_MAS_Base(uint8_t channels, uint8_t *channel, uint8_t *gain, float *pitch,
+                   uint8_t *priority, uint32_t *voice_age, uint32_t *chan_cmd,
+                   int8_t *cache_slot, uint16_t *crossfade, uint16_t *rpm, uint8_t *layers,
+                   int8_t *pan, uint8_t *bus, MAS_Stream *stream);
+    void initChannels();
+    void endChannels();
   private:
-    void *ptr_array[18];
-    String Audio_File[3] = {"/xxxxxxxxxxxxxxxx.aiff",
-                            "/xxxxxxxxxxxxxxxx.aiff",
-                            "/xxxxxxxxxxxxxxxx.aiff"
-                           };
-    uint8_t I2S_PORT = 0; // PORT NUM
-    uint8_t I2S_BCK = 26; // BCK
-    uint8_t I2S_WS = 25; // WS
-    uint8_t I2S_DATA = 22; // DATA
-    bool I2S_noDAC = false; // noDAC
+    int8_t findSound(const char *audio_file, MAS_Sound *sound);
+    int findCache(const char *audio_file);
+    int findGap(uint32_t len);
+    int8_t findVoice(uint8_t priority);
+    MAS_Voice_Handle sendFile(uint8_t type, uint8_t channel, const char *audio_file, bool restart,
+                              bool queue);
+    MAS_Voice_Handle sendAny(uint8_t type, const char *audio_file, uint8_t priority);
+    void sendFilter(uint8_t type, uint8_t channel, uint8_t bus, uint8_t slot, uint8_t filter,
+                    uint16_t freq, float q, float gain);
+    bool sendCommand(MAS_Command *command);
+    bool pushBatch();
+    void wakePlayer();
+    void initStreams();
+    const uint8_t Channels; // number of channels
+#ifdef ARDUINO
+    MAS_I2S_Output I2S_Output; // port, pins and DAC of setPort, setOut and setDAC
+#endif
+    MAS_Output *Output = NULL; // I2S_Output or the output of setOutput
+    MAS_Player *Player = NULL; // state of the player of renderOffline
+    uint16_t Block_Len = 256; // samples of an audio block and a DMA buffer
+    uint8_t Block_Count = 4; // DMA buffers
+    uint8_t Out_Channels = 1; // 1 = mono, 2 = stereo
+    volatile uint32_t Render_Time = 0; // average render time of a block in us, player only
+    volatile uint32_t Render_Max = 0; // longest render time in us since getRenderMax
+#if MAS_STATS
+    //------------------------------------------------------------------------------statistics
+    // Every writer changes its statistics in place, the generation is odd while it writes.
+    MAS_Stats Stats; // written by the player
+    volatile uint32_t Stats_Gen = 0;
+    MAS_Time_Stats Read_Stats; // written by the reader
+    volatile uint32_t Read_Gen = 0;
+    volatile uint32_t Stats_Reset = 0; // counts resetStats
+    uint32_t Stats_Done = 0; // Stats_Reset the player has done
+    uint32_t Read_Done = 0; // Stats_Reset the reader has done
+#endif
+    bool Started = false; // startDAC was called
+    volatile bool Stopping = false; // the tasks end, see endChannels
+    volatile bool Sleeping = false; // the player sleeps until Wake, see wakePlayer
+    MAS_Signal Wake; // given by the class when a command for the sleeping player is queued
+    volatile uint8_t Tasks = 0; // running tasks of startDAC
     uint8_t Volume = 255; // 0-255, 0 = mute, 255 = 0dB
-    uint8_t Channel[3] = {0, 0, 0}; // 0 = STOP, 1 = BRAKE, 2 = PLAY, 3 = LOOP, 4 = RUN, 5 = OUT
-    uint8_t Gain[3] = {128, 128, 128}; // 0-255, 0 = mute, 255 = 0dB
-    float Pitch[3] = {0, 0, 0}; // 0 - 1, 0 = normal speed, 1 = double speed
+    uint8_t Bus_Gain[MAS_BUSES]; // 0-255, 0 = mute, 255 = 0dB
+    uint8_t Interpolation = 1; // 0 = NONE, 1 = LINEAR, 2 = CUBIC
+    MAS_Command_Queue Command; // class to player
+    MAS_Event_Queue Event; // player to class
+    //-----------------------------------------------------------------------batch and schedule
+    MAS_Command Batch[MAS_BATCH]; // commands of beginBatch, pushed by sendBatch
+    uint8_t Batch_Len = 0;
+    bool Batching = false; // beginBatch was called
+    bool Timed = false; // the commands carry Time_At, see scheduleAt
+    uint32_t Time_At = 0; // sample clock of the timed commands
+    volatile uint32_t Clock = 0; // samples rendered by the player, player only
+    //-----------------------------------------------------------one element for every channel
+    // Channel is written by the player, the others by the class methods.
+    volatile uint8_t *Channel; // 0 = STOP, 1 = BRAKE, 2 = PLAY, 3 = LOOP, 4 = RUN, 5 = OUT
+    uint8_t *Gain; // 0-255, 0 = mute, 255 = 0dB
+    float *Pitch; // -0.75 - 3, 0 = normal speed, 1 = double speed
+    uint8_t *Priority; // 0-255, channels with lower priority are taken by playAny and loopAny
+    uint32_t *Voice_Age; // start of the channel by playAny or loopAny
+    uint32_t *Chan_Cmd; // Command.pushed() after the last file command
+    int8_t *Cache_Slot; // cache slot of the last file command, -1 = SPIFFS
+    uint16_t *Crossfade; // samples of a crossfade to a queued file, 0 = none
+    uint16_t *RPM; // rpm of the engine voice
+    uint8_t *Layers; // layers of the engine voice sent by addLayer
+    int8_t *Pan; // -127 = left, 0 = center, 127 = right
+    uint8_t *Bus; // submix bus of the channel
+    MAS_Stream *Stream;
+    uint8_t *Read_Buf = NULL; // MAS_STREAM_BLOCK bytes of a file read, reader only
+    int16_t *Read_PCM = NULL; // MAS_STREAM_PCM samples decoded from Read_Buf, reader only
+    //----------------------------------------------------------------------------sample cache
+    uint32_t Voice_Tick = 0;
+    uint32_t Cache_Size = MAS_CACHE_SIZE; // bytes of the slab
+    int16_t *Cache_Slab = NULL; // RAM of the sample cache
+    int16_t *Cache_Ptr[MAS_CACHE_SLOTS] = {}; // decoded samples, NULL = free slot
+    uint32_t Cache_Len[MAS_CACHE_SLOTS] = {}; // samples
+    uint32_t Cache_Rate[MAS_CACHE_SLOTS] = {}; // sample / sec
+    uint32_t Cache_Age[MAS_CACHE_SLOTS] = {}; // last use of the slot
+    volatile uint16_t Cache_Use[MAS_CACHE_SLOTS] = {}; // files of the player, player only
+    uint32_t Cache_Tick = 0;
+    String Cache_File[MAS_CACHE_SLOTS];
+    MAS_Bank Bank; // sound bank of openBank
+    //--------------------------------------------------------------------------------sounds
+    const char *Sound_File[MAS_SOUNDS] = {}; // names of addSound and setSounds, not copied
+    uint16_t Sound_Count = 0;
+};
+
+//-----------------------------------------------------------sound system with MAS_CHANNELS
+template <uint8_t MAS_CHANNELS = 3>
+class ESP32_MAS : public ESP32_MAS_Base {
+    static_assert(MAS_CHANNELS > 0 && MAS_CHANNELS < 128, "ESP32_MAS needs 1 - 127 channels");
+  public:
+    ESP32_MAS() : ESP32_MAS_Base(MAS_CHANNELS, Channel_Mem, Gain_Mem, Pitch_Mem, Priority_Mem,
+                                   Voice_Age_Mem, Chan_Cmd_Mem, Cache_Slot_Mem, Crossfade_Mem,
+                                   RPM_Mem, Layers_Mem, Pan_Mem, Bus_Mem, Stream_Mem) {
+      initChannels();
+    };
+    ~ESP32_MAS() {
+      endChannels();
+    };
+  private:
+    uint8_t Channel_Mem[MAS_CHANNELS];
+    uint8_t Gain_Mem[MAS_CHANNELS];
+    float Pitch_Mem[MAS_CHANNELS];
+    uint8_t Priority_Mem[MAS_CHANNELS];
+    uint32_t Voice_Age_Mem[MAS_CHANNELS];
+    uint32_t Chan_Cmd_Mem[MAS_CHANNELS];
+    int8_t Cache_Slot_Mem[MAS_CHANNELS];
+    uint16_t Crossfade_Mem[MAS_CHANNELS];
+    uint16_t RPM_Mem[MAS_CHANNELS];
+    uint8_t Layers_Mem[MAS_CHANNELS];
+    int8_t Pan_Mem[MAS_CHANNELS];
+    uint8_t Bus_Mem[MAS_CHANNELS];
+    MAS_Stream Stream_Mem[MAS_CHANNELS];
 };
 #endif
@@ -0,0 +1,84 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*/
+
+#include "MAS_Platform.h"
+#include "MAS_Bank.h"
+
+uint32_t MAS_Bank_Hash(const char *name) {
+  uint32_t hash = 2166136261u;
+  while (*name) {
+    hash = (hash ^ (uint8_t)*name++) * 16777619u;
+  }
+  return hash;
+}
+//--------------------------------------------------------------------------------open bank
+bool MAS_Bank::open(const char *name) {
+  uint32_t size = 0;
+  const uint8_t *data = MAS_Map(name, &size);
+  Count = 0;
+  if (data == NULL || size < sizeof(MAS_Bank_Header)) {
+    return false;
+  }
+  const MAS_Bank_Header *header = (const MAS_Bank_Header*)data;
+  if (header->magic != MAS_BANK_MAGIC || header->version != MAS_BANK_VERSION ||
+      header->size > size || header->index % 4 != 0 || header->index > header->size ||
+      header->count > (header->size - header->index) / sizeof(MAS_Bank_Entry)) {
+    return false;
+  }
+  const MAS_Bank_Entry *index = (const MAS_Bank_Entry*)(data + header->index);
+  for (uint32_t i = 0; i < header->count; i++) {
+    //-------------------------------------------------------------every sound is in the bank
+    const MAS_Bank_Entry *entry = &index[i];
+    if (entry->offset % 4 != 0 || entry->offset > header->size ||
+        entry->len > (header->size - entry->offset) / 2 || entry->loop_end > entry->len ||
+        entry->loop_start >= (entry->loop_end > 0 ? entry->loop_end : 1) ||
+        entry->name[MAS_BANK_NAME - 1] != 0 || (i > 0 && entry->hash < index[i - 1].hash)) {
+      return false;
+    }
+  }
+  Data = data;
+  Index = index;
+  Count = header->count;
+  return true;
+}//                                                                               open bank
+//-------------------------------------------------------------------------------find sound
+bool MAS_Bank::find(const char *name, MAS_Sound *sound) const {
+  uint32_t hash = MAS_Bank_Hash(name);
+  uint32_t low = 0;
+  uint32_t high = Count;
+  while (low < high) {
+    //------------------------------------------------------------first entry of the hash
+    uint32_t mid = (low + high) / 2;
+    if (Index[mid].hash < hash) {
+      low = mid + 1;
+    }
+    else {
+      high = mid;
+    }
+  }
+  for (; low < Count && Index[low].hash == hash; low++) {
+    const MAS_Bank_Entry *entry = &Index[low];
+    if (strcmp(entry->name, name) == 0) {
+      sound->data = (const int16_t*)(Data + entry->offset);
+      sound->len = entry->len;
+      sound->rate = entry->rate;
+      sound->loop_start = entry->loop_start;
+      sound->loop_end = entry->loop_end;
+      return true;
+    }
+  }
+  return false;
+}//                                                                              find sound
+uint32_t MAS_Bank::count() const {
+  return Count;
+}
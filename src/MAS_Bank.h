@@ -0,0 +1,78 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Sound bank of the ESP32_MAS.
+
+  A sound bank holds decoded sounds in one read only image, a data partition in the flash of
+  the ESP32 or a file on the host (see MAS_Map). The player reads the samples straight from the
+  mapped image like a cached file: no file is opened, nothing is copied.
+  The bank is built on the host by extras/MAS_Pack from a directory of sound files.
+
+  Layout, little endian, offsets in bytes from the start of the bank:
+  header   MAS_Bank_Header
+  index    count MAS_Bank_Entry sorted by hash, hash = FNV-1a of the name
+  samples  PCM signed 16 bit mono of every sound, 4 byte aligned
+  -------------------------------------------------------------------------------------------*/
+#ifndef _MAS_BANK_
+#define _MAS_BANK_
+#include "MAS_Platform.h"
+
+#define MAS_BANK_MAGIC 0x4253414Du // "MASB"
+#define MAS_BANK_VERSION 1
+#define MAS_BANK_NAME 32 // bytes of a name with path and 0
+
+//-----------------------------------------------------------------------------sound in memory
+// Decoded samples in the sample cache or in a sound bank.
+struct MAS_Sound {
+  const int16_t *data = NULL; // NULL = file of the file system
+  uint32_t len = 0; // samples
+  uint32_t rate = 22050; // sample / sec
+  uint32_t loop_start = 0; // first sample of the repeats of a loop
+  uint32_t loop_end = 0; // end of a loop, len = the whole sound
+};
+
+struct MAS_Bank_Header {
+  uint32_t magic; // MAS_BANK_MAGIC
+  uint32_t version; // MAS_BANK_VERSION
+  uint32_t count; // sounds
+  uint32_t index; // offset of the index
+  uint32_t size; // bytes of the bank
+};
+
+struct MAS_Bank_Entry {
+  uint32_t hash; // MAS_Bank_Hash of the name
+  uint32_t offset; // offset of the first sample
+  uint32_t len; // samples
+  uint32_t rate; // sample / sec
+  uint32_t loop_start; // first sample of the repeats of a loop
+  uint32_t loop_end; // end of a loop
+  char name[MAS_BANK_NAME]; // full path like the file system, "/horn.aiff"
+};
+
+// FNV-1a hash of a name.
+uint32_t MAS_Bank_Hash(const char *name);
+
+//---------------------------------------------------------------------------------sound bank
+class MAS_Bank {
+  public:
+    // Maps the bank of MAS_Map and checks the header and the index.
+    bool open(const char *name);
+    // Looks up a sound by its name. false = not in the bank.
+    bool find(const char *name, MAS_Sound *sound) const;
+    uint32_t count() const; // sounds, 0 = no bank
+  private:
+    const uint8_t *Data = NULL;
+    const MAS_Bank_Entry *Index = NULL;
+    uint32_t Count = 0;
+};
+#endif
@@ -0,0 +1,342 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*/
+
+#include "MAS_Platform.h"
+#include "MAS_Decoder.h"
+
+MAS_PCM_Decoder MAS_PCM;
+MAS_IMA_Decoder MAS_IMA;
+MAS_IMA4_Decoder MAS_IMA4;
+
+static const int8_t ima_index_table[16] = {
+  -1, -1, -1, -1, 2, 4, 6, 8,
+  -1, -1, -1, -1, 2, 4, 6, 8
+};
+static const int16_t ima_step_table[89] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+  19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+  50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+  130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+  337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+  876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+  2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+  5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+  15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+//------------------------------------------------------------------------------IMA nibble
+static inline int16_t ima_nibble(uint8_t nibble, int32_t *predictor, int8_t *index) {
+  int32_t step = ima_step_table[*index];
+  int32_t diff = step >> 3;
+  if (nibble & 4) {
+    diff += step;
+  }
+  if (nibble & 2) {
+    diff += step >> 1;
+  }
+  if (nibble & 1) {
+    diff += step >> 2;
+  }
+  if (nibble & 8) {
+    *predictor -= diff;
+  }
+  else {
+    *predictor += diff;
+  }
+  if (*predictor > 32767) {
+    *predictor = 32767;
+  }
+  if (*predictor < -32768) {
+    *predictor = -32768;
+  }
+  *index += ima_index_table[nibble];
+  if (*index < 0) {
+    *index = 0;
+  }
+  if (*index > 88) {
+    *index = 88;
+  }
+  return *predictor;
+}//                                                                                IMA nibble
+//--------------------------------------------------------------------------mix channel to mono
+static inline void mix_mono(int16_t *out, int32_t sample, int channel) {
+  if (channel == 0) {
+    *out = sample;
+  }
+  else {
+    *out += (sample - *out) / (channel + 1);
+  }
+}//                                                                       mix channel to mono
+
+//-------------------------------------------------------------------------------------PCM
+uint32_t MAS_PCM_Decoder::samples(const MAS_Format *format, uint32_t len) {
+  return len / format->block_align;
+}
+int MAS_PCM_Decoder::decode(const MAS_Format *format, const uint8_t *data, int len, int16_t *out) {
+  int frames = len / format->block_align;
+  int channels = format->channels;
+  if (format->bits == 8) {
+    //-----------------------------------------------------------------------------------8 bit
+    int offset = format->is_signed ? 0 : 128;
+    for (int i = 0; i < frames; i++) {
+      int32_t sum = 0;
+      for (int c = 0; c < channels; c++) {
+        sum += (int8_t)(*data++ - offset);
+      }
+      out[i] = (sum / channels) * 256;
+    }
+  }
+  else {
+    //----------------------------------------------------------------------------------16 bit
+    for (int i = 0; i < frames; i++) {
+      int32_t sum = 0;
+      for (int c = 0; c < channels; c++) {
+        if (format->big_endian) {
+          sum += (int16_t)((data[0] << 8) | data[1]);
+        }
+        else {
+          sum += (int16_t)((data[1] << 8) | data[0]);
+        }
+        data += 2;
+      }
+      out[i] = sum / channels;
+    }
+  }
+  return frames;
+}//                                                                                       PCM
+
+//---------------------------------------------------------------------------WAVE IMA-ADPCM
+// Samples per channel of a block of bytes > 4 * channels. With more channels the nibbles come
+// in words of 4 bytes per channel, a broken word at the end is not decoded.
+static int ima_block_samples(int bytes, int channels) {
+  if (channels == 1) {
+    return (bytes - 4) * 2 + 1;
+  }
+  return (bytes - 4 * channels) / (4 * channels) * 8 + 1;
+}
+uint32_t MAS_IMA_Decoder::samples(const MAS_Format *format, uint32_t len) {
+  uint32_t blocks = len / format->block_align;
+  uint32_t rest = len % format->block_align;
+  uint32_t count = blocks * format->block_samples;
+  if (rest > 4u * format->channels) {
+    count += ima_block_samples(rest, format->channels);
+  }
+  return count;
+}
+int MAS_IMA_Decoder::decode(const MAS_Format *format, const uint8_t *data, int len, int16_t *out) {
+  int channels = format->channels;
+  int count = 0;
+  while (len > 4 * channels) {
+    int block = len < format->block_align ? len : format->block_align;
+    int block_samples = ima_block_samples(block, channels);
+    for (int c = 0; c < channels; c++) {
+      //--------------------------------------------------------------------decode one channel
+      const uint8_t *header = data + 4 * c;
+      int32_t predictor = (int16_t)((header[1] << 8) | header[0]);
+      int8_t index = header[2] > 88 ? 88 : header[2]; // clamped as uint8_t, also a byte >= 128
+      mix_mono(&out[count], predictor, c);
+      for (int s = 0; s < block_samples - 1; s++) {
+        //---------------------------------------------nibbles are packed in 4 bytes per channel
+        const uint8_t *byte = data + 4 * channels + (s / 8) * 4 * channels + c * 4 + (s % 8) / 2;
+        uint8_t nibble = (s & 1) ? (*byte >> 4) : (*byte & 0x0F);
+        mix_mono(&out[count + 1 + s], ima_nibble(nibble, &predictor, &index), c);
+      }
+    }
+    count += block_samples;
+    data += block;
+    len -= block;
+  }
+  return count;
+}//                                                                         WAVE IMA-ADPCM
+
+//-------------------------------------------------------------------------------AIFC ima4
+uint32_t MAS_IMA4_Decoder::samples(const MAS_Format *format, uint32_t len) {
+  return len / format->block_align * 64;
+}
+int MAS_IMA4_Decoder::decode(const MAS_Format *format, const uint8_t *data, int len, int16_t *out) {
+  int channels = format->channels;
+  int count = 0;
+  while (len >= format->block_align) {
+    for (int c = 0; c < channels; c++) {
+      //------------------------------------------------------------34 byte packet per channel
+      const uint8_t *packet = data + 34 * c;
+      uint16_t header = (packet[0] << 8) | packet[1];
+      int32_t predictor = (int16_t)(header & 0xFF80);
+      int8_t index = (header & 0x7F) > 88 ? 88 : header & 0x7F;
+      for (int s = 0; s < 64; s++) {
+        uint8_t byte = packet[2 + s / 2];
+        uint8_t nibble = (s & 1) ? (byte >> 4) : (byte & 0x0F);
+        mix_mono(&out[count + s], ima_nibble(nibble, &predictor, &index), c);
+      }
+    }
+    count += 64;
+    data += format->block_align;
+    len -= format->block_align;
+  }
+  return count;
+}//                                                                             AIFC ima4
+
+//-----------------------------------------------------------------------------read header
+static uint32_t be32(const uint8_t *b) {
+  return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | b[3];
+}
+static uint16_t be16(const uint8_t *b) {
+  return (b[0] << 8) | b[1];
+}
+static uint32_t le32(const uint8_t *b) {
+  return ((uint32_t)b[3] << 24) | ((uint32_t)b[2] << 16) | ((uint32_t)b[1] << 8) | b[0];
+}
+static uint16_t le16(const uint8_t *b) {
+  return (b[1] << 8) | b[0];
+}
+static uint32_t extended_rate(const uint8_t *b) {
+  //---------------------------------------------------80 bit IEEE 754 extended to integer
+  int exponent = ((b[0] & 0x7F) << 8 | b[1]) - 16383 - 31;
+  uint32_t mantissa = be32(b + 2);
+  if (exponent > 0 || exponent < -31) {
+    return 0;
+  }
+  return mantissa >> -exponent;
+}
+bool MAS_Read_Format(MAS_File *file, MAS_Format *format) {
+  uint8_t head[26];
+  uint32_t size = file->size();
+  uint32_t pos = 12;
+  bool found_format = false;
+  bool found_data = false;
+  *format = MAS_Format();
+  file->seek(0);
+  if (file->read(head, 12) != 12 ||
+      (memcmp(head, "FORM", 4) != 0 && memcmp(head, "RIFF", 4) != 0)) {
+    //----------------------------------------------------------------RAW file without header
+    format->decoder = &MAS_PCM;
+    format->data_len = size;
+    file->seek(0);
+    return true;
+  }
+  bool aiff = memcmp(head, "FORM", 4) == 0;
+  bool aifc = aiff && memcmp(head + 8, "AIFC", 4) == 0;
+  if (aiff && !aifc && memcmp(head + 8, "AIFF", 4) != 0) {
+    return false;
+  }
+  if (!aiff && memcmp(head + 8, "WAVE", 4) != 0) {
+    return false;
+  }
+  while (pos + 8 <= size && !(found_format && found_data)) {
+    //-------------------------------------------------------------------------------chunks
+    file->seek(pos);
+    if (file->read(head, 8) != 8) {
+      break;
+    }
+    uint32_t len = aiff ? be32(head + 4) : le32(head + 4);
+    if (aiff && memcmp(head, "COMM", 4) == 0) {
+      //------------------------------------------------------------------------AIFF COMM
+      int fields = aifc ? 22 : 18; // bytes up to the compression type of AIFC
+      if (len < (uint32_t)fields || file->read(head, fields) != fields) {
+        format->decoder = NULL;
+        return false; // too short for the fields of the format
+      }
+      format->channels = be16(head);
+      format->bits = be16(head + 6);
+      format->rate = extended_rate(head + 8);
+      format->big_endian = true;
+      format->decoder = &MAS_PCM;
+      if (aifc) {
+        if (memcmp(head + 18, "sowt", 4) == 0) {
+          format->big_endian = false;
+        }
+        else if (memcmp(head + 18, "ima4", 4) == 0) {
+          format->decoder = &MAS_IMA4;
+        }
+        else if (memcmp(head + 18, "NONE", 4) != 0 && memcmp(head + 18, "twos", 4) != 0) {
+          format->decoder = NULL;
+        }
+      }
+      found_format = true;
+    }
+    else if (aiff && memcmp(head, "SSND", 4) == 0) {
+      //------------------------------------------------------------------------AIFF SSND
+      if (len < 8 || file->read(head, 8) != 8 || be32(head) > len - 8 ||
+          be32(head) > size - pos - 16) {
+        format->decoder = NULL;
+        return false; // the offset is outside of the chunk or of the file
+      }
+      format->data_start = pos + 16 + be32(head);
+      format->data_len = len - 8 - be32(head);
+      found_data = true;
+    }
+    else if (!aiff && memcmp(head, "fmt ", 4) == 0) {
+      //------------------------------------------------------------------------WAVE fmt
+      memset(head, 0, sizeof(head));
+      if (len < 16 || file->read(head, len < 20 ? len : 20) < 16) {
+        format->decoder = NULL;
+        return false; // too short for the fields of the format
+      }
+      uint16_t tag = le16(head);
+      format->channels = le16(head + 2);
+      format->rate = le32(head + 4);
+      format->block_align = le16(head + 12);
+      format->bits = le16(head + 14);
+      format->big_endian = false;
+      format->is_signed = format->bits != 8;
+      if (tag == 1) {
+        format->decoder = &MAS_PCM;
+      }
+      else if (tag == 0x11 && format->bits == 4) {
+        format->decoder = &MAS_IMA;
+      }
+      found_format = true;
+    }
+    else if (!aiff && memcmp(head, "data", 4) == 0) {
+      //------------------------------------------------------------------------WAVE data
+      format->data_start = pos + 8;
+      format->data_len = len;
+      found_data = true;
+    }
+    if (len > size - pos - 8) {
+      break; // the chunk ends behind the file, a data chunk is cut below
+    }
+    pos += 8 + len + (len & 1);
+  }//                                                                                 chunks
+  if (!found_format || !found_data || format->decoder == NULL ||
+      format->channels == 0 || format->rate == 0) {
+    format->decoder = NULL;
+    return false;
+  }
+  //----------------------------------------------------------------------------block size
+  if (format->decoder == &MAS_PCM) {
+    if (format->bits != 8 && format->bits != 16) {
+      format->decoder = NULL;
+      return false;
+    }
+    format->block_align = format->channels * format->bits / 8;
+    format->block_samples = 1;
+  }
+  else if (format->decoder == &MAS_IMA4) {
+    format->block_align = 34 * format->channels;
+    format->block_samples = 64;
+  }
+  else if (format->block_align <= 4 * format->channels) {
+    format->decoder = NULL;
+    return false;
+  }
+  else {
+    format->block_samples = ima_block_samples(format->block_align, format->channels);
+  }
+  if (format->data_start > size || format->data_len > size - format->data_start) {
+    format->data_len = size > format->data_start ? size - format->data_start : 0;
+  }
+  format->data_len -= format->data_len % (format->decoder == &MAS_IMA ? 1 : format->block_align);
+  file->seek(format->data_start);
+  return true;
+}//                                                                             read header
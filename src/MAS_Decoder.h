@@ -0,0 +1,77 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  File formats and decoders of the ESP32_MAS.
+
+  MAS_Read_Format reads the header of a file and selects the decoder:
+  AIFF  FORM/AIFF, PCM signed 8 or 16 bit big endian
+  AIFC  FORM/AIFC, NONE/twos = 8 or 16 bit big endian, sowt = 16 bit little endian,
+        ima4 = IMA-ADPCM packets of 64 samples
+  WAVE  RIFF/WAVE, PCM unsigned 8 or signed 16 bit little endian, 0x11 = IMA-ADPCM
+  RAW   file without a header, PCM signed 8 bit mono 22050 sample / sec
+  All decoders deliver signed 16 bit mono samples. Files with more channels are mixed to mono.
+  A decoder is stateless, it decodes whole blocks of "block_align" bytes.
+  -------------------------------------------------------------------------------------------*/
+#ifndef _MAS_DECODER_
+#define _MAS_DECODER_
+#include "MAS_Platform.h"
+
+class MAS_Decoder;
+
+struct MAS_Format {
+  MAS_Decoder *decoder = NULL; // NULL = file can not be played
+  uint8_t channels = 1;
+  uint8_t bits = 8;
+  bool big_endian = false;
+  bool is_signed = true;
+  uint32_t rate = 22050; // sample / sec
+  uint32_t data_start = 0; // first byte of the samples in the file
+  uint32_t data_len = 0; // bytes of the samples
+  uint16_t block_align = 1; // bytes of a frame or ADPCM block
+  uint16_t block_samples = 1; // samples of a frame or ADPCM block per channel
+};
+
+class MAS_Decoder {
+  public:
+    // Number of mono samples in len bytes of the data.
+    virtual uint32_t samples(const MAS_Format *format, uint32_t len) = 0;
+    // Decodes len bytes, a multiple of block_align or the last block of the data.
+    // Returns the number of mono samples written to out.
+    virtual int decode(const MAS_Format *format, const uint8_t *data, int len, int16_t *out) = 0;
+};
+
+class MAS_PCM_Decoder : public MAS_Decoder {
+  public:
+    uint32_t samples(const MAS_Format *format, uint32_t len);
+    int decode(const MAS_Format *format, const uint8_t *data, int len, int16_t *out);
+};
+
+class MAS_IMA_Decoder : public MAS_Decoder { // WAVE IMA-ADPCM
+  public:
+    uint32_t samples(const MAS_Format *format, uint32_t len);
+    int decode(const MAS_Format *format, const uint8_t *data, int len, int16_t *out);
+};
+
+class MAS_IMA4_Decoder : public MAS_Decoder { // AIFC ima4
+  public:
+    uint32_t samples(const MAS_Format *format, uint32_t len);
+    int decode(const MAS_Format *format, const uint8_t *data, int len, int16_t *out);
+};
+
+extern MAS_PCM_Decoder MAS_PCM;
+extern MAS_IMA_Decoder MAS_IMA;
+extern MAS_IMA4_Decoder MAS_IMA4;
+
+// Reads the header and sets the file to the first sample. false = format not supported.
+bool MAS_Read_Format(MAS_File *file, MAS_Format *format);
+#endif
@@ -0,0 +1,118 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*/
+
+#include "MAS_Platform.h"
+#include "MAS_Engine.h"
+#include "MAS_Mixer.h"
+#include "MAS_Resampler.h"
+
+//---------------------------------------------------------------------------------add layer
+bool MAS_Engine_Add(MAS_Engine *engine, const int16_t *data, uint32_t len, uint32_t rate,
+                    uint16_t rpm, int8_t slot) {
+  if (engine->layers >= MAS_ENGINE_LAYERS || data == NULL || len == 0) {
+    return false;
+  }
+  int i = engine->layers;
+  while (i > 0 && engine->layer[i - 1].rpm > rpm) {
+    engine->layer[i] = engine->layer[i - 1];
+    i--;
+  }
+  MAS_Layer *layer = &engine->layer[i];
+  layer->data = data;
+  layer->len = len;
+  layer->rate = rate;
+  layer->rpm = rpm;
+  layer->slot = slot;
+  layer->pos = 0;
+  layer->phase = 0;
+  engine->layers++;
+  return true;
+}//                                                                               add layer
+//------------------------------------------------------------------------------render layer
+// Loops the layer at the Q16 step, the neighbours of the resampler wrap around the loop.
+static void Render_Layer(MAS_Layer *layer, int16_t *out, int len, uint32_t step, uint8_t mode) {
+  const int16_t *data = layer->data;
+  uint32_t loop_len = layer->len;
+  uint32_t pos = layer->pos;
+  uint32_t frac = layer->phase;
+  for (int i = 0; i < len; i++) {
+    uint32_t p1 = pos + 1 < loop_len ? pos + 1 : pos + 1 - loop_len;
+    uint32_t p2 = p1 + 1 < loop_len ? p1 + 1 : p1 + 1 - loop_len;
+    int32_t x0 = data[pos > 0 ? pos - 1 : loop_len - 1];
+    out[i] = MAS_Interpolate(mode, x0, data[pos], data[p1], data[p2], frac);
+    frac += step;
+    pos += frac >> MAS_PHASE_BITS;
+    frac &= MAS_PHASE_MASK;
+    if (pos >= loop_len) {
+      pos %= loop_len;
+    }
+  }
+  layer->pos = pos;
+  layer->phase = frac;
+}//                                                                            render layer
+//-------------------------------------------------------------------------------layer step
+// Q16 step of the layer at rpm, limited to quarter - 4 times speed like setPitch.
+static uint32_t Layer_Step(const MAS_Layer *layer, int32_t rpm, float pitch) {
+  float speed = (1 + pitch) * layer->rate / 22050;
+  if (layer->rpm > 0) {
+    speed = speed * rpm / layer->rpm;
+  }
+  if (speed < 0.25f) {
+    speed = 0.25f;
+  }
+  if (speed > 4) {
+    speed = 4;
+  }
+  return speed * MAS_PHASE_ONE;
+}//                                                                              layer step
+//----------------------------------------------------------------------------------render
+void MAS_Engine_Render(MAS_Engine *engine, int16_t *out, int16_t *tmp, int len, float pitch,
+                       uint8_t mode) {
+  if (engine->layers == 0) {
+    for (int i = 0; i < len; i++) {
+      out[i] = 0;
+    }
+    return;
+  }
+  MAS_Layer *layer = engine->layer;
+  int32_t rpm_from = engine->rpm_now;
+  int32_t rpm_diff = (int32_t)engine->rpm - rpm_from;
+  int last = engine->layers - 1;
+  for (int pos = 0; pos < len; pos += MAS_ENGINE_STEP) {
+    //----------------------------------------------------------------------------sub block
+    int count = len - pos < MAS_ENGINE_STEP ? len - pos : MAS_ENGINE_STEP;
+    int32_t rpm_a = rpm_from + rpm_diff * pos / len;
+    int32_t rpm_b = rpm_from + rpm_diff * (pos + count) / len;
+    int32_t rpm = (rpm_a + rpm_b) / 2;
+    int low = -1;
+    while (low < last && layer[low + 1].rpm <= rpm) {
+      low++;
+    }
+    if (low < 0 || low == last) {
+      //-------------------------------------------------------------below the first or above
+      MAS_Layer *one = &layer[low < 0 ? 0 : last];
+      Render_Layer(one, out + pos, count, Layer_Step(one, rpm, pitch), mode);
+      continue;
+    }
+    //------------------------------------------------------------blend the layers next to rpm
+    // The Q16 blend index 0 - 64 << 16 is (rpm - rpm of low) / (rpm of high - rpm of low).
+    MAS_Layer *high = &layer[low + 1];
+    int32_t range = high->rpm - layer[low].rpm;
+    int32_t index_a = (int64_t)(rpm_a - layer[low].rpm) * (1 << 22) / range;
+    int32_t index_b = (int64_t)(rpm_b - layer[low].rpm) * (1 << 22) / range;
+    Render_Layer(high, out + pos, count, Layer_Step(high, rpm, pitch), mode);
+    Render_Layer(&layer[low], tmp, count, Layer_Step(&layer[low], rpm, pitch), mode);
+    MAS_Mix_Blend(out + pos, tmp, index_a, (index_b - index_a) / count, count);
+  }//                                                                             sub block
+  engine->rpm_now = engine->rpm;
+}//                                                                                  render
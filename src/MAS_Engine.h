@@ -0,0 +1,57 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Engine synthesizer of the ESP32_MAS.
+
+  An engine voice loops recordings of an engine (layers) at known rpm from the sample cache.
+  Every layer is resampled by rpm / rpm of the recording, only the two layers next to the
+  rpm are rendered and blended with an equal power crossfade (see MAS_Mix_Blend).
+  Below the first and above the last layer one layer is played alone.
+  The rpm ramps linearly over a block, the resampler step and the pair of layers are
+  taken every MAS_ENGINE_STEP samples, so rpm changes do not click.
+  The other layers keep their loop position and fade in from 0 when they are needed.
+  -------------------------------------------------------------------------------------------*/
+#ifndef _MAS_ENGINE_
+#define _MAS_ENGINE_
+#include "MAS_Platform.h"
+
+#ifndef MAS_ENGINE_LAYERS
+#define MAS_ENGINE_LAYERS 8 // recordings of an engine voice
+#endif
+#define MAS_ENGINE_STEP 32 // output samples with the same resampler step
+
+struct MAS_Layer {
+  const int16_t *data = NULL; // cached samples of the loop
+  uint32_t len = 0; // samples
+  uint32_t rate = 22050; // sample / sec
+  uint16_t rpm = 0; // rpm of the recording
+  int8_t slot = -1; // cache slot
+  uint32_t pos = 0; // sample of the loop
+  uint32_t phase = 0; // Q16 fraction
+};
+
+struct MAS_Engine {
+  MAS_Layer layer[MAS_ENGINE_LAYERS]; // ascending rpm
+  uint8_t layers = 0;
+  uint16_t rpm = 0; // rpm at the end of the next block
+  uint16_t rpm_now = 0; // rpm at the end of the last block
+};
+
+// Inserts a layer in the order of rpm. false = all layers are used.
+bool MAS_Engine_Add(MAS_Engine *engine, const int16_t *data, uint32_t len, uint32_t rate,
+                    uint16_t rpm, int8_t slot);
+// Renders len samples to out, tmp holds len samples. pitch = channel pitch (0 = normal),
+// mode = interpolation (see MAS_Resampler.h).
+void MAS_Engine_Render(MAS_Engine *engine, int16_t *out, int16_t *tmp, int len, float pitch,
+                       uint8_t mode);
+#endif
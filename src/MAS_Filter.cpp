@@ -0,0 +1,236 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*/
+
+#include "MAS_Platform.h"
+#include "MAS_Filter.h"
+#include "MAS_Mixer.h"
+#include <math.h>
+
+//-------------------------------------------------------------------------------coefficients
+void MAS_Biquad_Set(MAS_Biquad *filter, const MAS_Filter_Set *set, float rate) {
+  float freq = set->freq < rate * 0.49f ? set->freq : rate * 0.49f;
+  float q = set->q > 0.1f ? set->q : 0.1f;
+  float gain = set->gain < -24 ? -24 : set->gain > 24 ? 24 : set->gain;
+  float w0 = 2 * (float)M_PI * (freq > 1 ? freq : 1) / rate;
+  float cos_w0 = cosf(w0);
+  float sin_half = sinf(w0 / 2);
+  float one_minus_cos = 2 * sin_half * sin_half; // 1 - cos_w0 without cancellation at low freq
+  float alpha = sinf(w0) / (2 * q);
+  float a = powf(10, gain / 40);
+  float shelf = 2 * sqrtf(a) * alpha;
+  float b0 = 1, b1 = 0, b2 = 0, a0 = 1, a1 = 0, a2 = 0;
+  switch (set->type) {
+    case MAS_FILTER_LOWPASS:
+      b0 = one_minus_cos / 2;
+      b1 = one_minus_cos;
+      b2 = b0;
+      a0 = 1 + alpha;
+      a1 = -2 * cos_w0;
+      a2 = 1 - alpha;
+      break;
+    case MAS_FILTER_HIGHPASS:
+      b0 = (1 + cos_w0) / 2;
+      b1 = -(1 + cos_w0);
+      b2 = b0;
+      a0 = 1 + alpha;
+      a1 = -2 * cos_w0;
+      a2 = 1 - alpha;
+      break;
+    case MAS_FILTER_PEAK:
+      b0 = 1 + alpha * a;
+      b1 = -2 * cos_w0;
+      b2 = 1 - alpha * a;
+      a0 = 1 + alpha / a;
+      a1 = -2 * cos_w0;
+      a2 = 1 - alpha / a;
+      break;
+    case MAS_FILTER_LOWSHELF:
+      b0 = a * ((a + 1) - (a - 1) * cos_w0 + shelf);
+      b1 = 2 * a * ((a - 1) - (a + 1) * cos_w0);
+      b2 = a * ((a + 1) - (a - 1) * cos_w0 - shelf);
+      a0 = (a + 1) + (a - 1) * cos_w0 + shelf;
+      a1 = -2 * ((a - 1) + (a + 1) * cos_w0);
+      a2 = (a + 1) + (a - 1) * cos_w0 - shelf;
+      break;
+    case MAS_FILTER_HIGHSHELF:
+      b0 = a * ((a + 1) + (a - 1) * cos_w0 + shelf);
+      b1 = -2 * a * ((a - 1) + (a + 1) * cos_w0);
+      b2 = a * ((a + 1) + (a - 1) * cos_w0 - shelf);
+      a0 = (a + 1) - (a - 1) * cos_w0 + shelf;
+      a1 = 2 * ((a - 1) - (a + 1) * cos_w0);
+      a2 = (a + 1) - (a - 1) * cos_w0 - shelf;
+      break;
+    default:
+      filter->x1 = filter->x2 = filter->y1 = filter->y2 = 0;
+      filter->rest = 0;
+      break;
+  }
+  float one = 1 << MAS_BIQUAD_BITS;
+  filter->type = set->type <= MAS_FILTER_HIGHSHELF ? set->type : MAS_FILTER_OFF;
+  filter->b0 = lrintf(b0 / a0 * one);
+  filter->b1 = lrintf(b1 / a0 * one);
+  filter->b2 = lrintf(b2 / a0 * one);
+  filter->a1 = lrintf(a1 / a0 * one);
+  filter->a2 = lrintf(a2 / a0 * one);
+  // The gain of the poles at 0 Hz (low pass) or at the Nyquist frequency (high pass) is
+  // 4 * b0: with a2 moved by up to 3 / 2^26 it is a multiple of 4, the pass band of the Q26
+  // filter is exactly 0dB and its zero at the other end is exact.
+  if (filter->type == MAS_FILTER_LOWPASS || filter->type == MAS_FILTER_HIGHPASS) {
+    int32_t sign = filter->type == MAS_FILTER_LOWPASS ? 1 : -1;
+    int32_t poles = (1 << MAS_BIQUAD_BITS) + sign * filter->a1 + filter->a2;
+    filter->a2 -= poles & 3;
+    poles -= poles & 3;
+    filter->b0 = filter->b2 = poles / 4;
+    filter->b1 = sign * poles / 2;
+  }
+}//                                                                             coefficients
+//------------------------------------------------------------------------------------biquad
+// Direct form 1, the state and the coefficients stay in registers over the block.
+// The fraction cut off an output is added to the next sum (first order error feedback),
+// so filters with poles close to 1 (low corners) have no dead band and no dc offset.
+void MAS_Biquad_Run(MAS_Biquad *filter, int32_t *buf, int len) {
+  const int64_t b0 = filter->b0, b1 = filter->b1, b2 = filter->b2;
+  const int64_t a1 = filter->a1, a2 = filter->a2;
+  int32_t x1 = filter->x1, x2 = filter->x2, y1 = filter->y1, y2 = filter->y2;
+  int64_t rest = filter->rest;
+  for (int i = 0; i < len; i++) {
+    int32_t x0 = buf[i];
+    int64_t sum = b0 * x0 + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2 + rest;
+    int32_t y0 = sum >> MAS_BIQUAD_BITS;
+    rest = sum & MAS_BIQUAD_MASK;
+    x2 = x1;
+    x1 = x0;
+    y2 = y1;
+    y1 = y0;
+    buf[i] = y0;
+  }
+  filter->x1 = x1;
+  filter->x2 = x2;
+  filter->y1 = y1;
+  filter->y2 = y2;
+  filter->rest = rest;
+}
+
+void MAS_Biquad_Run16(MAS_Biquad *filter, int16_t *buf, int len) {
+  const int64_t b0 = filter->b0, b1 = filter->b1, b2 = filter->b2;
+  const int64_t a1 = filter->a1, a2 = filter->a2;
+  int32_t x1 = filter->x1, x2 = filter->x2, y1 = filter->y1, y2 = filter->y2;
+  int64_t rest = filter->rest;
+  for (int i = 0; i < len; i++) {
+    int32_t x0 = buf[i];
+    int64_t sum = b0 * x0 + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2 + rest;
+    int32_t y0 = sum >> MAS_BIQUAD_BITS;
+    rest = sum & MAS_BIQUAD_MASK;
+    y0 = y0 > 32767 ? 32767 : y0 < -32768 ? -32768 : y0;
+    x2 = x1;
+    x1 = x0;
+    y2 = y1;
+    y1 = y0;
+    buf[i] = y0;
+  }
+  filter->x1 = x1;
+  filter->x2 = x2;
+  filter->y1 = y1;
+  filter->y2 = y2;
+  filter->rest = rest;
+}//                                                                                   biquad
+
+void MAS_Filter_Chain(MAS_Biquad *chain, int32_t *buf, int len) {
+  for (int i = 0; i < MAS_FILTERS; i++) {
+    if (chain[i].type != MAS_FILTER_OFF) {
+      MAS_Biquad_Run(&chain[i], buf, len);
+    }
+  }
+}
+
+void MAS_Filter_Chain16(MAS_Biquad *chain, int16_t *buf, int len) {
+  for (int i = 0; i < MAS_FILTERS; i++) {
+    if (chain[i].type != MAS_FILTER_OFF) {
+      MAS_Biquad_Run16(&chain[i], buf, len);
+    }
+  }
+}
+
+bool MAS_Filter_Used(const MAS_Biquad *chain) {
+  for (int i = 0; i < MAS_FILTERS; i++) {
+    if (chain[i].type != MAS_FILTER_OFF) {
+      return true;
+    }
+  }
+  return false;
+}
+void MAS_Filter_Clear(MAS_Biquad *chain) {
+  for (int i = 0; i < MAS_FILTERS; i++) {
+    chain[i].x1 = chain[i].x2 = chain[i].y1 = chain[i].y2 = 0;
+    chain[i].rest = 0;
+  }
+}
+//-----------------------------------------------------------------------------------limiter
+void MAS_Limiter_Set(MAS_Limiter *limiter, uint8_t threshold, uint32_t release) {
+  if (limiter->threshold == 0) {
+    *limiter = MAS_Limiter(); // the delay line starts empty
+  }
+  limiter->threshold = (threshold * 32767 / 255) << MAS_MIX_FRAC;
+  limiter->release = 32768 * MAS_LIMIT_STEP / (release > MAS_LIMIT_STEP ? release : MAS_LIMIT_STEP);
+}
+// Delays len samples by the delay line, applies the gain ramp and reads the peak.
+static int32_t Limit_Part(int32_t *buf, int32_t *delay, int len, int32_t gain, int32_t step,
+                          int32_t peak) {
+  for (int i = 0; i < len; i++) {
+    int32_t x = buf[i];
+    int32_t level = x < 0 ? -x : x;
+    peak = level > peak ? level : peak;
+    buf[i] = ((int64_t)delay[i] * (gain >> 15)) >> 15;
+    delay[i] = x;
+    gain += step;
+  }
+  return peak;
+}
+
+void MAS_Limiter_Run(MAS_Limiter *limiter, int32_t *left, int32_t *right, int len) {
+  int pos = 0;
+  while (pos < len) {
+    //--------------------------------------------------------------------------------part
+    // The step being read goes to the half of the delay line of the step going out.
+    int count = MAS_LIMIT_STEP - limiter->fill;
+    count = count < len - pos ? count : len - pos;
+    int at = limiter->half * MAS_LIMIT_STEP + limiter->fill;
+    limiter->peak = Limit_Part(left + pos, limiter->delay[0] + at, count, limiter->gain,
+                               limiter->step, limiter->peak);
+    if (right != NULL) {
+      limiter->peak = Limit_Part(right + pos, limiter->delay[1] + at, count, limiter->gain,
+                                 limiter->step, limiter->peak);
+    }
+    limiter->gain += limiter->step * count;
+    limiter->fill += count;
+    pos += count;
+    if (limiter->fill == MAS_LIMIT_STEP) {
+      //--------------------------------------------------------the next step goes out
+      // Its gain ramps to the lowest gain of itself and the step just read.
+      int32_t need = 32768;
+      if (limiter->peak > limiter->threshold) {
+        need = ((int64_t)limiter->threshold << 15) / limiter->peak;
+      }
+      int32_t target = limiter->target + limiter->release;
+      target = target < limiter->need ? target : limiter->need;
+      target = target < need ? target : need;
+      limiter->gain = limiter->target << 15;
+      limiter->step = (((int64_t)target << 15) - limiter->gain) / MAS_LIMIT_STEP;
+      limiter->target = target;
+      limiter->need = need;
+      limiter->peak = 0;
+      limiter->fill = 0;
+      limiter->half ^= 1;
+    }
+  }//                                                                                 part
+}//                                                                                  limiter
@@ -0,0 +1,102 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  DSP inserts of the ESP32_MAS.
+
+  Every channel, every bus and the master have MAS_FILTERS biquad filters, the master has a
+  look-ahead peak limiter. The filters run on whole blocks in fixed point: coefficients are
+  Q26 (range +-32) computed from the parameters only when they change (RBJ audio EQ cookbook),
+  the sum of the products is 64 bit with error feedback, the state is kept in local variables
+  over the block.
+
+  The limiter delays the output by 2 * MAS_LIMIT_STEP samples. It reads the peak of every step
+  of MAS_LIMIT_STEP samples and moves the gain linearly over a step to the lowest gain the step
+  and the following step need, so no sample is louder than the threshold. After the peaks the
+  gain moves back to 0dB within the release time.
+  -------------------------------------------------------------------------------------------*/
+#ifndef _MAS_FILTER_
+#define _MAS_FILTER_
+#include "MAS_Platform.h"
+
+#ifndef MAS_FILTERS
+#define MAS_FILTERS 2 // biquad filters of a channel, a bus and the master
+#endif
+#define MAS_BIQUAD_BITS 26 // fraction bits of the coefficients
+#define MAS_BIQUAD_MASK ((1 << MAS_BIQUAD_BITS) - 1)
+#define MAS_LIMIT_STEP 16 // samples with one gain slope of the limiter
+
+//-------------------------------------------------------------------------------filter types
+#define MAS_FILTER_OFF 0
+#define MAS_FILTER_LOWPASS 1 // freq = -3dB, q = 0.7071 for Butterworth
+#define MAS_FILTER_HIGHPASS 2
+#define MAS_FILTER_PEAK 3 // gain in dB at freq, q = bandwidth
+#define MAS_FILTER_LOWSHELF 4 // gain in dB below freq
+#define MAS_FILTER_HIGHSHELF 5 // gain in dB above freq
+
+// Parameters of a filter sent by the class.
+struct MAS_Filter_Set {
+  uint8_t type = MAS_FILTER_OFF;
+  uint8_t slot = 0; // filter of the chain
+  uint16_t freq = 1000; // Hz
+  float q = 0.7071f;
+  float gain = 0; // dB, -24 - 24
+};
+
+struct MAS_Biquad {
+  uint8_t type = MAS_FILTER_OFF;
+  int32_t b0 = 1 << MAS_BIQUAD_BITS; // y = b0 x0 + b1 x1 + b2 x2 - a1 y1 - a2 y2
+  int32_t b1 = 0;
+  int32_t b2 = 0;
+  int32_t a1 = 0;
+  int32_t a2 = 0;
+  int32_t x1 = 0; // state
+  int32_t x2 = 0;
+  int32_t y1 = 0;
+  int32_t y2 = 0;
+  int32_t rest = 0; // fraction of the last output
+};
+
+struct MAS_Limiter {
+  int32_t threshold = 0; // peak in mixer units (16 bit << MAS_MIX_FRAC), 0 = off
+  int32_t release = 0; // Q15 gain per step back to 0dB
+  int32_t gain = 1 << 30; // Q30 gain of the next sample
+  int32_t step = 0; // Q30 gain change per sample
+  int32_t target = 32768; // Q15 gain at the end of the step going out
+  int32_t need = 32768; // Q15 gain the step after the step going out needs
+  int32_t peak = 0; // peak of the step being read
+  uint8_t fill = 0; // samples of the step being read
+  uint8_t half = 0; // half of the delay line of the step being read
+  int32_t delay[2][2 * MAS_LIMIT_STEP] = {}; // left, right
+};
+
+// Computes the coefficients at the sample rate rate, the state is kept.
+// MAS_FILTER_OFF clears the state.
+void MAS_Biquad_Set(MAS_Biquad *filter, const MAS_Filter_Set *set, float rate);
+// Filters len mixer samples in place.
+void MAS_Biquad_Run(MAS_Biquad *filter, int32_t *buf, int len);
+// Filters len 16 bit samples in place, the output is saturated.
+void MAS_Biquad_Run16(MAS_Biquad *filter, int16_t *buf, int len);
+// Runs the filters of a chain of MAS_FILTERS that are not off.
+void MAS_Filter_Chain(MAS_Biquad *chain, int32_t *buf, int len);
+void MAS_Filter_Chain16(MAS_Biquad *chain, int16_t *buf, int len);
+// true if a filter of the chain is not off.
+bool MAS_Filter_Used(const MAS_Biquad *chain);
+// Clears the state of the filters of a chain, the output starts from silence.
+void MAS_Filter_Clear(MAS_Biquad *chain);
+
+// threshold = peak level 1 - 255 (255 = full scale), 0 = off, release = samples back to 0dB.
+// A limiter that was off starts with an empty delay line.
+void MAS_Limiter_Set(MAS_Limiter *limiter, uint8_t threshold, uint32_t release);
+// Limits len samples of the mixer in place, right = NULL for mono.
+void MAS_Limiter_Run(MAS_Limiter *limiter, int32_t *left, int32_t *right, int len);
+#endif
@@ -0,0 +1,201 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*/
+
+#include "MAS_Platform.h"
+#include "MAS_Mixer.h"
+
+//-------------------------------------------------------------------------------saturate
+static inline int16_t saturate(int32_t sample) {
+  sample = sample > 32767 ? 32767 : sample;
+  sample = sample < -32768 ? -32768 : sample;
+  return sample;
+}//                                                                               saturate
+//---------------------------------------------------------------------------quarter sine
+// sin(i * 90 / 64 degrees) in Q15, i = 0 - 64.
+static const int16_t Sin_Q15[65] = {
+  0, 804, 1608, 2410, 3212, 4011, 4808, 5602,
+  6393, 7179, 7962, 8739, 9512, 10278, 11039, 11793,
+  12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+  18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+  23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+  27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+  30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+  32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+  32767
+};
+// Q15 sine of a Q16 index into Sin_Q15, linear between the table values.
+static inline int32_t sin_q15(uint32_t index) {
+  uint32_t i = index >> 16;
+  int32_t frac = (index & 0xFFFF) >> 1;
+  if (i >= 64) {
+    return Sin_Q15[64];
+  }
+  return Sin_Q15[i] + (((Sin_Q15[i + 1] - Sin_Q15[i]) * frac) >> 15);
+}
+
+void MAS_Mix_Clear(int32_t *acc, int len) {
+  for (int i = 0; i < len; i++) {
+    acc[i] = 0;
+  }
+}
+
+bool MAS_Mix_Silent(const int16_t *in, int len, int32_t level) {
+  for (int i = 0; i < len; i++) {
+    if (in[i] > level || in[i] < -level) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void MAS_Mix_Add(int32_t *acc, const int16_t *in, int32_t gain, int len) {
+  //--------------------------------------------------------------------Q15 * Q15 >> 8 = Q22
+  int i = 0;
+  for (; i + 4 <= len; i += 4) {
+    acc[i] += (in[i] * gain) >> (15 - MAS_MIX_FRAC);
+    acc[i + 1] += (in[i + 1] * gain) >> (15 - MAS_MIX_FRAC);
+    acc[i + 2] += (in[i + 2] * gain) >> (15 - MAS_MIX_FRAC);
+    acc[i + 3] += (in[i + 3] * gain) >> (15 - MAS_MIX_FRAC);
+  }
+  for (; i < len; i++) {
+    acc[i] += (in[i] * gain) >> (15 - MAS_MIX_FRAC);
+  }
+}
+
+void MAS_Mix_Ramp(int32_t *acc, const int16_t *in, int32_t gain_from, int32_t gain_to, int len) {
+  //------------------------------------------------------------------------Q30 gain and step
+  int32_t gain = gain_from << 15;
+  int32_t step = (gain_to - gain_from) * 32768 / (len > 0 ? len : 1);
+  int i = 0;
+  for (; i + 4 <= len; i += 4) {
+    acc[i] += (in[i] * (gain >> 15)) >> (15 - MAS_MIX_FRAC);
+    acc[i + 1] += (in[i + 1] * ((gain + step) >> 15)) >> (15 - MAS_MIX_FRAC);
+    acc[i + 2] += (in[i + 2] * ((gain + 2 * step) >> 15)) >> (15 - MAS_MIX_FRAC);
+    acc[i + 3] += (in[i + 3] * ((gain + 3 * step) >> 15)) >> (15 - MAS_MIX_FRAC);
+    gain += 4 * step;
+  }
+  for (; i < len; i++) {
+    acc[i] += (in[i] * (gain >> 15)) >> (15 - MAS_MIX_FRAC);
+    gain += step;
+  }
+}
+
+void MAS_Mix_Bus(int32_t *acc, const int32_t *bus, int32_t gain_from, int32_t gain_to, int len) {
+  //------------------------------------Q30 gain and step, the bus has 23 bit, 64 bit product
+  int32_t gain = gain_from << 15;
+  int32_t step = (gain_to - gain_from) * 32768 / (len > 0 ? len : 1);
+  int i = 0;
+  for (; i + 4 <= len; i += 4) {
+    acc[i] += ((int64_t)bus[i] * (gain >> 15)) >> 15;
+    acc[i + 1] += ((int64_t)bus[i + 1] * ((gain + step) >> 15)) >> 15;
+    acc[i + 2] += ((int64_t)bus[i + 2] * ((gain + 2 * step) >> 15)) >> 15;
+    acc[i + 3] += ((int64_t)bus[i + 3] * ((gain + 3 * step) >> 15)) >> 15;
+    gain += 4 * step;
+  }
+  for (; i < len; i++) {
+    acc[i] += ((int64_t)bus[i] * (gain >> 15)) >> 15;
+    gain += step;
+  }
+}
+
+void MAS_Mix_Out(const int32_t *acc, int16_t *out, int len) {
+  int i = 0;
+  for (; i + 4 <= len; i += 4) {
+    out[i] = saturate(acc[i] >> MAS_MIX_FRAC);
+    out[i + 1] = saturate(acc[i + 1] >> MAS_MIX_FRAC);
+    out[i + 2] = saturate(acc[i + 2] >> MAS_MIX_FRAC);
+    out[i + 3] = saturate(acc[i + 3] >> MAS_MIX_FRAC);
+  }
+  for (; i < len; i++) {
+    out[i] = saturate(acc[i] >> MAS_MIX_FRAC);
+  }
+}
+
+void MAS_Mix_Out_Stereo(const int32_t *first, const int32_t *second, int16_t *out, int len) {
+  int i = 0;
+  for (; i + 2 <= len; i += 2) {
+    out[2 * i] = saturate(first[i] >> MAS_MIX_FRAC);
+    out[2 * i + 1] = saturate(second[i] >> MAS_MIX_FRAC);
+    out[2 * i + 2] = saturate(first[i + 1] >> MAS_MIX_FRAC);
+    out[2 * i + 3] = saturate(second[i + 1] >> MAS_MIX_FRAC);
+  }
+  for (; i < len; i++) {
+    out[2 * i] = saturate(first[i] >> MAS_MIX_FRAC);
+    out[2 * i + 1] = saturate(second[i] >> MAS_MIX_FRAC);
+  }
+}
+
+//-------------------------------------------------------------------------reference kernels
+void MAS_Mix_Add_Ref(int32_t *acc, const int16_t *in, int32_t gain, int len) {
+  for (int i = 0; i < len; i++) {
+    acc[i] += (in[i] * gain) >> (15 - MAS_MIX_FRAC);
+  }
+}
+
+void MAS_Mix_Ramp_Ref(int32_t *acc, const int16_t *in, int32_t gain_from, int32_t gain_to,
+                      int len) {
+  int32_t gain = gain_from << 15;
+  int32_t step = (gain_to - gain_from) * 32768 / (len > 0 ? len : 1);
+  for (int i = 0; i < len; i++) {
+    acc[i] += (in[i] * (gain >> 15)) >> (15 - MAS_MIX_FRAC);
+    gain += step;
+  }
+}
+
+void MAS_Mix_Bus_Ref(int32_t *acc, const int32_t *bus, int32_t gain_from, int32_t gain_to,
+                     int len) {
+  int32_t gain = gain_from << 15;
+  int32_t step = (gain_to - gain_from) * 32768 / (len > 0 ? len : 1);
+  for (int i = 0; i < len; i++) {
+    acc[i] += ((int64_t)bus[i] * (gain >> 15)) >> 15;
+    gain += step;
+  }
+}
+
+void MAS_Mix_Out_Ref(const int32_t *acc, int16_t *out, int len) {
+  for (int i = 0; i < len; i++) {
+    out[i] = saturate(acc[i] >> MAS_MIX_FRAC);
+  }
+}
+
+void MAS_Mix_Out_Stereo_Ref(const int32_t *first, const int32_t *second, int16_t *out, int len) {
+  for (int i = 0; i < len; i++) {
+    out[2 * i] = saturate(first[i] >> MAS_MIX_FRAC);
+    out[2 * i + 1] = saturate(second[i] >> MAS_MIX_FRAC);
+  }
+}//                                                                       reference kernels
+
+void MAS_Pan_Q15(int8_t pan, int32_t *left, int32_t *right) {
+  //-------------------------------------------------------------pan -127 - 127 = 0 - 90 degrees
+  if (pan < -127) {
+    pan = -127;
+  }
+  uint32_t index = (uint32_t)(pan + 127) * (64 << 16) / 254;
+  *left = sin_q15((64 << 16) - index);
+  *right = sin_q15(index);
+}
+
+void MAS_Mix_Fade(int16_t *in, const int16_t *out, uint32_t pos, uint32_t fade_len, int len) {
+  //------------------------------------------------------------Q16 table index of 90 degrees
+  int32_t index_step = (64 << 16) / (fade_len > 0 ? fade_len : 1);
+  MAS_Mix_Blend(in, out, pos < fade_len ? pos * index_step : 64 << 16, index_step, len);
+}
+
+void MAS_Mix_Blend(int16_t *in, const int16_t *out, int32_t index, int32_t index_step, int len) {
+  for (int i = 0; i < len; i++) {
+    index = index < 0 ? 0 : index > (64 << 16) ? 64 << 16 : index;
+    int32_t sum = in[i] * sin_q15(index) + out[i] * sin_q15((64 << 16) - index);
+    in[i] = saturate(sum >> 15);
+    index += index_step;
+  }
+}
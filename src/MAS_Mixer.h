@@ -0,0 +1,79 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Mixing kernel of the ESP32_MAS.
+
+  Gains are Q15 fixed point, 32768 = 0dB. The channels are summed into a 32 bit accumulator
+  with MAS_MIX_FRAC extra fraction bits, so 127 channels at full scale can not overflow.
+  MAS_Mix_Out saturates the accumulator to 16 bit and writes the I2S buffer directly.
+  The loops have no branches and are unrolled by 4 for the Xtensa pipeline,
+  GCC vectorizes them on other targets.
+  Every kernel with an unrolled loop has a scalar reference MAS_Mix_<name>_Ref, one sample per
+  loop as the definition of its result. extras/MAS_Test/Test_Mixer checks that both give the
+  same bits, MAS_Bench reports both as kernel/<name> and kernel/<name>_ref.
+  The 128 bit SIMD (PIE) of the ESP32-S3 is not used: the library builds for the ESP32 (LX6)
+  where it does not exist, and it needs 16 byte aligned blocks and inline assembly.
+  The unrolled loops are the fast path on every target.
+  -------------------------------------------------------------------------------------------*/
+#ifndef _MAS_MIXER_
+#define _MAS_MIXER_
+#include "MAS_Platform.h"
+
+#define MAS_MIX_FRAC 7 // fraction bits of the accumulator below one 16 bit step
+#ifndef MAS_SILENCE
+#define MAS_SILENCE 0 // a channel block with no sample louder is not mixed, 0 = exact zeros
+#endif
+
+// Q15 gain of a channel gain or volume, 0 = mute, 255 = 0dB.
+static inline int32_t MAS_Gain_Q15(uint8_t gain) {
+  return (gain * 32768 + 127) / 255;
+}
+// Q15 product of two Q15 gains.
+static inline int32_t MAS_Gain_Mul(int32_t a, int32_t b) {
+  return (a * b + 16384) >> 15;
+}
+
+// Sets len samples of the accumulator to 0.
+void MAS_Mix_Clear(int32_t *acc, int len);
+// true if no sample is louder than level. Stops at the first louder sample.
+bool MAS_Mix_Silent(const int16_t *in, int len, int32_t level);
+// Adds len samples multiplied by the Q15 gain to the accumulator.
+void MAS_Mix_Add(int32_t *acc, const int16_t *in, int32_t gain, int len);
+// Like MAS_Mix_Add with a Q15 gain that moves linearly from gain_from to gain_to,
+// gain_to is the gain of the sample after the last.
+void MAS_Mix_Ramp(int32_t *acc, const int16_t *in, int32_t gain_from, int32_t gain_to, int len);
+// Adds len samples of a bus accumulator multiplied by a Q15 gain that moves linearly from
+// gain_from to gain_to to the accumulator.
+void MAS_Mix_Bus(int32_t *acc, const int32_t *bus, int32_t gain_from, int32_t gain_to, int len);
+// Writes len saturated 16 bit samples of the accumulator to out.
+void MAS_Mix_Out(const int32_t *acc, int16_t *out, int len);
+// Writes len interleaved stereo frames of the accumulators first, second to out.
+void MAS_Mix_Out_Stereo(const int32_t *first, const int32_t *second, int16_t *out, int len);
+//---------------------------------------------------------------------reference kernels
+void MAS_Mix_Add_Ref(int32_t *acc, const int16_t *in, int32_t gain, int len);
+void MAS_Mix_Ramp_Ref(int32_t *acc, const int16_t *in, int32_t gain_from, int32_t gain_to,
+                      int len);
+void MAS_Mix_Bus_Ref(int32_t *acc, const int32_t *bus, int32_t gain_from, int32_t gain_to,
+                     int len);
+void MAS_Mix_Out_Ref(const int32_t *acc, int16_t *out, int len);
+void MAS_Mix_Out_Stereo_Ref(const int32_t *first, const int32_t *second, int16_t *out, int len);
+//                                                                      reference kernels
+// Constant power Q15 gains of pan -127 = left, 0 = center (-3dB), 127 = right.
+void MAS_Pan_Q15(int8_t pan, int32_t *left, int32_t *right);
+// Equal power crossfade of sample pos - pos + len - 1 of a crossfade of fade_len samples:
+// in fades in with sin, out fades out with cos, the sum is written to in.
+void MAS_Mix_Fade(int16_t *in, const int16_t *out, uint32_t pos, uint32_t fade_len, int len);
+// Equal power blend of len samples: in is weighted with sin, out with cos of the Q16 index
+// 0 - 64 << 16 (0 - 90 degrees), the index moves by index_step per sample.
+void MAS_Mix_Blend(int16_t *in, const int16_t *out, int32_t index, int32_t index_step, int len);
+#endif
@@ -0,0 +1,377 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*/
+
+#include "MAS_Platform.h"
+#ifdef ARDUINO
+#include "esp_task.h"
+#include "esp_partition.h"
+#include "SPIFFS.h"
+#else
+#include <chrono>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#ifdef ARDUINO
+//===================================================================================ESP32
+static fs::FS *MAS_FS = &SPIFFS;
+
+void MAS_Set_FS(fs::FS *fs) {
+  MAS_FS = fs;
+}
+//-------------------------------------------------------------------------------file source
+bool MAS_File::open(const char *name) {
+  Handle = MAS_FS->open(name, "r");
+  return Handle;
+}
+int MAS_File::read(uint8_t *buf, int len) {
+  return Handle.read(buf, len);
+}
+bool MAS_File::seek(uint32_t pos) {
+  return Handle.seek(pos);
+}
+uint32_t MAS_File::size() {
+  return Handle.size();
+}
+void MAS_File::close() {
+  Handle.close();
+}
+MAS_File::operator bool() const {
+  return Handle;
+}
+//-----------------------------------------------------------------------------mapped image
+const uint8_t *MAS_Map(const char *name, uint32_t *size) {
+  const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                     ESP_PARTITION_SUBTYPE_ANY, name);
+  const void *data = NULL;
+  spi_flash_mmap_handle_t handle;
+  if (partition == NULL || esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA,
+      &data, &handle) != ESP_OK) {
+    return NULL;
+  }
+  *size = partition->size;
+  return (const uint8_t*)data;
+}
+//-------------------------------------------------------------------------------I2S output
+bool MAS_I2S_Output::begin(uint32_t rate, uint16_t block, uint8_t count, uint8_t channels) {
+  i2s_channel_fmt_t format = channels == 2 ? I2S_CHANNEL_FMT_RIGHT_LEFT :
+                             I2S_CHANNEL_FMT_ONLY_RIGHT;
+  //--------------------------------------------------------------------------I2S-interlal DAC
+  i2s_config_t i2s_config_noDAC = {
+    .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX | I2S_MODE_DAC_BUILT_IN),
+    .sample_rate = (int)rate,
+    .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
+    .channel_format = format,
+    .communication_format = (i2s_comm_format_t)(I2S_COMM_FORMAT_I2S | I2S_COMM_FORMAT_I2S_MSB),
+    .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
+    .dma_buf_count = count,
+    .dma_buf_len = block,
+    .use_apll  =  true
+  };
+  //----------------------------------------------------------------------------I2S-extern DAC
+  i2s_config_t i2s_config_DAC = {
+    .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX),
+    .sample_rate = (int)rate,
+    .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
+    .channel_format = format,
+    .communication_format = (i2s_comm_format_t)(I2S_COMM_FORMAT_I2S | I2S_COMM_FORMAT_I2S_MSB),
+    .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
+    .dma_buf_count = count,
+    .dma_buf_len = block,
+    .use_apll  =  true
+  };
+  //-----------------------------------------------------------------------------I2S-pin-config
+  i2s_pin_config_t pin_config = {
+    .bck_io_num = (int)bck,
+    .ws_io_num = (int)ws,
+    .data_out_num = (int)data,
+    .data_in_num = I2S_PIN_NO_CHANGE
+  };
+  //-----------------------------------------------------------------------------------open I2S
+  if (internal_dac) {
+    i2s_driver_install((i2s_port_t)port, &i2s_config_noDAC, count, &Queue);
+  }
+  else {
+    i2s_driver_install((i2s_port_t)port, &i2s_config_DAC, count, &Queue);
+  }
+  i2s_set_pin((i2s_port_t)port, &pin_config);
+  Timeout = (uint32_t)block * count * 1000 / rate / portTICK_PERIOD_MS + 2;
+  i2s_zero_dma_buffer((i2s_port_t)port);
+  Serial.print("RUN I2S ON PORT_NUM: ");
+  Serial.println(port);
+  return true;
+}
+uint8_t MAS_I2S_Output::wait() {
+  //-------------------------------------------------------every sent DMA buffer is a TX_DONE
+  i2s_event_t event;
+  while (xQueueReceive(Queue, &event, portMAX_DELAY) != pdTRUE ||
+         event.type != I2S_EVENT_TX_DONE) {
+  }
+  // More sent buffers are waiting if the player was late, they wake the next blocks at once.
+  return uxQueueMessagesWaiting(Queue);
+}
+bool MAS_I2S_Output::write(const int16_t *buf, uint16_t len) {
+  size_t written = 0;
+  return i2s_write((i2s_port_t)port, buf, len * sizeof(int16_t), &written, Timeout) == ESP_OK &&
+         written == len * sizeof(int16_t);
+}
+void MAS_I2S_Output::idle(bool on) {
+  //--------------------------------the DMA sends zeros and stops, no TX_DONE while stopped
+  if (on) {
+    i2s_zero_dma_buffer((i2s_port_t)port);
+    i2s_stop((i2s_port_t)port);
+  }
+  else {
+    xQueueReset(Queue);
+    i2s_start((i2s_port_t)port);
+  }
+}
+void MAS_I2S_Output::end() {
+  i2s_driver_uninstall((i2s_port_t)port);
+  Queue = NULL;
+}
+//-------------------------------------------------------------------------------task runner
+void MAS_Start_Task(MAS_Task_Function function, const char *name, uint32_t stack, void *arg,
+                    uint8_t priority, uint8_t core) {
+  xTaskCreatePinnedToCore(function, name, stack, arg, priority, NULL, core);
+}
+void MAS_End_Task() {
+  vTaskDelete(NULL);
+}
+void MAS_Sleep(uint32_t ms) {
+  vTaskDelay(ms / portTICK_PERIOD_MS > 0 ? ms / portTICK_PERIOD_MS : 1);
+}
+uint32_t MAS_Micros() {
+  return micros();
+}
+uint32_t MAS_Cycles() {
+  return ESP.getCycleCount();
+}
+uint32_t MAS_Cycle_Rate() {
+  return ESP.getCpuFreqMHz() * 1000000;
+}
+void *MAS_Alloc_Large(size_t size) {
+  if (psramFound()) {
+    return ps_malloc(size);
+  }
+  return malloc(size);
+}
+void MAS_Log(const char *text) {
+  Serial.println(text);
+}
+//------------------------------------------------------------------------------------signal
+MAS_Signal::MAS_Signal() {
+  Handle = xSemaphoreCreateBinary();
+}
+MAS_Signal::~MAS_Signal() {
+  vSemaphoreDelete(Handle);
+}
+void MAS_Signal::give() {
+  xSemaphoreGive(Handle);
+}
+void MAS_Signal::take(uint32_t ms) {
+  xSemaphoreTake(Handle, ms / portTICK_PERIOD_MS > 0 ? ms / portTICK_PERIOD_MS : 1);
+}
+#else
+//====================================================================================HOST
+static std::string MAS_Root = ".";
+
+void MAS_Set_Root(const char *root) {
+  MAS_Root = root;
+}
+//-------------------------------------------------------------------------------file source
+bool MAS_File::open(const char *name) {
+  close();
+  Handle = fopen((MAS_Root + "/" + name).c_str(), "rb");
+  return Handle != NULL;
+}
+int MAS_File::read(uint8_t *buf, int len) {
+  return Handle != NULL ? fread(buf, 1, len, Handle) : 0;
+}
+bool MAS_File::seek(uint32_t pos) {
+  return Handle != NULL && fseek(Handle, pos, SEEK_SET) == 0;
+}
+uint32_t MAS_File::size() {
+  if (Handle == NULL) {
+    return 0;
+  }
+  long pos = ftell(Handle);
+  fseek(Handle, 0, SEEK_END);
+  long len = ftell(Handle);
+  fseek(Handle, pos, SEEK_SET);
+  return len;
+}
+void MAS_File::close() {
+  if (Handle != NULL) {
+    fclose(Handle);
+    Handle = NULL;
+  }
+}
+MAS_File::operator bool() const {
+  return Handle != NULL;
+}
+//-----------------------------------------------------------------------------mapped image
+const uint8_t *MAS_Map(const char *name, uint32_t *size) {
+  struct stat info;
+  void *data = MAP_FAILED;
+  int handle = open((MAS_Root + "/" + name).c_str(), O_RDONLY);
+  if (handle < 0) {
+    return NULL;
+  }
+  if (fstat(handle, &info) == 0 && info.st_size > 0) {
+    data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, handle, 0);
+  }
+  close(handle);
+  if (data == MAP_FAILED) {
+    return NULL;
+  }
+  *size = info.st_size;
+  return (const uint8_t*)data;
+}
+//------------------------------------------------------------------------------WAVE output
+static void put32(uint8_t *b, uint32_t v) {
+  b[0] = v;
+  b[1] = v >> 8;
+  b[2] = v >> 16;
+  b[3] = v >> 24;
+}
+static void put16(uint8_t *b, uint16_t v) {
+  b[0] = v;
+  b[1] = v >> 8;
+}
+MAS_WAV_Output::~MAS_WAV_Output() {
+  end();
+}
+bool MAS_WAV_Output::begin(uint32_t rate, uint16_t block, uint8_t count, uint8_t channels) {
+  end();
+  Handle = fopen(Name.c_str(), "wb");
+  Rate = rate;
+  Channels = channels;
+  Samples = 0;
+  return Handle != NULL && header();
+}
+uint8_t MAS_WAV_Output::wait() {
+  return 0;
+}
+bool MAS_WAV_Output::write(const int16_t *buf, uint16_t len) {
+  uint8_t data[2 * MAS_WAV_CHUNK]; // a block of the player is one chunk
+  bool done = Handle != NULL;
+  for (int pos = 0; pos < len && done; pos += MAS_WAV_CHUNK) {
+    //------------------------------------------------------------samples, little endian
+    int count = len - pos < MAS_WAV_CHUNK ? len - pos : MAS_WAV_CHUNK;
+    for (int i = 0; i < count; i++) {
+      put16(data + 2 * i, buf[pos + i]);
+    }
+    done = fwrite(data, 2, count, Handle) == (size_t)count;
+    Samples += done ? count : 0;
+  }
+  return done;
+}
+void MAS_WAV_Output::end() {
+  if (Handle != NULL) {
+    header();
+    fclose(Handle);
+    Handle = NULL;
+  }
+}
+bool MAS_WAV_Output::header() {
+  //----------------------------------------------------------------------------------header
+  uint8_t head[44];
+  memcpy(head, "RIFF", 4);
+  put32(head + 4, 36 + Samples * 2);
+  memcpy(head + 8, "WAVEfmt ", 8);
+  put32(head + 16, 16);
+  put16(head + 20, 1); // PCM
+  put16(head + 22, Channels);
+  put32(head + 24, Rate);
+  put32(head + 28, Rate * 2 * Channels);
+  put16(head + 32, 2 * Channels);
+  put16(head + 34, 16);
+  memcpy(head + 36, "data", 4);
+  put32(head + 40, Samples * 2);
+  fseek(Handle, 0, SEEK_SET);
+  bool done = fwrite(head, 1, 44, Handle) == 44;
+  fseek(Handle, 0, SEEK_END);
+  return done;
+}
+//-------------------------------------------------------------------------------task runner
+void MAS_Start_Task(MAS_Task_Function function, const char *name, uint32_t stack, void *arg,
+                    uint8_t priority, uint8_t core) {
+  std::thread(function, arg).detach();
+}
+void MAS_End_Task() {
+  // the thread ends when the task function returns
+}
+void MAS_Sleep(uint32_t ms) {
+  usleep(ms * 1000);
+}
+uint32_t MAS_Micros() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000ull + now.tv_nsec / 1000;
+}
+uint32_t MAS_Cycles() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+uint32_t MAS_Cycle_Rate() {
+  return 1000000000;
+}
+void *MAS_Alloc_Large(size_t size) {
+  return malloc(size);
+}
+void MAS_Log(const char *text) {
+  fprintf(stderr, "%s\n", text);
+}
+//------------------------------------------------------------------------------------signal
+MAS_Signal::MAS_Signal() {
+}
+MAS_Signal::~MAS_Signal() {
+}
+void MAS_Signal::give() {
+  std::lock_guard<std::mutex> lock(Lock);
+  Given = true;
+  Wake.notify_one();
+}
+void MAS_Signal::take(uint32_t ms) {
+  std::unique_lock<std::mutex> lock(Lock);
+  Wake.wait_for(lock, std::chrono::milliseconds(ms), [this]() {
+    return Given;
+  });
+  Given = false;
+}
+#endif
+
+//-------------------------------------------------------------------------------RAM output
+bool MAS_Memory_Output::begin(uint32_t rate, uint16_t block, uint8_t count, uint8_t channels) {
+  Pos = 0;
+  return true;
+}
+uint8_t MAS_Memory_Output::wait() {
+  return 0;
+}
+bool MAS_Memory_Output::write(const int16_t *buf, uint16_t len) {
+  int i = 0;
+  for (; i < len && Pos < Len; i++) {
+    Buf[Pos++] = buf[i];
+  }
+  return i == len;
+}
+uint32_t MAS_Memory_Output::written() {
+  return Pos;
+}
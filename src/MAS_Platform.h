@@ -0,0 +1,212 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Platform of the ESP32_MAS.
+
+  Everything the sound system needs from the ESP32 is in this file:
+  MAS_File     file source, SPIFFS (or the fs::FS of MAS_Set_FS) on the ESP32,
+               the directory of MAS_Set_Root on the host
+  MAS_Output   output sink, MAS_I2S_Output on the ESP32, MAS_Memory_Output and
+               MAS_WAV_Output (host only) write to RAM or to a WAVE file
+  MAS_Map      read only image of a sound bank, a data partition mapped by esp_partition_mmap
+               on the ESP32, a file mapped by mmap on the host
+  MAS_Start_Task, MAS_End_Task, MAS_Sleep, MAS_Micros, MAS_Alloc_Large, MAS_Log
+               task runner, FreeRTOS on the ESP32, std::thread on the host
+  MAS_Signal   wakes a sleeping task, a semaphore on the ESP32, a condition variable on the host
+  Without ARDUINO the library builds as a plain host library, for example on Linux:
+  g++ -O2 -pthread -I src src/ESP32_MAS.cpp src/MAS_Bank.cpp src/MAS_Decoder.cpp
+      src/MAS_Engine.cpp src/MAS_Filter.cpp src/MAS_Mixer.cpp src/MAS_Platform.cpp
+      src/MAS_Ramp.cpp your_program.cpp
+  -------------------------------------------------------------------------------------------*/
+#ifndef _MAS_PLATFORM_
+#define _MAS_PLATFORM_
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <FS.h>
+#include "driver/i2s.h"
+#include "freertos/semphr.h"
+#else
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+//----------------------------------------------------------------String of the host library
+// The part of the Arduino String used by the class methods.
+class String {
+  public:
+    String() {};
+    String(const char *text) : Text(text) {};
+    bool operator==(const String &other) const {
+      return Text == other.Text;
+    };
+    const char *c_str() const {
+      return Text.c_str();
+    };
+    unsigned int length() const {
+      return Text.length();
+    };
+  private:
+    std::string Text;
+};
+#endif
+
+//-------------------------------------------------------------------------------file source
+class MAS_File {
+  public:
+    bool open(const char *name); // opens the file to read
+    int read(uint8_t *buf, int len); // returns the bytes read
+    bool seek(uint32_t pos);
+    uint32_t size();
+    void close();
+    operator bool() const;
+  private:
+#ifdef ARDUINO
+    File Handle;
+#else
+    FILE *Handle = NULL;
+#endif
+};
+#ifdef ARDUINO
+void MAS_Set_FS(fs::FS *fs); // file system of MAS_File, default SPIFFS
+#else
+void MAS_Set_Root(const char *root); // directory of the file names, default "."
+#endif
+
+//-----------------------------------------------------------------------------mapped image
+// Maps a read only image: the data partition with the label name on the ESP32, the file name
+// in the directory of MAS_Set_Root on the host. The image stays mapped.
+// Returns NULL if there is no such image, size = bytes of the image.
+const uint8_t *MAS_Map(const char *name, uint32_t *size);
+
+//-------------------------------------------------------------------------------output sink
+class MAS_Output {
+  public:
+    // Called once by the audio player. block = frames per write, count = buffers,
+    // channels = 1 mono, 2 stereo.
+    virtual bool begin(uint32_t rate, uint16_t block, uint8_t count, uint8_t channels) = 0;
+    // Sleeps until the output can take the next block. Offline outputs return at once.
+    // Returns the blocks the output sent while the player was late, 0 = in time.
+    virtual uint8_t wait() = 0;
+    // len = samples, a stereo frame is left, right (right, left with right_first).
+    // false = the output did not take the whole block.
+    virtual bool write(const int16_t *buf, uint16_t len) = 0;
+    // on = true: the player has nothing to play and sleeps until the next command,
+    // the output stops after silence. on = false: the player renders again, wait follows.
+    virtual void idle(bool on) {};
+    // Called once by the audio player task when the sound system is destroyed.
+    virtual void end() {};
+    bool right_first = false; // the output sends the second sample of a frame left
+};
+
+#ifdef ARDUINO
+//----------------------------------------------------------------------------I2S output
+// Waits on the event queue of the I2S driver for a sent DMA buffer.
+// In 16 bit stereo the I2S of the ESP32 sends the high half of a 32 bit word first,
+// so the frames in memory are right, left.
+class MAS_I2S_Output : public MAS_Output {
+  public:
+    MAS_I2S_Output() {
+      right_first = true;
+    };
+    bool begin(uint32_t rate, uint16_t block, uint8_t count, uint8_t channels);
+    uint8_t wait();
+    bool write(const int16_t *buf, uint16_t len);
+    void idle(bool on);
+    void end();
+    uint8_t port = 0; // PORT NUM
+    uint8_t bck = 26; // BCK
+    uint8_t ws = 25; // WS
+    uint8_t data = 22; // DATA
+    bool internal_dac = false; // output on the internal DAC
+  private:
+    QueueHandle_t Queue = NULL;
+    TickType_t Timeout = portMAX_DELAY; // ticks of all DMA buffers, the longest write
+};
+#endif
+
+//-------------------------------------------------------------------------------RAM output
+// Writes the samples to a buffer, samples behind the end of the buffer are dropped.
+class MAS_Memory_Output : public MAS_Output {
+  public:
+    MAS_Memory_Output(int16_t *buf, uint32_t len) : Buf(buf), Len(len) {};
+    bool begin(uint32_t rate, uint16_t block, uint8_t count, uint8_t channels);
+    uint8_t wait();
+    bool write(const int16_t *buf, uint16_t len);
+    uint32_t written(); // samples in the buffer
+  private:
+    int16_t *Buf;
+    uint32_t Len;
+    uint32_t Pos = 0;
+};
+
+#ifndef ARDUINO
+//------------------------------------------------------------------------------WAVE output
+#define MAS_WAV_CHUNK 2048 // samples of one fwrite, a stereo block of 1024 frames
+// Writes a WAVE file PCM 16 bit mono or stereo, one fwrite per block. The lengths of the
+// header are written by end, called by the player task, or by the destructor.
+class MAS_WAV_Output : public MAS_Output {
+  public:
+    MAS_WAV_Output(const char *name) : Name(name) {};
+    ~MAS_WAV_Output();
+    bool begin(uint32_t rate, uint16_t block, uint8_t count, uint8_t channels);
+    uint8_t wait();
+    bool write(const int16_t *buf, uint16_t len);
+    void end(); // completes and closes the file, renderOffline does not call it
+  private:
+    bool header();
+    std::string Name;
+    FILE *Handle = NULL;
+    uint32_t Rate = 22050;
+    uint8_t Channels = 1;
+    uint32_t Samples = 0;
+};
+#endif
+
+//-------------------------------------------------------------------------------task runner
+typedef void (*MAS_Task_Function)(void *arg);
+// core = core of the task on the ESP32, not used on the host.
+void MAS_Start_Task(MAS_Task_Function function, const char *name, uint32_t stack, void *arg,
+                    uint8_t priority, uint8_t core);
+// Ends the calling task, a task function calls it instead of returning.
+void MAS_End_Task();
+void MAS_Sleep(uint32_t ms);
+uint32_t MAS_Micros();
+// Cycle counter for the statistics: CPU cycles on the ESP32, ns on the host. It wraps around.
+uint32_t MAS_Cycles();
+uint32_t MAS_Cycle_Rate(); // counts per second of MAS_Cycles
+void *MAS_Alloc_Large(size_t size); // PSRAM if available, released by free
+void MAS_Log(const char *text);
+
+//------------------------------------------------------------------------------------signal
+// Binary semaphore, FreeRTOS on the ESP32, mutex and condition variable on the host.
+// A give without a waiting task is kept for the next take.
+class MAS_Signal {
+  public:
+    MAS_Signal();
+    ~MAS_Signal();
+    void give(); // from any task, does not block
+    void take(uint32_t ms); // sleeps until a give, at most ms
+  private:
+#ifdef ARDUINO
+    SemaphoreHandle_t Handle;
+#else
+    std::mutex Lock;
+    std::condition_variable Wake;
+    bool Given = false;
+#endif
+};
+#endif
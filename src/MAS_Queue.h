@@ -0,0 +1,139 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Queues between the class methods (core 1) and the task "Audio_Player" (core 0).
+
+  MAS_Queue is a single producer single consumer ring of SIZE items (power of 2) without locks.
+  head and tail count the items since start and only grow, the ring index is count & (SIZE - 1).
+  Commands go from the class methods to the player, events from the player to the class.
+  The player takes all commands at the start of every audio block, timed commands wait in the
+  schedule of the player until the block of their sample clock.
+  -------------------------------------------------------------------------------------------*/
+#ifndef _MAS_QUEUE_
+#define _MAS_QUEUE_
+#include "MAS_Platform.h"
+#include "MAS_Bank.h"
+#include "MAS_Filter.h"
+
+#ifndef MAS_NAME_SIZE
+#define MAS_NAME_SIZE 32 // bytes of a file name with path and 0
+#endif
+#ifndef MAS_COMMAND_SIZE
+#define MAS_COMMAND_SIZE 64 // commands in the queue, power of 2
+#endif
+#ifndef MAS_EVENT_SIZE
+#define MAS_EVENT_SIZE 32 // events in the queue, power of 2
+#endif
+
+//-----------------------------------------------------------------------------command types
+// 0 - 5 set the channel state and are equal to it.
+#define MAS_CMD_STOP 0
+#define MAS_CMD_BRAKE 1
+#define MAS_CMD_PLAY 2 // file, sound, cache_slot, restart, value 1 = queue the file
+#define MAS_CMD_LOOP 3 // file, sound, cache_slot, restart, value 1 = queue the file
+#define MAS_CMD_RUN 4
+#define MAS_CMD_OUT 5
+#define MAS_CMD_GAIN 6 // value, time[0] = samples of the ramp
+#define MAS_CMD_PITCH 7 // pitch, time[0] = samples of the ramp
+#define MAS_CMD_VOLUME 8 // value, time[0] = samples of the ramp, channel is not used
+#define MAS_CMD_INTERPOLATION 9 // value, channel is not used
+#define MAS_CMD_CROSSFADE 10 // value
+#define MAS_CMD_LAYER 11 // sound, cache_slot, value = rpm of the recording, no sound = clear
+#define MAS_CMD_RPM 12 // value
+#define MAS_CMD_ENGINE 13 // drops the files and starts the engine voice
+#define MAS_CMD_ENVELOPE 14 // value = sustain, time = samples of attack, decay, release
+#define MAS_CMD_RELEASE 15 // starts the release of the envelope
+#define MAS_CMD_PAN 16 // value = (uint8_t)pan
+#define MAS_CMD_BUS 17 // value = bus of the channel
+#define MAS_CMD_BUS_GAIN 18 // value = bus << 8 | gain, time[0] = samples of the ramp
+#define MAS_CMD_FILTER 19 // filter of the channel
+#define MAS_CMD_BUS_FILTER 20 // filter, value = bus, channel is not used
+#define MAS_CMD_MASTER_FILTER 21 // filter, channel is not used
+#define MAS_CMD_LIMITER 22 // value = threshold, time[0] = samples of the release
+
+struct MAS_Command {
+  uint8_t type = MAS_CMD_STOP;
+  uint8_t channel = 0;
+  uint16_t value = 0;
+  int8_t cache_slot = -1; // -1 = not in the sample cache
+  bool restart = false; // drop the played file
+  MAS_Sound sound; // samples in the cache or the sound bank, no data = SPIFFS
+  float pitch = 0;
+  uint32_t time[3] = {}; // samples of a ramp or an envelope
+  MAS_Filter_Set filter; // parameters of a filter
+  bool timed = false; // takes effect at the sample clock at
+  uint32_t at = 0; // sample clock of a timed command
+  char file[MAS_NAME_SIZE] = {};
+};
+
+struct MAS_Event {
+  uint8_t channel = 0;
+  uint8_t state = 0; // new state of the channel
+};
+
+//---------------------------------------------------------------------------------SPSC queue
+template <typename T, uint32_t SIZE>
+class MAS_Queue {
+  public:
+    // Producer only. false = queue is full.
+    bool push(const T &item) {
+      uint32_t head = Head;
+      if (head - Tail >= SIZE) {
+        return false;
+      }
+      Items[head & (SIZE - 1)] = item;
+      __sync_synchronize();
+      Head = head + 1;
+      return true;
+    };
+    // Producer only. Pushes all items or none, the consumer sees them at once.
+    // false = not enough room.
+    bool push(const T *items, uint32_t count) {
+      uint32_t head = Head;
+      if (SIZE - (head - Tail) < count) {
+        return false;
+      }
+      for (uint32_t i = 0; i < count; i++) {
+        Items[(head + i) & (SIZE - 1)] = items[i];
+      }
+      __sync_synchronize();
+      Head = head + count;
+      return true;
+    };
+    // Consumer only. false = queue is empty.
+    bool pop(T *item) {
+      uint32_t tail = Tail;
+      if (tail == Head) {
+        return false;
+      }
+      __sync_synchronize();
+      *item = Items[tail & (SIZE - 1)];
+      __sync_synchronize();
+      Tail = tail + 1;
+      return true;
+    };
+    uint32_t pushed() {
+      return Head;
+    };
+    uint32_t popped() {
+      return Tail;
+    };
+  private:
+    T Items[SIZE];
+    volatile uint32_t Head = 0;
+    volatile uint32_t Tail = 0;
+};
+
+typedef MAS_Queue<MAS_Command, MAS_COMMAND_SIZE> MAS_Command_Queue;
+typedef MAS_Queue<MAS_Event, MAS_EVENT_SIZE> MAS_Event_Queue;
+#endif
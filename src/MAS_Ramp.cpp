@@ -0,0 +1,77 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*/
+
+#include "MAS_Platform.h"
+#include "MAS_Ramp.h"
+
+void MAS_Ramp_Set(MAS_Ramp *ramp, int32_t target, uint32_t samples) {
+  ramp->target = target;
+  ramp->left = samples;
+  if (samples == 0) {
+    ramp->value = target;
+  }
+}
+
+int32_t MAS_Ramp_Next(MAS_Ramp *ramp, uint32_t len) {
+  if (len >= ramp->left) {
+    ramp->value = ramp->target;
+    ramp->left = 0;
+  }
+  else {
+    ramp->value += (int64_t)(ramp->target - ramp->value) * len / ramp->left;
+    ramp->left -= len;
+  }
+  return ramp->value;
+}
+
+void MAS_Envelope_Init(MAS_Envelope *env) {
+  env->stage = MAS_ENV_SUSTAIN;
+  MAS_Ramp_Set(&env->level, 32768, 0);
+}
+
+void MAS_Envelope_Start(MAS_Envelope *env) {
+  env->stage = MAS_ENV_ATTACK;
+  env->level.value = 0;
+  MAS_Ramp_Set(&env->level, 32768, env->attack);
+}
+
+void MAS_Envelope_Release(MAS_Envelope *env) {
+  env->stage = MAS_ENV_RELEASE;
+  MAS_Ramp_Set(&env->level, 0, env->release);
+}
+//-----------------------------------------------------------------------------envelope next
+int32_t MAS_Envelope_Next(MAS_Envelope *env, uint32_t len) {
+  while (true) {
+    //---------------------------------------------------------the stage ends within the block
+    uint32_t used = len < env->level.left ? len : env->level.left;
+    MAS_Ramp_Next(&env->level, used);
+    len -= used;
+    if (env->level.left > 0) {
+      break;
+    }
+    if (env->stage == MAS_ENV_ATTACK) {
+      env->stage = MAS_ENV_DECAY;
+      MAS_Ramp_Set(&env->level, env->sustain, env->decay);
+    }
+    else if (env->stage == MAS_ENV_DECAY) {
+      env->stage = MAS_ENV_SUSTAIN;
+    }
+    else if (env->stage == MAS_ENV_RELEASE) {
+      env->stage = MAS_ENV_END;
+    }
+    else {
+      break;
+    }
+  }
+  return env->level.value;
+}//                                                                             envelope next
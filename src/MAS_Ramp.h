@@ -0,0 +1,60 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Parameter ramps and envelopes of the ESP32_MAS.
+
+  A ramp moves a fixed point value linearly to a target over a number of samples. The player
+  advances the ramps once per audio block, the mixer interpolates the gain between the values
+  at the start and the end of the block (see MAS_Mix_Ramp), so a change does not step.
+  An envelope ramps the Q15 level of a channel: attack from 0 to 0dB, decay to the sustain
+  level, release from the sustain level to 0. It starts with every file that starts a channel.
+  -------------------------------------------------------------------------------------------*/
+#ifndef _MAS_RAMP_
+#define _MAS_RAMP_
+#include "MAS_Platform.h"
+
+//---------------------------------------------------------------------------------envelope stages
+#define MAS_ENV_ATTACK 0
+#define MAS_ENV_DECAY 1
+#define MAS_ENV_SUSTAIN 2
+#define MAS_ENV_RELEASE 3
+#define MAS_ENV_END 4 // the release reached 0, the player stops the channel
+
+struct MAS_Ramp {
+  int32_t value = 0; // value at the end of the last block
+  int32_t target = 0;
+  uint32_t left = 0; // samples until the target
+};
+
+struct MAS_Envelope {
+  uint32_t attack = 0; // samples
+  uint32_t decay = 0; // samples
+  int32_t sustain = 32768; // Q15 level
+  uint32_t release = 0; // samples
+  uint8_t stage = MAS_ENV_SUSTAIN;
+  MAS_Ramp level; // Q15
+};
+
+// Sets value at once (samples = 0) or ramps from the current value over samples.
+void MAS_Ramp_Set(MAS_Ramp *ramp, int32_t target, uint32_t samples);
+// Moves the ramp by len samples and returns the new value.
+int32_t MAS_Ramp_Next(MAS_Ramp *ramp, uint32_t len);
+// Sets the level to 0dB without envelope.
+void MAS_Envelope_Init(MAS_Envelope *env);
+// Starts the attack from 0, without attack the level jumps to 0dB.
+void MAS_Envelope_Start(MAS_Envelope *env);
+// Starts the release from the current level.
+void MAS_Envelope_Release(MAS_Envelope *env);
+// Moves the envelope by len samples through its stages and returns the Q15 level.
+int32_t MAS_Envelope_Next(MAS_Envelope *env, uint32_t len);
+#endif
@@ -0,0 +1,91 @@
+/*Copyright (C) 2018  Johannes Schreiner Otterthal AUSTRIA
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.
+  If not, see <http://www.gnu.org/licenses/>.*
+  ---------------------------------------------------------------------------------------------
+  Resampler of the ESP32_MAS.
+
+  The position in a file is a phase accumulator: the integer sample and a Q16 fraction.
+  Every output sample adds the Q16 step (1 + pitch) * file rate / 22050 to the phase.
+  The output sample is interpolated between x1 (the sample at the position) and x2 (the
+  next sample), x0 and x3 are the neighbours for the cubic mode.
+  Modes (ESP32_MAS.setInterpolation):
+  0 = NONE    sample at the position, cheapest, aliasing at high pitch
+  1 = LINEAR  linear between x1 and x2 (default)
+  2 = CUBIC   4 point Catmull-Rom spline, float math
+  3 = BOX     band limited for steps above 1: the mean of the samples the position passes
+              over the step, each weighted by the part of the step it covers (a box filter as
+              wide as the step, its zeros lie on the output rate and its multiples, the tones
+              that alias are damped). Up to step 1 LINEAR. The output is half an output
+              sample later than LINEAR. Engine voices use LINEAR.
+  -------------------------------------------------------------------------------------------*/
+#ifndef _MAS_RESAMPLER_
+#define _MAS_RESAMPLER_
+#include "MAS_Platform.h"
+
+#define MAS_PHASE_BITS 16 // fraction bits of the phase
+#define MAS_PHASE_ONE (1ul << MAS_PHASE_BITS)
+#define MAS_PHASE_MASK (MAS_PHASE_ONE - 1)
+
+//-------------------------------------------------------------------------------linear
+static inline int16_t MAS_Linear(int32_t x1, int32_t x2, uint32_t frac) {
+  return x1 + (((x2 - x1) * (int32_t)(frac >> 1)) >> (MAS_PHASE_BITS - 1));
+}//                                                                                 linear
+//--------------------------------------------------------------------------------cubic
+static inline int16_t MAS_Cubic(int32_t x0, int32_t x1, int32_t x2, int32_t x3, uint32_t frac) {
+  float t = frac * (1.0f / MAS_PHASE_ONE);
+  float c1 = 0.5f * (x2 - x0);
+  float c2 = x0 - 2.5f * x1 + 2.0f * x2 - 0.5f * x3;
+  float c3 = 0.5f * (x3 - x0) + 1.5f * (x1 - x2);
+  float y = x1 + t * (c1 + t * (c2 + t * c3));
+  if (y > 32767.0f) {
+    return 32767;
+  }
+  if (y < -32768.0f) {
+    return -32768;
+  }
+  return (int16_t)y;
+}//                                                                                  cubic
+//------------------------------------------------------------------------------------box
+#define MAS_BOX 3 // interpolation mode of MAS_Box
+#define MAS_BOX_BITS 8 // fraction bits of the weights, a box of 255 full scale samples fits 32 bit
+// Mean of the samples from the position frac to frac + step, step > MAS_PHASE_ONE.
+// Sample k after the position is buf[(start + k) & mask], avail >= 1 samples are there,
+// the last one is repeated after them.
+static inline int16_t MAS_Box(const int16_t *buf, uint32_t mask, uint32_t start,
+                              uint32_t avail, uint32_t frac, uint32_t step) {
+  const int shift = MAS_PHASE_BITS - MAS_BOX_BITS;
+  uint32_t end = (frac >> shift) + (step >> shift); // end of the box in samples, Q8
+  uint32_t n = end >> MAS_BOX_BITS;
+  int32_t x = buf[start & mask];
+  int32_t sum = -x * (int32_t)(frac >> shift);
+  for (uint32_t k = 0; k < n; k++) {
+    x = k < avail ? buf[(start + k) & mask] : x;
+    sum += x * (1 << MAS_BOX_BITS);
+  }
+  x = n < avail ? buf[(start + n) & mask] : x;
+  sum += x * (int32_t)(end & ((1 << MAS_BOX_BITS) - 1));
+  return sum / (int32_t)(step >> shift);
+}//                                                                                    box
+//--------------------------------------------------------------------------interpolate
+// mode 0 = NONE, 1 = LINEAR, 2 = CUBIC, MAS_BOX = LINEAR (the box is taken by the caller)
+static inline int16_t MAS_Interpolate(uint8_t mode, int32_t x0, int32_t x1, int32_t x2,
+                                      int32_t x3, uint32_t frac) {
+  switch (mode) {
+    case 0:
+      return x1;
+    case 2:
+      return MAS_Cubic(x0, x1, x2, x3, frac);
+    default:
+      return MAS_Linear(x1, x2, frac);
+  }
+}//                                                                            interpolate
+#endif